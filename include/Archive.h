@@ -0,0 +1,95 @@
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+#include "MappedFile.h"
+#include "Pgn.h"
+
+// Binary game storage, each move is stored as its index in the legal move list
+// Replaying regenerates the list, which is always in the same order for the same position
+namespace Archive {
+    // Returns the ARCHIVE_RESULT code of a PGN result, ARCHIVE_RESULT_NONE if it is unknown
+    FLAG resultCode(const std::string& result);
+
+    // Returns the PGN result of an ARCHIVE_RESULT code
+    std::string resultString(FLAG code);
+
+    // Appends the encoded game to data, returns false if a move is not legal or the game is too long
+    bool encode(const GAME& game, std::vector<unsigned char>& data);
+
+    // Decodes one game, returns false if the data is cut short or a move index is not legal
+    // Only the Result tag and the FEN tag of games with a start position are restored
+    // Stops after maxMoves moves when it is above 0
+    bool decode(const unsigned char* data, size_t size, GAME& game, size_t maxMoves = 0);
+
+    // Returns if the file starts with ARCHIVE_MAGIC
+    bool isArchive(const std::string& path);
+
+    // Calls onGame for every game in a PGN file or game archive, games are numbered from 0 in file order
+    // Games are split across threads, thread is the worker's number from 0 so each can keep its own results
+    // Archive games are only decoded up to maxMoves moves when it is above 0
+    bool forEachGame(const std::string& path, int threads, size_t maxMoves, const std::function<void(const GAME&, size_t, int)>& onGame);
+}
+
+// Writes games to an archive, the index of game offsets is written when closed
+class ArchiveWriter {
+private:
+    std::ofstream m_file;
+    std::vector<unsigned long long> m_offsets;
+    unsigned long long m_position;
+
+public:
+    // ----- Creation -----
+
+    ArchiveWriter();
+
+    // Creates the archive, replacing any file at path
+    bool open(const std::string& path);
+
+    // ----- Update -----
+
+    // Adds a game, returns false if it cannot be encoded
+    bool add(const GAME& game);
+
+    // Adds a game already made with Archive::encode
+    void addEncoded(const std::vector<unsigned char>& data);
+
+    // ----- Destruction -----
+
+    // Writes the index and header, returns false if the file could not be written
+    bool close();
+
+    ~ArchiveWriter();
+};
+
+// Reads games from a memory mapped archive by game number
+class ArchiveReader {
+private:
+    MappedFile m_file;
+    unsigned long long m_count;
+    const unsigned char* m_index;
+
+public:
+    // ----- Creation -----
+
+    ArchiveReader();
+
+    // Maps the archive, returns false if it is not one
+    bool open(const std::string& path);
+
+    // ----- Read -----
+
+    // Returns the number of games in the archive
+    size_t Count() const;
+
+    // Decodes the game at the index, returns false if it is out of range or invalid
+    // Stops after maxMoves moves when it is above 0
+    bool getGame(size_t index, GAME& game, size_t maxMoves = 0) const;
+
+    // Returns the encoded bytes of the game at the index
+    const unsigned char* gameData(size_t index, size_t& size) const;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Defines.h"
+
+// Attack sets for the stepping pieces and ray lengths for sliding pieces, generated at compile time
+// Each table holds a bitboard of attacked squares per start index
+namespace Attacks {
+    typedef struct attackTable {
+        BITBOARD squares[GRID_SIZE * GRID_SIZE];
+    } ATTACK_TABLE;
+
+    // Squares until the edge of the board for each index and ray direction
+    typedef struct rayTable {
+        INDEX length[GRID_SIZE * GRID_SIZE][ATTACKS_RAYS];
+    } RAY_TABLE;
+
+    // ----- Table ----- Generation -----
+
+    // Builds a table from (file, rank) steps, dropping any step that leaves the board
+    template <int COUNT>
+    constexpr ATTACK_TABLE generate(const int (&steps)[COUNT][2]) {
+        ATTACK_TABLE table = {};
+        for (int index = 0; index < GRID_SIZE * GRID_SIZE; index++) {
+            for (int i = 0; i < COUNT; i++) {
+                int x = (index % GRID_SIZE) + steps[i][0];
+                int y = (index / GRID_SIZE) + steps[i][1];
+                if (0 <= x && x < GRID_SIZE && 0 <= y && y < GRID_SIZE) {
+                    table.squares[index] |= BITBOARD_INDEX(y * GRID_SIZE + x);
+                }
+            }
+        }
+        return table;
+    }
+
+    // Builds the number of squares each ray can travel before leaving the board
+    template <int COUNT>
+    constexpr RAY_TABLE generateRays(const int (&steps)[COUNT][2]) {
+        RAY_TABLE table = {};
+        for (int index = 0; index < GRID_SIZE * GRID_SIZE; index++) {
+            for (int i = 0; i < COUNT; i++) {
+                int x = (index % GRID_SIZE) + steps[i][0];
+                int y = (index / GRID_SIZE) + steps[i][1];
+                while (0 <= x && x < GRID_SIZE && 0 <= y && y < GRID_SIZE) {
+                    table.length[index][i]++;
+                    x += steps[i][0];
+                    y += steps[i][1];
+                }
+            }
+        }
+        return table;
+    }
+
+    // Cardinal rays first, then diagonal rays
+    constexpr int raySteps[ATTACKS_RAYS][2] = { {0, 1}, {1, 0}, {0, -1}, {-1, 0}, {1, 1}, {1, -1}, {-1, -1}, {-1, 1} };
+    constexpr INDEX rayOffsets[ATTACKS_RAYS] = {
+        GRID_SIZE, 1, -GRID_SIZE, -1,
+        GRID_SIZE + 1, -GRID_SIZE + 1, -GRID_SIZE - 1, GRID_SIZE - 1
+    };
+
+    constexpr int knightSteps[8][2]     = { {-1, 2}, {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1} };
+    constexpr int kingSteps[8][2]       = { {-1, 1}, {0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0} };
+    constexpr int whitePawnSteps[2][2]  = { {-1, 1}, {1, 1} };
+    constexpr int blackPawnSteps[2][2]  = { {-1, -1}, {1, -1} };
+
+    // ----- Tables -----
+
+    inline constexpr ATTACK_TABLE knight    = generate(knightSteps);
+    inline constexpr ATTACK_TABLE king      = generate(kingSteps);
+    inline constexpr ATTACK_TABLE whitePawn = generate(whitePawnSteps);
+    inline constexpr ATTACK_TABLE blackPawn = generate(blackPawnSteps);
+    inline constexpr RAY_TABLE    rays      = generateRays(raySteps);
+
+    // ----- Read -----
+
+    // Returns the squares a pawn of the given colour attacks from index
+    inline BITBOARD pawn(FLAG colour, INDEX index) {
+        return (colour == PIECE_WHITE ? whitePawn.squares[index] : blackPawn.squares[index]);
+    }
+
+    // Returns a bitboard of every piece of the given colour attacking index
+    // Works backwards from the square instead of generating the colour's moves
+    BITBOARD attackersTo(INDEX index, FLAG colour, const PIECE* grid);
+
+    // Returns if any piece of the given colour attacks index
+    // Stops at the first attacker found
+    bool isSquareAttacked(INDEX index, FLAG colour, const PIECE* grid);
+
+    // Removes the lowest set bit from the bitboard and returns its index
+    inline INDEX popLowest(BITBOARD& bitboard) {
+        INDEX index = __builtin_ctzll(bitboard);
+        bitboard &= bitboard - 1;
+        return index;
+    }
+}
@@ -1,10 +1,23 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "RenderManager.h"
 #include "MoveManager.h"
+#include "PositionIndex.h"
+#include "Book.h"
+#include "Tablebase.h"
+#include "DtmTablebase.h"
+#include "Nnue.h"
+#include "Mcts.h"
+#include "MateSolver.h"
+#include "Search.h"
 #include "Defines.h"
 #include "Player.h"
 
@@ -21,25 +34,51 @@ private:
     // Reset FEN
     std::string m_resetFEN;
 
+    // Games reaching the current position are looked up here, if the index file exists
+    PositionIndex m_positionIndex;
+
+    // Computer players play from this book while the position is in it, if the book file exists
+    Book m_book;
+
+    // Endgames are played and adjudicated from these, if the tablebase directory exists
+    Tablebase m_tablebase;
+    // Distance to mate tables made with tbgen, used where the tablebases have no table
+    DtmTablebase m_dtm;
+
+    // Evaluates the board, if the network file exists
+    // The accumulator is updated with every move played so evaluating only runs the small layers
+    Nnue m_network;
+    NNUE_ACCUMULATOR m_accumulator;
+
+    // Looks for forced mates in the current position, its table is kept between positions
+    // Solves run in the background from a copy of the position, the result is printed once a frame finds it ready
+    MateSolver m_mateSolver;
+    POSITION m_matePosition;
+    std::future<MATE_RESULT> m_mateSearch;
+
     // Store pieces and their information
     PIECE m_grid[GRID_SIZE * GRID_SIZE];
     INDEX m_heldPieceIndex;
-    INDEX m_phantomLocation, m_phantomAttack;
+    // Target squares of the held piece, calculated once when picked up
+    BITBOARD m_heldTargets;
     std::vector<INDEX> m_validMoves;
     INDEX m_whiteKing, m_blackKing;
 
     // Pawn promotion data
+    // Promotion move waits here until a piece is selected
     INDEX m_promotionIndex;
+    Move m_promotionMove;
 
-    // Castling data
-    bool m_castling[4];
-    
     // Stores move data
     int m_totalTurns, m_50moveRule;
+    // Moves played since the reset FEN
+    std::vector<Move> m_history;
     // Stores if game is checkmate
     bool m_checkmate;
     // Stores if game is in stalemate
     bool m_stalemate;
+    // ARCHIVE_RESULT of a game ended early by the tablebases, ARCHIVE_RESULT_NONE while it goes on
+    FLAG m_adjudication;
 
     // Stores colours for rendering values
     COLOUR m_dark, m_light;
@@ -52,6 +91,26 @@ private:
     Player m_whitePlayer, m_blackPlayer;
     Player* m_currentPlayer;
 
+    // Computer players search with this out of book when it is on, the tree is kept from move to move
+    // Searches run in the background from a copy of the position so the board keeps rendering
+    Mcts m_mcts;
+    bool m_useMcts;
+    POSITION m_botPosition;
+    std::future<SEARCH_RESULT> m_botSearch;
+
+    // Analysis searches the position on its own thread until it changes, its hash table is kept between positions
+    // The search only hands over lines when a depth finishes, the board takes a copy once a frame to draw
+    std::unique_ptr<Search> m_analysis;
+    std::thread m_analysisThread;
+    std::atomic<bool> m_analysisStop;
+    std::mutex m_analysisMutex;
+    std::vector<SEARCH_LINE> m_analysisLines;
+    int m_analysisDepth;
+    POSITION m_analysisPosition;
+    bool m_analysing;
+    // Depth last printed, lines are printed again once a deeper one finishes
+    int m_shownDepth;
+
 
 
     // ----- Read -----
@@ -62,15 +121,22 @@ private:
     // Checks if last move is checkmate
     void checkCheckmate(Move& move);
 
-    // ----- Update -----
+    // Ends games between computers once the tablebases know the result
+    void checkTablebase();
+
+    // Returns the board as a position, without the held piece flag
+    POSITION currentPosition();
 
-    // Sets metadata for board upon loading
-    void readMetadata(std::string& metadata);
+    // Draws the best lines as arrows and the evaluation bar, printing the lines when a deeper search finishes
+    void showAnalysis();
 
-    // Adds the metadata from FEN string to board
-    void setMetadata();
+    // Prints the mate search result once it finishes
+    void printMate();
+
+    // ----- Update -----
 
     // Determines which option was selected from the promotion screen
+    // Plays the promotion with that piece, anything else cancels it
     void promotionSelection(INDEX index);
 
     // Grabs a piece and holds it
@@ -79,8 +145,14 @@ private:
     // Releases the piece
     void release(Move& move);
 
-    // Deals with phantom piece
-    void managePhantom(Move move);
+    // Passes the turn to the other player
+    void nextTurn();
+
+    // Starts analysing the current position in the background
+    void startAnalysis();
+
+    // Stops the background search and waits for it to finish
+    void stopAnalysis();
 
 public:
     // ----- Creation -----
@@ -116,15 +188,42 @@ public:
     // Clears everything off of board
     void clearBoard();
 
-    // Sets an index where pawn promoted
-    void setPromotion(INDEX index);
-
     // Allows changing of board flip state on the fly
     void changeFlip();
 
     // Allows user to force perspective change
     void changePerspective();
 
+    // Writes the game so far to a PGN file
+    bool saveGame(const std::string& path = gameFile);
+
+    // Loads the first game in a PGN file and plays through its moves
+    bool loadGame(const std::string& path = gameFile);
+
+    // Prints the indexed games that reached the current position
+    void showGames();
+
+    // Prints the book moves for the current position
+    void showBook();
+
+    // Prints the network's evaluation of the current position
+    void showEvaluation();
+
+    // Starts looking for the shortest mate by checks for the side to move within MATE_MOVES, printed when found
+    void showMate();
+
+    // Plays a move for the current player if it is a computer
+    void playBot();
+
+    // Hands the side to move to the computer, or back to a human
+    void toggleBot();
+
+    // Switches the computer between random moves and Mcts out of book
+    void toggleMcts();
+
+    // Turns analysis of the position on the board on or off
+    void toggleAnalysis();
+
     // ----- Destruction -----
 
     // Frees all of the boards variables
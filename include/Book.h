@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+#include "MappedFile.h"
+#include "Move.h"
+#include "Zobrist.h"
+
+typedef struct bookMoveHolder {
+    Move move;
+    int weight;
+} BOOK_MOVE;
+
+// Polyglot opening book, memory mapped and binary searched by position key
+// Entries are never parsed up front, so opening a book costs nothing no matter its size
+class Book {
+private:
+    MappedFile m_file;
+    const unsigned char* m_entries;
+    size_t m_count;
+
+    // Keys used to hash positions, polyglot's own unless the book was opened with others
+    Zobrist::KEY_TABLE m_keys;
+
+public:
+    // ----- Creation -----
+
+    Book();
+
+    // Maps the book, returns false if it cannot be opened or is not a whole number of entries
+    // Standard books are keyed with polyglot's keys, other keys are only for books built with them
+    bool open(const std::string& path, const Zobrist::KEY_TABLE& keys = Zobrist::polyglotKeys);
+
+    // Reads a table of ZOBRIST_KEYS hex numbers, such as polyglot's Random64 array
+    // Anything that is not a 16 digit hex number is skipped
+    static bool loadKeys(const std::string& path, Zobrist::KEY_TABLE& keys);
+
+    // Builds a polyglot book from every game in a PGN file or game archive, keyed with keys
+    // Each thread counts (position, move) pairs in its own table, writing it out as a sorted run every BOOK_BUILD_RUN_PAIRS pairs
+    // Runs are merged straight into the book and removed, so memory is bounded by the threads whatever the number of games
+    // Positions after maxPly and moves played in fewer than minGames games are left out, games with no result are skipped
+    static bool build(const std::string& input, const std::string& output, const Zobrist::KEY_TABLE& keys, int threads,
+        int maxPly = BOOK_BUILD_PLY, int minGames = BOOK_BUILD_MIN_GAMES);
+
+    // ----- Read -----
+
+    bool isOpen() const;
+
+    // Returns the number of entries in the book
+    size_t Count() const;
+
+    // Returns the key of the position in the book
+    HASH getKey(FLAG colour, const PIECE* grid) const;
+
+    // Returns every legal book move for the position, in book order
+    std::vector<BOOK_MOVE> getMoves(FLAG colour, const PIECE* grid) const;
+
+    // Returns a book move picked at random by weight, or a move that is not isMove() if the position is not in the book
+    Move pickMove(FLAG colour, const PIECE* grid) const;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Book.h"
+#include "DtmTablebase.h"
+#include "Tablebase.h"
+#include "Defines.h"
+#include "Move.h"
+
+// Picks moves for computer players
+namespace Bot {
+    // Returns the tablebase move, then the generated tables' move, then a book move, or a move that is not isMove() if none know the position
+    Move knownMove(FLAG colour, const PIECE* grid, const Book* book = nullptr, const Tablebase* tablebase = nullptr, int halfmoves = 0, const DtmTablebase* dtm = nullptr);
+
+    // Returns the tablebase move if the position is in the tablebases or generated tables, then a book move if it is in the book
+    // Otherwise returns a random legal move, or a move that is not isMove() if there are none
+    // halfmoves is the 50 move rule counter, used to pick tablebase moves that still win in time
+    Move chooseMove(FLAG colour, const PIECE* grid, const Book* book = nullptr, const Tablebase* tablebase = nullptr, int halfmoves = 0, const DtmTablebase* dtm = nullptr);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Runs commands given on the command line without opening a window
+namespace Console {
+    // Runs the command in argv[1] with the rest of the arguments
+    // Returns the exit code for the program
+    int run(int argc, char** argv);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+#include "DtmTablebase.h"
+#include "Nnue.h"
+#include "Packed.h"
+#include "Search.h"
+#include "Tablebase.h"
+
+typedef struct datagenSettingsHolder {
+    long long games;
+    // Limits of the search for every move
+    SEARCH_LIMITS limits;
+    // Random moves played from the start position before searching, so games differ
+    int randomPlies;
+    int threads;
+    // Game i plays its random moves from seed + i, so runs can be repeated
+    unsigned long long seed;
+} DATAGEN_SETTINGS;
+
+// Returns the move to play in the position, given the hashes of the positions before it
+typedef std::function<SEARCH_RESULT(const POSITION&, const std::vector<HASH>&)> DATAGEN_PLAYER;
+
+// Plays self play games and stores their positions with search scores and results for training evaluations
+// Games are played on every thread, finished games are handed to one writer thread so the searches never wait on the disk
+namespace Datagen {
+    // Appends a record for each quiet position of every game to the file
+    // Evaluates with the network if it is loaded, games reaching the tablebases are adjudicated the same way as on the board
+    // Returns false if the file cannot be written
+    bool run(const std::string& path, const DATAGEN_SETTINGS& settings, const Nnue* network = nullptr,
+        const Tablebase* tablebase = nullptr, const DtmTablebase* dtm = nullptr);
+
+    // Reads a record back into the position, its score for the side to move and the game's ARCHIVE_RESULT
+    bool read(const PACKED_POSITION& record, POSITION& position, int& score, FLAG& result);
+
+    // Loads the start position and plays plies random moves from seed, retrying until the game has not ended
+    void playOpening(unsigned long long seed, int plies, POSITION& position, std::vector<HASH>& history);
+
+    // Plays the game on from the position, white's moves searched by white and black's by black, which may be the same search
+    // Appends a record for each quiet position if records is given, returns the ARCHIVE_RESULT
+    FLAG playGame(Search& white, Search& black, POSITION& position, std::vector<HASH>& history, const SEARCH_LIMITS& limits,
+        const Tablebase* tablebase = nullptr, const DtmTablebase* dtm = nullptr, std::vector<PACKED_POSITION>* records = nullptr);
+
+    // Same as above with each side's moves picked by any player, such as a search other than Search
+    FLAG playGame(const DATAGEN_PLAYER& white, const DATAGEN_PLAYER& black, POSITION& position, std::vector<HASH>& history,
+        const Tablebase* tablebase = nullptr, const DtmTablebase* dtm = nullptr, std::vector<PACKED_POSITION>* records = nullptr);
+}
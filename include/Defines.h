@@ -40,6 +40,10 @@ typedef unsigned short PIECE;
 typedef unsigned short FLAG;
 // Stores indexes for indexing grids
 typedef short INDEX;
+// Stores one bit per grid index, bit 0 is the bottom left square
+typedef unsigned long long BITBOARD;
+// Stores a zobrist key of a position
+typedef unsigned long long HASH;
 
 #define PIECE_INVALID           0x0
 #define PIECE_PAWN              0x1
@@ -69,6 +73,17 @@ typedef short INDEX;
 
 
 
+// ----- Bitboard Defines -----
+
+#define BITBOARD_EMPTY          0x0ULL
+#define BITBOARD_INDEX(index)   (1ULL << (index))
+
+#define ATTACKS_RAYS            8
+#define ATTACKS_CARDINAL_FIRST  0
+#define ATTACKS_DIAGONAL_FIRST  4
+
+
+
 // ----- Board Defines -----
 
 #define BOARD_BLACK_WHITE           0x30
@@ -87,29 +102,382 @@ constexpr char testFEN2[]    = "8/PPPPPPPP/pppppppp/8/8/PPPPPPPP/pppppppp/8 w -
 
 constexpr char startFEN[]   = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+// Where the board saves and loads its game
+constexpr char gameFile[]   = "game.pgn";
+
+
+
+// ----- Hash Defines -----
+
+// Keys are laid out the same as polyglot opening books
+// 12 pieces for each square, then castling, en passant files and white to move
+#define ZOBRIST_KEYS            781
+#define ZOBRIST_CASTLING        768
+#define ZOBRIST_EN_PASSANT      772
+#define ZOBRIST_TURN            780
+
+// Perft table size used when none is given
+#define PERFT_HASH_MEGABYTES    128
+
+
+
+// ----- Packed Defines -----
+
+// Occupancy, 32 piece codes, then side, castling, en passant and clocks
+#define PACKED_SIZE             32
+#define PACKED_OCCUPANCY        0
+#define PACKED_PIECES           8
+#define PACKED_STATE            24
+#define PACKED_EN_PASSANT       25
+#define PACKED_HALFMOVES        26
+#define PACKED_FULLMOVES        27
+#define PACKED_MAX_PIECES       32
+#define PACKED_NO_EN_PASSANT    0xFF
+
+
+
+// ----- PGN Defines -----
+
+// Bytes read from a PGN file at a time, games in each block are parsed together
+#define PGN_BLOCK_SIZE          (16 << 20)
+// Movetext is wrapped before this many characters
+#define PGN_LINE_LENGTH         80
+
+
+
+// ----- Archive Defines -----
+
+// File header is magic, version, game count and index offset
+// Each game is a state byte, a 16 bit move count, an optional packed start position, then one byte per move
+#define ARCHIVE_MAGIC           "CEGA"
+#define ARCHIVE_VERSION         1
+#define ARCHIVE_HEADER_SIZE     24
+#define ARCHIVE_GAME_SIZE       3
+#define ARCHIVE_MAX_MOVES       0xFFFF
+// PGN games are handed to threads this many at a time
+#define ARCHIVE_BATCH_SIZE      4096
+
+#define ARCHIVE_RESULT_NONE     0x0
+#define ARCHIVE_RESULT_WHITE    0x1
+#define ARCHIVE_RESULT_BLACK    0x2
+#define ARCHIVE_RESULT_DRAW     0x3
+#define MASK_ARCHIVE_RESULT     0x3
+#define ARCHIVE_HAS_POSITION    0x4
+
+
+
+// ----- Position Index Defines -----
+
+// Header is magic, version and entry count, sorted entries follow
+#define POSITION_INDEX_MAGIC        "CEPI"
+#define POSITION_INDEX_VERSION      1
+#define POSITION_INDEX_HEADER_SIZE  16
+// Move of the last position in a game, nothing was played from it
+#define POSITION_INDEX_NO_MOVE      0xFF
+
+// Where the board looks for its position index
+constexpr char indexFile[]  = "games.idx";
+
+
+
+// ----- Book Defines -----
+
+// Polyglot entries are a 64 bit key, 16 bit move, 16 bit weight and 32 bit learn value, all big endian
+#define BOOK_ENTRY_SIZE         16
+// Move bits hold the target square, start square and promotion piece from knight as 1
+#define MASK_BOOK_TARGET        0x003F
+#define MASK_BOOK_START         0x0FC0
+#define MASK_BOOK_PROMOTION     0x7000
+// Weights are the side to move's score in half points, scaled down per position to fit 16 bits
+#define BOOK_MAX_WEIGHT         0xFFFF
+
+// Book building leaves out positions after this ply and moves played in fewer games than this
+#define BOOK_BUILD_PLY          30
+#define BOOK_BUILD_MIN_GAMES    3
+// Pairs each thread counts in memory before writing them to a sorted run on disk next to the output
+// Building needs about 100 bytes per pair for each thread, whatever the size of the games or the book
+#define BOOK_BUILD_RUN_PAIRS    (1 << 20)
+
+// Where the board looks for its opening book
+constexpr char bookFile[]           = "book.bin";
+
+
+
+// ----- Tablebase Defines -----
+
+// Syzygy tables go up to 7 pieces, kings included
+#define TABLEBASE_MAX_PIECES        7
+
+// Win, draw and loss from the side to move's view
+// Cursed wins and blessed losses are only wins and losses without the 50 move rule
+#define TABLEBASE_LOSS              -2
+#define TABLEBASE_BLESSED_LOSS      -1
+#define TABLEBASE_DRAW              0
+#define TABLEBASE_CURSED_WIN        1
+#define TABLEBASE_WIN               2
+
+// Table flags stored in each file
+#define TABLEBASE_FLAG_STM          0x01
+#define TABLEBASE_FLAG_MAPPED       0x02
+#define TABLEBASE_FLAG_WIN_PLIES    0x04
+#define TABLEBASE_FLAG_LOSS_PLIES   0x08
+#define TABLEBASE_FLAG_WIDE         0x10
+#define TABLEBASE_FLAG_SINGLE_VALUE 0x80
+
+// Outcome of probing a single table
+#define TABLEBASE_PROBE_OK          0
+#define TABLEBASE_PROBE_FAIL        1
+// Best move resets the 50 move counter so DTZ cannot be read from the table
+#define TABLEBASE_PROBE_ZEROING     2
+// DTZ tables only store one side to move, the other needs a search
+#define TABLEBASE_PROBE_CHANGE_STM  3
+
+// Directories holding .rtbw and .rtbz files, separated by ':' or ';' on Windows
+constexpr char tablebasePath[] = "syzygy";
+
+// Whether the board, datagen and spsa play endgames and adjudicate games from Syzygy tables
+// Off until tbcheck passes for KQvK, KRvK and KPvK against real Syzygy files, probe and tbcheck still read them
+#define TABLEBASE_PLAY              0
+
+
+
+// ----- DTM Defines -----
+
+// Generated distance to mate tables go up to 5 pieces, kings included
+#define DTM_MAX_PIECES          5
+
+// Header is magic, version, entry count, entries per block and block count
+// Block offsets follow, then each block of entries run length encoded as value and run length minus one
+#define DTM_MAGIC               "CEDM"
+#define DTM_VERSION             1
+#define DTM_HEADER_SIZE         24
+#define DTM_BLOCK_SIZE          1024
+
+// Entries hold plies to mate plus one, odd plies are wins for the side to move and even plies losses
+#define DTM_DRAW                0
+#define DTM_INVALID             0xFF
+#define DTM_MAX_PLIES           253
+
+// Where generated tables are written and looked for
+constexpr char dtmPath[]        = "tables";
+constexpr char dtmExtension[]   = ".cedm";
+
+
+
+// ----- NNUE Defines -----
+
+// Inputs are each piece type and colour on each square, seen from both sides with their own pieces first
+#define NNUE_FEATURES           768
+#define NNUE_ACCUMULATOR_SIZE   256
+#define NNUE_HIDDEN_SIZE        32
+
+// Activations are clipped to 0 to NNUE_ACTIVATION_MAX, dense layer weights are scaled up by 1 << NNUE_WEIGHT_SHIFT
+#define NNUE_ACTIVATION_MAX     127
+#define NNUE_WEIGHT_SHIFT       6
+// Centipawns for an output of one
+#define NNUE_OUTPUT_SCALE       400
+
+// Header is magic, version, accumulator size and hidden size, all weights follow as little endian numbers
+#define NNUE_MAGIC              "CENN"
+#define NNUE_VERSION            1
+#define NNUE_HEADER_SIZE        16
+
+// Plies of the game played to time evaluations
+#define NNUE_BENCH_PLIES        200
+
+// Positions whose dense layers run together, a multiple of 16
+#define NNUE_BATCH_BLOCK        64
+// Positions converted and scored at once when scoring a file, bounding the memory used
+#define NNUE_BATCH_SIZE         65536
+
+// Where the board looks for its network
+constexpr char networkFile[]    = "network.nnue";
+
+
+
+// ----- Evaluation Defines -----
+
+// Phase of a position with every piece on the board, minor pieces count 1, rooks 2 and queens 4
+// Scores blend from middlegame weights at EVALUATION_PHASE_MAX to endgame weights at 0
+#define EVALUATION_PHASE_MAX    24
+
+
+
+// ----- Search Defines -----
+
+#define SEARCH_MAX_PLY          128
+#define SEARCH_MAX_DEPTH        64
+#define SEARCH_INFINITE         32001
+// Mate scores count down by one for each ply to the mate
+#define SEARCH_MATE             32000
+#define SEARCH_MATE_BOUND       (SEARCH_MATE - SEARCH_MAX_PLY)
+#define SEARCH_HASH_MEGABYTES   16
+// Nodes searched between reads of the clock under a time limit
+#define SEARCH_TIME_NODES       1024
+
+// Null move is tried from this depth with this reduction
+#define SEARCH_NULL_DEPTH       3
+#define SEARCH_NULL_REDUCTION   2
+// Quiet moves after the first few are searched shallower from this depth
+#define SEARCH_LMR_DEPTH        3
+#define SEARCH_LMR_MOVES        4
+#define SEARCH_LMR_REDUCTION    1
+// Quiet moves at depth 1 are skipped when the evaluation is this far below alpha
+#define SEARCH_FUTILITY_MARGIN  150
+// Captures in quiescence are skipped when even winning the piece is this far below alpha
+#define SEARCH_DELTA_MARGIN     200
+
+#define SEARCH_BOUND_EXACT      0
+#define SEARCH_BOUND_LOWER      1
+#define SEARCH_BOUND_UPPER      2
+
+
+
+// ----- Mcts Defines -----
+
+// Results are fixed point so they can be added atomically, a win is worth MCTS_VALUE_SCALE
+#define MCTS_VALUE_SCALE        1000
+#define MCTS_EXPLORATION        1.4
+// Visits added to each node on the way down and taken off again with the result
+#define MCTS_VIRTUAL_LOSS       3
+// Playouts stop here and take the evaluation's winning chance instead
+#define MCTS_PLAYOUT_PLIES      64
+// Tree stops growing at this many nodes, pools hand them out in blocks
+#define MCTS_MAX_NODES          (1 << 21)
+#define MCTS_POOL_BLOCK         65536
+// Playouts with no limit given, and between reads of the clock under a time limit
+#define MCTS_PLAYOUTS           100000
+#define MCTS_TIME_PLAYOUTS      16
+// Time the bot thinks for each move
+#define MCTS_BOT_MILLISECONDS   1000
+
+#define MCTS_NODE_LEAF          0
+#define MCTS_NODE_EXPANDING     1
+#define MCTS_NODE_EXPANDED      2
+
+
+
+// ----- Mate Defines -----
+
+// Proof and disproof numbers of settled nodes, every sum is capped below it
+#define MATE_INFINITE           (1 << 28)
+#define MATE_HASH_MEGABYTES     64
+// Longest mate looked for, and the default
+#define MATE_MAX_MOVES          64
+#define MATE_MOVES              5
+// Nodes looked at before giving up, from the command line and from the board
+#define MATE_NODES              10000000
+#define MATE_BOARD_NODES        2000000
+
+#define MATE_FOUND              0
+#define MATE_NONE               1
+#define MATE_UNKNOWN            2
+
+
+
+// ----- Analysis Defines -----
+
+// Best lines searched and drawn as arrows while analysing on the board
+#define ANALYSIS_LINES          3
+// Centipawns that make one side ten times as likely to win as the other on the evaluation bar
+#define ANALYSIS_BAR_SCALE      400
+
+
+
+// ----- Datagen Defines -----
+
+// Each record is a packed position with the search score for the side to move in bytes 29-30, least significant byte first
+// and the game's ARCHIVE_RESULT in byte 31
+#define DATAGEN_SCORE           29
+#define DATAGEN_RESULT          31
+
+#define DATAGEN_RANDOM_PLIES    8
+#define DATAGEN_DEPTH           6
+// Games are drawn after this many plies
+#define DATAGEN_MAX_PLIES       400
+// Finished games waiting for the writer, workers wait when it falls this far behind
+#define DATAGEN_QUEUE_GAMES     1024
+// Bytes buffered before each write to the file
+#define DATAGEN_BUFFER_SIZE     (1 << 20)
+
+
+
+// ----- Tune Defines -----
+
+// Weights of each stage, material for each piece type then a square table for each
+#define TUNE_WEIGHTS            (6 + 6 * GRID_SIZE * GRID_SIZE)
+#define TUNE_EPOCHS             200
+// Adam step size in centipawns and its moment decay rates
+#define TUNE_RATE               1.0
+#define TUNE_BETA1              0.9
+#define TUNE_BETA2              0.999
+// Positions each thread takes at a time
+#define TUNE_BLOCK_SIZE         65536
+
+// Where tune writes the weights, copy it over include/EvaluationWeights.h and rebuild to use them
+constexpr char tuneFile[]       = "EvaluationWeights.h";
+
+
+
+// ----- Spsa Defines -----
+
+#define SPSA_ITERATIONS         1000
+#define SPSA_PAIRS              8
+#define SPSA_NODES              2000
+#define SPSA_RANDOM_PLIES       8
+#define SPSA_RATE               4.0
+// Decay of the step size and of the perturbations over the iterations
+#define SPSA_ALPHA              0.602
+#define SPSA_GAMMA              0.101
+
+
+
+// ----- Generation Defines -----
+
+// Stores every move, even ones leaving the king attacked
+#define GENERATE_VALID          0
+// Stores legal moves only
+#define GENERATE_LEGAL          1
+// Stops at the first legal move
+#define GENERATE_ANY            2
+// Counts legal moves without storing them
+#define GENERATE_COUNT          3
+// Stores legal moves that give check
+#define GENERATE_CHECKS         4
+// Stores legal moves out of check, only king moves and moves onto the checking line are tested
+#define GENERATE_EVASIONS       5
+
 
 
 // ----- Move Defines -----
 
 #define MOVE_CONTINUE           1
 #define MOVE_END                2
-#define MOVE_CAPTURE_KING       3
-
-#define MOVE_KING_CAPTURED      true
-#define MOVE_KING_NOT_CAPTURED  false
 
 #define MASK_MOVE_START         0b0000000000111111
 #define MASK_MOVE_TARGET        0b0000111111000000
-#define MASK_MOVE_FLAGS         0b1111000000000000
-
-// Piece specific move masks
-
-#define MOVE_PAWN_FIRST_MOVE    0b0001000000000000
-#define MOVE_PAWN_MOVE_TWO      0b0010000000000000
-#define MOVE_PAWN_ATTACK        0b0100000000000000
-#define MOVE_KING_CASTLE_KING   0b0001000000000000
-#define MOVE_KING_CASTLE_QUEEN  0b0010000000000000
-#define MOVE_KING_CASTLING      (MOVE_KING_CASTLE_KING | MOVE_KING_CASTLE_QUEEN)
-#define MOVE_ROOK_CAN_CASTLE    0b0001000000000000
-#define MOVE_CHECK              0b1000000000000000
-
+#define MASK_MOVE_KIND          0b1111000000000000
+#define MASK_MOVE_PROMOTION     0b0011000000000000
+
+// Move kinds, stored in the top four bits of a move
+// Bit 3 marks promotions, bit 2 marks captures, promotions use bits 0-1 for the piece
+
+#define MOVE_QUIET              0b0000000000000000
+#define MOVE_PAWN_MOVE_TWO      0b0001000000000000
+#define MOVE_CASTLE_KING        0b0010000000000000
+#define MOVE_CASTLE_QUEEN       0b0011000000000000
+#define MOVE_CAPTURE            0b0100000000000000
+#define MOVE_EN_PASSANT         0b0101000000000000
+#define MOVE_PROMOTION          0b1000000000000000
+#define MOVE_PROMOTION_KNIGHT   0b1000000000000000
+#define MOVE_PROMOTION_BISHOP   0b1001000000000000
+#define MOVE_PROMOTION_ROOK     0b1010000000000000
+#define MOVE_PROMOTION_QUEEN    0b1011000000000000
+
+// Piece specific flags, stored in the flag bits of a piece
+
+#define FLAG_PAWN_FIRST_MOVE    MASK_FLAG_1
+#define FLAG_KING_CASTLE_KING   MASK_FLAG_1
+#define FLAG_KING_CASTLE_QUEEN  MASK_FLAG_2
+#define FLAG_KING_CASTLING      (FLAG_KING_CASTLE_KING | FLAG_KING_CASTLE_QUEEN)
+#define FLAG_ROOK_CAN_CASTLE    MASK_FLAG_1
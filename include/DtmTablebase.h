@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Defines.h"
+#include "Move.h"
+
+// One generated table for a material set, such as KRvK, defined in DtmTablebase.cpp
+struct dtmTableHolder;
+
+// Distance to mate tables generated here by retrograde analysis, so no downloaded files are needed
+// Files are found when opened and memory mapped the first time they are probed
+// Probing only reads shared data, so one DtmTablebase can be used from every thread at once
+class DtmTablebase {
+private:
+    std::vector<std::unique_ptr<dtmTableHolder>> m_tables;
+
+    // Tables by name with white's pieces first, each is stored under both colour orders
+    std::unordered_map<std::string, dtmTableHolder*> m_lookup;
+    int m_maxPieces;
+
+    // ----- Read -----
+
+    // Reads the position straight from its table, en passant is not stored
+    bool probeTable(FLAG colour, const PIECE* grid, int& wdl, int& plies) const;
+
+    // Probes every legal move and keeps the best one for colour
+    bool search(FLAG colour, const PIECE* grid, Move& best, int& wdl, int& plies) const;
+
+public:
+    // ----- Creation -----
+
+    DtmTablebase();
+
+    // Finds every table in the directory, returns the number found
+    int open(const std::string& directory);
+
+    // Generates the table for material such as KQvKR in directory, after every smaller table its captures and promotions reach
+    // Tables already in the directory are kept, positions are split across threads
+    static bool generate(const std::string& material, const std::string& directory, int threads);
+
+    // ----- Read -----
+
+    // Returns the most pieces, kings included, of any table found, 0 if there are none
+    int MaxPieces() const;
+
+    // Returns if the position has few enough pieces and no castling rights
+    bool canProbe(const PIECE* grid) const;
+
+    // Sets wdl to TABLEBASE_WIN, TABLEBASE_DRAW or TABLEBASE_LOSS for colour to move
+    // plies counts until mate, 0 when drawn or already mated, returns false if the tables needed are missing
+    bool probe(FLAG colour, const PIECE* grid, int& wdl, int& plies) const;
+
+    // Returns the move that mates fastest, keeps the draw or is mated slowest, setting wdl and plies like probe
+    // Returns a move that is not isMove() if the position cannot be probed or has no moves
+    Move bestMove(FLAG colour, const PIECE* grid, int& wdl, int& plies) const;
+
+    // ----- Destruction -----
+
+    ~DtmTablebase();
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Defines.h"
+#include "Position.h"
+
+// Reads EPD files, one position per line followed by optional operations
+namespace Epd {
+    // Returns the four position fields at the start of an EPD line
+    std::string_view positionFields(std::string_view line);
+
+    // Appends every position in the file to positions, in file order
+    // File is memory mapped and split into chunks of lines that are parsed across threads
+    // Lines that fail to parse are reported and skipped, returns false if the file cannot be opened
+    bool load(const std::string& path, std::vector<POSITION>& positions, int threads);
+}
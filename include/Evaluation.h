@@ -0,0 +1,13 @@
+#pragma once
+
+#include "Defines.h"
+
+// Hand written evaluation of material and piece squares, used when there is no network
+// Weights are in EvaluationWeights.h, blended from middlegame to endgame values as pieces come off
+namespace Evaluation {
+    // Returns the phase of the grid, EVALUATION_PHASE_MAX or more with every piece on the board down to 0
+    int phase(const PIECE* grid);
+
+    // Returns the score in centipawns for colour to move
+    int evaluate(FLAG colour, const PIECE* grid);
+}
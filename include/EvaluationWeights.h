@@ -0,0 +1,149 @@
+#pragma once
+
+// Evaluation weights in centipawns, middlegame values first then endgame values
+// Piece types are in PIECE_PAWN to PIECE_KING order, squares in index order from white's side with a1 first
+// Black reads the squares flipped, tune writes a new copy of this file from datagen records
+
+constexpr short evaluationMaterial[2][6] = {
+    { 100, 320, 330, 500, 900, 0 },
+    { 120, 300, 320, 520, 920, 0 },
+};
+
+constexpr short evaluationSquares[2][6][64] = {
+    {
+        // Pawn
+        {
+               0,    0,    0,    0,    0,    0,    0,    0,
+               5,   10,   10,  -20,  -20,   10,   10,    5,
+               5,   -5,  -10,    0,    0,  -10,   -5,    5,
+               0,    0,    0,   20,   20,    0,    0,    0,
+               5,    5,   10,   25,   25,   10,    5,    5,
+              10,   10,   20,   30,   30,   20,   10,   10,
+              50,   50,   50,   50,   50,   50,   50,   50,
+               0,    0,    0,    0,    0,    0,    0,    0,
+        },
+        // Knight
+        {
+             -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+             -40,  -20,    0,    5,    5,    0,  -20,  -40,
+             -30,    5,   10,   15,   15,   10,    5,  -30,
+             -30,    0,   15,   20,   20,   15,    0,  -30,
+             -30,    5,   15,   20,   20,   15,    5,  -30,
+             -30,    0,   10,   15,   15,   10,    0,  -30,
+             -40,  -20,    0,    0,    0,    0,  -20,  -40,
+             -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+        },
+        // Bishop
+        {
+             -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+             -10,    5,    0,    0,    0,    0,    5,  -10,
+             -10,   10,   10,   10,   10,   10,   10,  -10,
+             -10,    0,   10,   10,   10,   10,    0,  -10,
+             -10,    5,    5,   10,   10,    5,    5,  -10,
+             -10,    0,    5,   10,   10,    5,    0,  -10,
+             -10,    0,    0,    0,    0,    0,    0,  -10,
+             -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+        },
+        // Rook
+        {
+               0,    0,    0,    5,    5,    0,    0,    0,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+               5,   10,   10,   10,   10,   10,   10,    5,
+               0,    0,    0,    0,    0,    0,    0,    0,
+        },
+        // Queen
+        {
+             -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+             -10,    0,    5,    0,    0,    0,    0,  -10,
+             -10,    5,    5,    5,    5,    5,    0,  -10,
+               0,    0,    5,    5,    5,    5,    0,   -5,
+              -5,    0,    5,    5,    5,    5,    0,   -5,
+             -10,    0,    5,    5,    5,    5,    0,  -10,
+             -10,    0,    0,    0,    0,    0,    0,  -10,
+             -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+        },
+        // King
+        {
+              20,   30,   10,    0,    0,   10,   30,   20,
+              20,   20,    0,    0,    0,    0,   20,   20,
+             -10,  -20,  -20,  -20,  -20,  -20,  -20,  -10,
+             -20,  -30,  -30,  -40,  -40,  -30,  -30,  -20,
+             -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+             -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+             -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+             -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+        },
+    },
+    {
+        // Pawn
+        {
+               0,    0,    0,    0,    0,    0,    0,    0,
+               5,   10,   10,  -20,  -20,   10,   10,    5,
+               5,   -5,  -10,    0,    0,  -10,   -5,    5,
+               0,    0,    0,   20,   20,    0,    0,    0,
+               5,    5,   10,   25,   25,   10,    5,    5,
+              10,   10,   20,   30,   30,   20,   10,   10,
+              50,   50,   50,   50,   50,   50,   50,   50,
+               0,    0,    0,    0,    0,    0,    0,    0,
+        },
+        // Knight
+        {
+             -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+             -40,  -20,    0,    5,    5,    0,  -20,  -40,
+             -30,    5,   10,   15,   15,   10,    5,  -30,
+             -30,    0,   15,   20,   20,   15,    0,  -30,
+             -30,    5,   15,   20,   20,   15,    5,  -30,
+             -30,    0,   10,   15,   15,   10,    0,  -30,
+             -40,  -20,    0,    0,    0,    0,  -20,  -40,
+             -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+        },
+        // Bishop
+        {
+             -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+             -10,    5,    0,    0,    0,    0,    5,  -10,
+             -10,   10,   10,   10,   10,   10,   10,  -10,
+             -10,    0,   10,   10,   10,   10,    0,  -10,
+             -10,    5,    5,   10,   10,    5,    5,  -10,
+             -10,    0,    5,   10,   10,    5,    0,  -10,
+             -10,    0,    0,    0,    0,    0,    0,  -10,
+             -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+        },
+        // Rook
+        {
+               0,    0,    0,    5,    5,    0,    0,    0,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+              -5,    0,    0,    0,    0,    0,    0,   -5,
+               5,   10,   10,   10,   10,   10,   10,    5,
+               0,    0,    0,    0,    0,    0,    0,    0,
+        },
+        // Queen
+        {
+             -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+             -10,    0,    5,    0,    0,    0,    0,  -10,
+             -10,    5,    5,    5,    5,    5,    0,  -10,
+               0,    0,    5,    5,    5,    5,    0,   -5,
+              -5,    0,    5,    5,    5,    5,    0,   -5,
+             -10,    0,    5,    5,    5,    5,    0,  -10,
+             -10,    0,    0,    0,    0,    0,    0,  -10,
+             -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+        },
+        // King
+        {
+             -50,  -30,  -30,  -30,  -30,  -30,  -30,  -50,
+             -30,  -30,    0,    0,    0,    0,  -30,  -30,
+             -30,  -10,   20,   30,   30,   20,  -10,  -30,
+             -30,  -10,   30,   40,   40,   30,  -10,  -30,
+             -30,  -10,   30,   40,   40,   30,  -10,  -30,
+             -30,  -10,   20,   30,   30,   20,  -10,  -30,
+             -30,  -20,  -10,    0,    0,  -10,  -20,  -30,
+             -50,  -40,  -30,  -20,  -20,  -30,  -40,  -50,
+        },
+    },
+};
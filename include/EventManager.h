@@ -8,8 +8,7 @@
 
 class EventManager {
 private:
-    static bool s_eventClick, s_eventKey, s_eventPromotion;
-    static INDEX s_indexPromotion;
+    static bool s_eventClick, s_eventKey;
     static POINT s_mousePos;
     static int   s_key;
 
@@ -23,9 +22,6 @@ private:
     // Manages key events
     void manageKeyEvents();
 
-    // Manages promotion events
-    void managePromotionEvents();
-
     // Prints all commands to console
     void showHelp();
 
@@ -52,9 +48,6 @@ public:
 
     static void eventKey(int key);
 
-    // Sends a pawn promotion to be managed
-    static void eventPromotion(INDEX index);
-
     // ----- Destruction -----
 
     ~EventManager();    
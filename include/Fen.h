@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "Defines.h"
+#include "Position.h"
+
+// Reads and writes FEN strings
+namespace Fen {
+    // Parses the FEN into the position without copying it, adding castling and first move flags to pieces
+    // Clocks are optional so EPD positions can be read as well
+    // Returns false and describes the problem in error if the FEN is malformed, lacks a king for either side
+    // or leaves the side not to move in check
+    bool parse(std::string_view fen, POSITION& position, std::string& error);
+
+    // Same as parse, prints the error to console
+    bool load(std::string_view fen, POSITION& position);
+
+    // Returns the FEN string of the position
+    std::string toFEN(const POSITION& position);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read only view of a whole file mapped into memory
+// Pages are loaded by the OS as they are touched, nothing is copied
+class MappedFile {
+private:
+    const char* m_data;
+    size_t m_size;
+
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#endif
+
+public:
+    // ----- Creation -----
+
+    MappedFile();
+
+    // Maps the whole file, returns false if it cannot be opened
+    // Empty files open with no data
+    bool open(const std::string& path);
+
+    // ----- Read -----
+
+    const char* Data() const;
+    size_t Size() const;
+    bool isOpen() const;
+
+    // ----- Destruction -----
+
+    // Unmaps the file
+    void close();
+
+    ~MappedFile();
+
+    // Mapping can only have one owner
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "Move.h"
+#include "Position.h"
+
+typedef struct mateResultHolder {
+    // MATE_FOUND, MATE_NONE or MATE_UNKNOWN if the node limit was reached first
+    FLAG status;
+    // Moves of the side to move until mate, the shortest there is when found
+    int moves;
+    // Mating line starting with the side to move, as far as the hash table still holds it
+    std::vector<Move> line;
+    long long nodes;
+} MATE_RESULT;
+
+// Hash table entry, defined in MateSolver.cpp
+struct mateEntryHolder;
+
+// Finds mates for the side to move with depth first proof number search, or proves there is none within a number of moves
+// The attacker only tries checking moves unless told otherwise, so a proof of no mate then only covers mates made of checks
+// The defender is always in check and only tries evasions, which keeps the tree far smaller than a full width search
+class MateSolver {
+private:
+    std::vector<mateEntryHolder> m_table;
+    long long m_nodes, m_nodeLimit;
+    bool m_checksOnly;
+
+    // ----- Read -----
+
+    // Fills in the proof and disproof numbers stored for the node, 1 and 1 if it has not been seen
+    void lookup(HASH hash, bool attacker, int remaining, int& phi, int& delta) const;
+
+    // Returns the moves searched at a node, only checks or every move for the attacker and evasions for the defender
+    std::vector<Move> movesOf(FLAG colour, const PIECE* grid, bool attacker) const;
+
+    // Follows proven moves through the hash table, the defender picking whichever reply needs the most moves to mate
+    void findLine(const POSITION& position, int moves, std::vector<Move>& line) const;
+
+    // ----- Update -----
+
+    void store(HASH hash, bool attacker, int remaining, int phi, int delta);
+
+    // Expands the node until its phi reaches thresholdPhi or its delta reaches thresholdDelta, then stores both
+    // phi is the proof number for the side to move, delta the disproof number, so the attacker's phi is the usual proof number
+    // remaining counts the attacker's moves left, including the one at an attacker node
+    void expand(FLAG colour, const PIECE* grid, bool attacker, int remaining, int thresholdPhi, int thresholdDelta, int& phi, int& delta);
+
+public:
+    // ----- Creation -----
+
+    // Hash table is rounded down to a power of two entries
+    MateSolver(int hashMegabytes = MATE_HASH_MEGABYTES);
+
+    // ----- Update -----
+
+    // Looks for a mate in 1 then in each longer number of moves up to maxMoves, stopping after nodeLimit nodes, 0 for no limit
+    // Stored results are kept between calls, except when checksOnly changes
+    MATE_RESULT solve(const POSITION& position, int maxMoves, long long nodeLimit = 0, bool checksOnly = true);
+
+    // Forgets every stored result
+    void clear();
+
+    // ----- Destruction -----
+
+    ~MateSolver();
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "Defines.h"
+#include "Move.h"
+#include "Position.h"
+#include "Search.h"
+
+// Tree node and per thread node pool, defined in Mcts.cpp
+struct mctsNodeHolder;
+struct mctsPoolHolder;
+
+// Monte Carlo tree search, an alternative to Search for the bot
+// Leaves are scored with random playouts from MoveGen's legal moves, or with Evaluation alone when playouts are off
+// Threads share one tree, each adding a virtual loss to the nodes it passes so the others spread out
+// The tree is kept between searches, the part under the new position is carried over and the rest dropped
+class Mcts {
+private:
+    // Each thread expands nodes from its own pool, carried over trees are copied into the other generation's first pool
+    std::vector<mctsPoolHolder> m_pools[2];
+    int m_generation;
+    std::atomic<long long> m_nodes;
+
+    mctsNodeHolder* m_root;
+    POSITION m_position;
+
+    int m_threads;
+    bool m_playouts;
+
+    std::atomic<long long> m_playoutCount;
+    std::atomic<int> m_depth;
+    std::atomic<bool> m_stopped;
+    long long m_playoutLimit;
+    std::chrono::steady_clock::time_point m_deadline;
+    bool m_timed;
+
+    // ----- Read -----
+
+    // Picks the child with the best upper confidence bound, unvisited children first
+    mctsNodeHolder* select(mctsNodeHolder* node) const;
+
+    // Returns the result for colour to move, MCTS_VALUE_SCALE for a win, of random moves from the grid
+    long long playout(FLAG colour, PIECE* grid, unsigned long long& random) const;
+
+    // ----- Update -----
+
+    // Adds a child for every legal move, returns false if another thread is already expanding the node
+    bool expand(mctsNodeHolder* node, FLAG colour, const PIECE* grid, mctsPoolHolder& pool);
+
+    // Runs playouts until a limit is reached or another thread stops
+    void work(int thread);
+
+    // Moves the root to the position if it is the root or up to two plies below it, otherwise starts a new tree
+    void reuse(const POSITION& position);
+
+public:
+    // ----- Creation -----
+
+    Mcts(int threads = 1, bool playouts = true);
+
+    // ----- Read -----
+
+    // Returns the nodes in the tree
+    long long Nodes() const;
+
+    // ----- Update -----
+
+    // Searches until a limit is reached, depth is ignored and nodes counts playouts
+    // The result's depth is the deepest line in the tree and its nodes the playouts run
+    SEARCH_RESULT search(const POSITION& position, const SEARCH_LIMITS& limits);
+
+    // Drops the tree, as before a new game
+    void clear();
+
+    // ----- Destruction -----
+
+    ~Mcts();
+};
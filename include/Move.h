@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "Defines.h"
@@ -11,7 +12,7 @@ private:
     short m_moveData;
 
 public:
-    Move(INDEX start = -1, INDEX target = 0, FLAG flags = 0);
+    Move(INDEX start = -1, INDEX target = 0, FLAG kind = MOVE_QUIET);
 
     // Returns start index of move
     INDEX Start();
@@ -19,17 +20,29 @@ public:
     // Returns target index (AKA where move is going)
     INDEX Target();
 
-    // Returns flag data
-    FLAG Flags();
-    // Returns specific flag data
-    FLAG Flags(FLAG flag);
+    // Returns the kind of move, such as MOVE_CAPTURE or MOVE_PROMOTION_QUEEN
+    FLAG Kind();
 
-    // Adds a flag to the move
-    void addFlags(FLAG flags);
+    // Replaces the kind of move
+    void setKind(FLAG kind);
+
+    // Returns if the move captures a piece, including en passant
+    bool isCapture();
+
+    // Returns if the move promotes a pawn
+    bool isPromotion();
+
+    // Returns the piece type a pawn promotes to, or PIECE_INVALID if not a promotion
+    FLAG Promotion();
+
+    // Sets the piece type a pawn promotes to, keeping the capture
+    void setPromotion(FLAG type);
 
     // Returns if this move exists or not
     bool isMove();
 
+    // Returns the move in coordinate notation, such as e2e4 or e7e8q
+    std::string toString();
+
     ~Move();
 };
-
@@ -8,56 +8,109 @@
 
 class MoveGen {
 private:
-    static std::vector<Move> s_validMoves, s_legalMoves;
+    // Each thread generates into its own state
+    static thread_local std::vector<Move> s_moves;
+
+    // Position being generated, stored so moves can be checked as they are added
+    static thread_local const PIECE* s_grid;
+    static thread_local FLAG s_colour, s_enemy;
+    static thread_local INDEX s_king;
+
+    // Decides what happens to each generated move, GENERATE_VALID to GENERATE_COUNT
+    static thread_local int s_mode;
+    static thread_local bool s_found;
+
+    // Legal move counts, in total and for each start index
+    static thread_local int s_count;
+    static thread_local int* s_pieceCounts;
+
+    // Squares a move must start or end on to be worth testing, for GENERATE_CHECKS and GENERATE_EVASIONS
+    static thread_local BITBOARD s_filter;
+    static thread_local INDEX s_enemyKing;
+
+    // Stores the position being generated
+    static void setup(FLAG colour, const PIECE* grid, int mode);
+
+    // Generates the moves of every piece of the stored colour
+    static void calculateMoves();
+
+    // Returns if the move does not leave the king attacked
+    static bool isLegal(Move move);
 
     // ----- Move ----- Calculation ----- Functions -----
 
-    // Calculates and determines if enemy captured king
-    static void calculateLegalMoves(FLAG colour, const PIECE* grid);
-    
     // Calculates moves for king
-    static bool calculateKingMoves(INDEX startIndex, const PIECE* grid);
+    static void calculateKingMoves(INDEX startIndex, const PIECE* grid);
 
     // Calculates the potential castling moves for the king
+    // King cannot castle out of or through an attacked square
     static void calculateKingCastling(INDEX startIndex, const PIECE* grid);
 
     // Cardinal movement generation
-    // Returns true if no moves capture a king
-    static bool calculateCardinalMoves(INDEX startIndex, const PIECE* grid);
+    static void calculateCardinalMoves(INDEX startIndex, const PIECE* grid);
 
     // Diagonal movement generation
-    // Returns true if no moves capture a king
-    static bool calculateDiagonalMoves(INDEX startIndex, const PIECE* grid);
+    static void calculateDiagonalMoves(INDEX startIndex, const PIECE* grid);
+
+    // Follows rays from firstRay to firstRay + 3 until blocked
+    static void calculateSlidingMoves(INDEX startIndex, int firstRay, const PIECE* grid);
 
     // Calculates moves for knight hops
-    // Returns true if no moves capture a king
-    static bool calculateKnightMoves(INDEX startIndex, const PIECE* grid);
+    static void calculateKnightMoves(INDEX startIndex, const PIECE* grid);
 
     // Calculates moves for pawns
-    // Returns true if no moves capture a king
-    static bool calculatePawnMoves(INDEX startIndex, const PIECE* grid);
-
-    // Calculates the attacking move for pawns
-    // Needed for preventing king from walking into pawn attack
-    static bool calculatePawnAttackMoves(INDEX start, const PIECE* grid);
+    static void calculatePawnMoves(INDEX startIndex, const PIECE* grid);
 
     // ----- Move ----- List ----- Functions -----
 
     // Call this function to add a move to the move list
+    // Returns MOVE_CONTINUE if sliding pieces can keep going past target
     static FLAG add(INDEX start, INDEX target, FLAG flags, const PIECE* grid);
 
     // Pawn is a special case, has its own add logic
-    static FLAG addPawn(INDEX start, INDEX target, FLAG flags, const PIECE* grid);
+    // kind is MOVE_CAPTURE for attacks, promotions are added for each piece on the last rank
+    static FLAG addPawn(INDEX start, INDEX target, FLAG kind, const PIECE* grid);
 
-    // Called by add function, it decides which list to add to
+    // Called by add function, it decides what to do with the move based on the mode
     static void addValid(Move move);
 
-    // Called by add function, it decides which list to add to
-    static void addLegal(Move& move);
+    // Returns if the legal move leaves the enemy king attacked
+    static bool givesCheck(Move move);
+
+    // Sets s_filter to every square on a line or a knight or pawn's step from the enemy king
+    // A checking move either lands on one of them or moves off one, uncovering a line
+    static void setupChecks();
+
+    // Sets s_filter to the checking piece and the squares between it and the king, nothing in double check
+    static void setupEvasions();
 
 public:
     // Returns all legal generated moves
-    // Returns a single move with check flag if king captured when not calculating legal
+    // Returns moves that may leave the king attacked when not calculating legal
     static std::vector<Move> generate(FLAG colour, const PIECE* grid, bool calculateLegal);
-};
 
+    // Returns the legal moves that give check, skipping the legality test for moves that cannot
+    static std::vector<Move> generateChecks(FLAG colour, const PIECE* grid);
+
+    // Returns the legal moves of a colour in check, only king moves, captures of the checking piece and blocks are tested
+    // Same as generate when not in check
+    static std::vector<Move> generateEvasions(FLAG colour, const PIECE* grid);
+
+    // Returns if the colour has at least one legal move
+    // Stops as soon as one is found, used for checkmate and stalemate detection
+    static bool hasLegalMove(FLAG colour, const PIECE* grid);
+
+    // Returns the number of legal moves without storing any of them
+    // Also used as the mobility of a colour
+    static int count(FLAG colour, const PIECE* grid);
+
+    // Same as count, also fills pieceCounts with the legal moves of each start index
+    static int count(FLAG colour, const PIECE* grid, int* pieceCounts);
+
+    // Returns if the king of the given colour is attacked
+    static bool inCheck(FLAG colour, const PIECE* grid);
+
+    // Returns if playing the move does not leave the colour's king attacked
+    // The move must already be one the piece can make
+    static bool isLegal(Move move, FLAG colour, const PIECE* grid);
+};
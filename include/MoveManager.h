@@ -11,6 +11,16 @@ class MoveManager {
 private:
     std::vector<Move> m_moves;
 
+    // Legal moves indexed by start and target, empty entries are not moves
+    Move m_lookup[GRID_SIZE * GRID_SIZE][GRID_SIZE * GRID_SIZE];
+    // Target squares for each start index
+    BITBOARD m_targets[GRID_SIZE * GRID_SIZE];
+
+    // ----- Update -----
+
+    // Removes the current moves from the lookup tables
+    void clearLookup();
+
 public:
     // ----- Creation -----
 
@@ -19,11 +29,16 @@ public:
     // ----- Read -----
 
     // Returns if the move is legal
+    // Sets the kind of the legal move on the given move
+    // Promotions keep their piece, otherwise the stored promotion is used
     bool isLegal(Move& move);
 
     std::vector<Move> getMoves(INDEX index);
     std::vector<Move> getMoves();
 
+    // Returns a bitboard of every target square for the piece at the given index
+    BITBOARD getTargets(INDEX index);
+
     // ----- Update -----
     
     // Calculates all valid moves for given piece
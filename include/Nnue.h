@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+#include "Move.h"
+#include "Position.h"
+
+// First layer sums for both sides, white's view first
+// Kept up to date as moves are played instead of being summed again for every evaluation
+typedef struct nnueAccumulatorHolder {
+    alignas(32) short values[2][NNUE_ACCUMULATOR_SIZE];
+} NNUE_ACCUMULATOR;
+
+// Many positions as a structure of arrays, so a batch is evaluated without reading any grids
+// Feature rows of position i, from white's and black's view, are features[side][offsets[i]] up to features[side][offsets[i + 1]]
+typedef struct nnueBatchHolder {
+    size_t count;
+    // Side to move of each position, 0 for white
+    std::vector<unsigned char> sides;
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned short> features[2];
+} NNUE_BATCH;
+
+// Weights of a loaded network, defined in Nnue.cpp
+struct nnueNetworkHolder;
+
+// Efficiently updatable neural network evaluation
+// Accumulators are updated with only the pieces a move changes, then two small dense layers give the score
+// Layers run with AVX2, SSE2 or plain code, picked once for the machine it runs on
+class Nnue {
+private:
+    std::unique_ptr<nnueNetworkHolder> m_network;
+
+public:
+    // ----- Creation -----
+
+    Nnue();
+
+    // Reads weights from a network file, returns false and keeps no network if it is not one
+    bool load(const std::string& path);
+
+    // ----- Read -----
+
+    bool isLoaded() const;
+
+    // Returns the name of the kernels in use, "avx2", "sse2" or "scalar"
+    static std::string Kernel();
+
+    // Sums the accumulator for every piece on the grid
+    void refresh(const PIECE* grid, NNUE_ACCUMULATOR& accumulator) const;
+
+    // Writes to next the accumulator after the move is played, grid is the position before it
+    // next can be the same accumulator, keeping the old one makes unmaking a move free
+    void update(Move move, const PIECE* grid, const NNUE_ACCUMULATOR& accumulator, NNUE_ACCUMULATOR& next) const;
+
+    // Returns the score in centipawns for colour to move
+    int evaluate(const NNUE_ACCUMULATOR& accumulator, FLAG colour) const;
+
+    // Refreshes an accumulator for the grid and evaluates it
+    int evaluate(FLAG colour, const PIECE* grid) const;
+
+    // Converts positions to the layout evaluated in batches, replacing what the batch held
+    static void toBatch(const POSITION* positions, size_t count, NNUE_BATCH& batch);
+
+    // Writes the score for each position in the batch to scores, same as evaluating them one at a time
+    // Dense layers run on NNUE_BATCH_BLOCK positions at once, so each weight is loaded once for all of them
+    void evaluate(const NNUE_BATCH& batch, int* scores) const;
+
+    // ----- Update -----
+
+    // Uses the named kernels if the machine supports them, returns false otherwise
+    // Kernels are shared by every network, so this should be called before evaluating on other threads
+    static bool useKernel(const std::string& name);
+
+    // ----- Destruction -----
+
+    ~Nnue();
+};
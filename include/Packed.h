@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+#include "Position.h"
+
+// Fixed size binary positions for moving large position sets between tools
+// Bytes 0-7 are the occupancy bitboard, least significant byte first
+// Bytes 8-23 hold a 4 bit code for each occupied square in index order, colour bit then type
+// Byte 24 is white to move in bit 4 and castling rights in bits 0-3, indexed by BOARD_CASTLING
+// Byte 25 is the en passant square or PACKED_NO_EN_PASSANT, byte 26 the halfmove clock
+// Bytes 27-28 are the fullmove number, least significant byte first, the rest are zero
+typedef struct packedPositionHolder {
+    unsigned char data[PACKED_SIZE];
+} PACKED_POSITION;
+
+namespace Packed {
+    // Packs the position, returns false if it has more pieces than fit
+    // Clocks are clamped to the space they have
+    bool pack(const POSITION& position, PACKED_POSITION& packed);
+
+    // Unpacks into a position, adding castling and first move flags to pieces
+    // Returns false if the data does not describe a board
+    bool unpack(const PACKED_POSITION& packed, POSITION& position);
+
+    // Writes every position to the file, returns false if any cannot be written
+    bool write(const std::string& path, const std::vector<POSITION>& positions);
+
+    // Appends every position in the memory mapped file to positions, unpacking across threads
+    bool read(const std::string& path, std::vector<POSITION>& positions, int threads);
+}
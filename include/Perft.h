@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Defines.h"
+#include "Position.h"
+
+// Counts positions reachable by legal moves, used to validate move generation
+namespace Perft {
+    // Returns the number of leaf positions depth plies from the grid
+    // Leaves are counted in bulk from the legal move count one ply above them
+    unsigned long long perft(FLAG colour, const PIECE* grid, int depth);
+
+    // Same as perft, with the tree split across threads
+    // Subtree counts are shared between threads in a table keyed by hash and depth, 0 megabytes turns it off
+    unsigned long long perft(FLAG colour, const PIECE* grid, int depth, int threads, int hashMegabytes);
+
+    // Prints the leaf count under each root move, then returns the total
+    unsigned long long divide(FLAG colour, const PIECE* grid, int depth);
+}
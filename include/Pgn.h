@@ -0,0 +1,46 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Defines.h"
+#include "Move.h"
+#include "Position.h"
+
+// A game as tag pairs and the moves played from its start position
+// Start position is the FEN tag if there is one, otherwise the normal start
+typedef struct gameHolder {
+    std::vector<std::pair<std::string, std::string>> tags;
+    std::vector<Move> moves;
+    std::string result;
+} GAME;
+
+// Reads and writes PGN games, moves are in SAN
+namespace Pgn {
+    // Parses one game, comments, NAGs and variations are skipped
+    // Returns false and describes the problem in error if a tag or move cannot be read
+    bool parse(std::string_view text, GAME& game, std::string& error);
+
+    // Returns the value of the tag, or an empty string if the game does not have it
+    std::string getTag(const GAME& game, const std::string& name);
+
+    // Replaces the value of the tag, adding it if the game does not have it
+    void setTag(GAME& game, const std::string& name, const std::string& value);
+
+    // Loads the start position of the game, returns false if its FEN tag is invalid
+    bool startPosition(const GAME& game, POSITION& position);
+
+    // Returns the game as PGN text, followed by a blank line
+    std::string toPGN(const GAME& game);
+
+    // Streams the file a block at a time, parsing the games in each block across threads
+    // onGame is called for every game in file order, returning false from it stops reading
+    // Games that fail to parse are reported and skipped, returns false if the file cannot be opened
+    bool read(const std::string& path, int threads, const std::function<bool(GAME&)>& onGame);
+
+    // Writes the games to the file, appending if asked
+    bool write(const std::string& path, const std::vector<GAME>& games, bool append = false);
+}
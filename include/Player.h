@@ -12,6 +12,9 @@ public:
     FLAG Type();
     FLAG Colour();
 
+    // Switches between PLAYER_TYPE_HUMAN and PLAYER_TYPE_BOT
+    void setType(FLAG type);
+
     ~Player();
 };
 
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Defines.h"
+#include "Move.h"
+
+// Stores everything needed to continue a game from a board
+// Castling rights and en passant are stored on the grid as piece flags and phantoms
+typedef struct positionHolder {
+    PIECE grid[GRID_SIZE * GRID_SIZE];
+    FLAG colour;
+    int halfmoves, fullmoves;
+} POSITION;
+
+// Applies moves to a grid without any rendering or player state
+namespace Position {
+    // Plays a move on the grid
+    // Handles castling rooks, en passant captures, promotions, phantoms and piece flags
+    void play(Move move, PIECE* grid);
+
+    // Returns the move from start to target, with its kind read from the pieces on the grid
+    // promotion is the piece type a pawn reaching the last rank becomes, queen if it is PIECE_INVALID
+    // Does not check that the move is legal
+    Move createMove(INDEX start, INDEX target, FLAG promotion, const PIECE* grid);
+
+    // Returns the index of the king of the given colour, or CODE_INVALID if there is none
+    INDEX findKing(FLAG colour, const PIECE* grid);
+
+    // Returns the phantom the colour to move could capture en passant onto, or CODE_INVALID if there is none
+    INDEX findPhantom(FLAG colour, const PIECE* grid);
+
+    // Returns a bit for each side the king and rook can still castle, indexed by BOARD_CASTLING
+    FLAG castlingRights(const PIECE* grid);
+
+    // Adds first move flags to pawns on their start rank and castling flags to kings and rooks
+    // Rights are the same bits returned by castlingRights
+    void setFlags(FLAG rights, PIECE* grid);
+}
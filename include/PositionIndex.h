@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+#include "MappedFile.h"
+#include "Move.h"
+
+// One position reached in a game, sorted by hash in the index file
+// move is the legal move index played next, as stored in game archives
+typedef struct positionEntry {
+    HASH hash;
+    unsigned int game;
+    unsigned short ply;
+    unsigned char result;
+    unsigned char move;
+} POSITION_ENTRY;
+
+// How a move played from a position scored, results are ARCHIVE_RESULT counts
+typedef struct moveStatsHolder {
+    Move move;
+    int games, white, draws, black;
+} MOVE_STATS;
+
+// Maps position hashes to the games and plies that reached them
+// Entries are stored as they are in memory, so index files are only shared between little endian machines
+class PositionIndex {
+private:
+    MappedFile m_file;
+    const POSITION_ENTRY* m_entries;
+    size_t m_count;
+
+public:
+    // ----- Creation -----
+
+    PositionIndex();
+
+    // Maps the index file, returns false if it is not one
+    bool open(const std::string& path);
+
+    // Builds an index of every position in a PGN file or game archive, games are numbered from 0 in file order
+    // Games are split across threads, positions after maxPly are left out when it is above 0
+    static bool build(const std::string& input, const std::string& output, int threads, int maxPly = 0);
+
+    // ----- Read -----
+
+    bool isOpen() const;
+
+    // Returns the number of positions in the index
+    size_t Count() const;
+
+    // Returns the first entry with the hash, entries for the same hash are next to each other
+    // count is set to the number of them, nothing is copied out of the file
+    const POSITION_ENTRY* find(HASH hash, size_t& count) const;
+
+    // Returns the results of each move played from the position, most played first
+    std::vector<MOVE_STATS> getStats(FLAG colour, const PIECE* grid) const;
+
+    // Prints the games that reached the position and the stats of each move played from it
+    void showStats(FLAG colour, const PIECE* grid) const;
+};
@@ -38,6 +38,9 @@ public:
     // Creates a square at given pixel coordinates with specified height
     void rect(COLOUR& colour, int x, int y, int width, int height);
 
+    // Creates an arrow between given pixel coordinates with specified shaft width, the head pointing at the second point
+    void arrow(COLOUR& colour, int x1, int y1, int x2, int y2, int width);
+
     // Renders a piece to the screen
     void render(PIECE piece, int x, int y);
 
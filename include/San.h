@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "Defines.h"
+#include "Move.h"
+
+// Converts moves to and from standard algebraic notation, such as Nbd2, exd6 or e8=Q+
+// Disambiguation looks backwards from the target square with attack queries instead of generating every move
+namespace San {
+    // Returns the SAN of a legal move for colour, with + or # if it gives check or mate
+    std::string toSAN(Move move, FLAG colour, const PIECE* grid);
+
+    // Returns the legal move the SAN describes for colour
+    // Returns a move that is not isMove() if there is no such move or it is ambiguous
+    Move fromSAN(std::string_view san, FLAG colour, const PIECE* grid);
+}
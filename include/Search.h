@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+#include "Move.h"
+#include "Nnue.h"
+#include "Position.h"
+
+// Stops the search at whichever limit is reached first, 0 for no limit
+typedef struct searchLimitsHolder {
+    int depth;
+    long long nodes;
+    long long milliseconds;
+} SEARCH_LIMITS;
+
+typedef struct searchResultHolder {
+    // Best move of the deepest finished iteration, not isMove() if the position has no moves
+    Move move;
+    // Score in centipawns for the side to move, mates are SEARCH_MATE less the plies to mate
+    int score;
+    int depth;
+    long long nodes;
+} SEARCH_RESULT;
+
+// One of the best lines found by analysis
+typedef struct searchLineHolder {
+    // Score in centipawns for the side to move, as in SEARCH_RESULT
+    int score;
+    // Starts with the root move, then as much of the line as the hash table still holds
+    std::vector<Move> moves;
+} SEARCH_LINE;
+
+// Called by analysis after each depth with its lines, best first
+typedef std::function<void(const std::vector<SEARCH_LINE>&, int)> SEARCH_REPORT;
+
+// Values the search prunes and reduces with, starting from the defines
+// Kept in each Search so tuning can play differently set searches against each other
+typedef struct searchParametersHolder {
+    int nullDepth = SEARCH_NULL_DEPTH;
+    int nullReduction = SEARCH_NULL_REDUCTION;
+    int lmrDepth = SEARCH_LMR_DEPTH;
+    int lmrMoves = SEARCH_LMR_MOVES;
+    int lmrReduction = SEARCH_LMR_REDUCTION;
+    int futilityMargin = SEARCH_FUTILITY_MARGIN;
+    int deltaMargin = SEARCH_DELTA_MARGIN;
+} SEARCH_PARAMETERS;
+
+// Name of a parameter, the values it may take and the step tuning perturbs it by
+typedef struct searchParameterHolder {
+    const char* name;
+    int SEARCH_PARAMETERS::* value;
+    int min, max;
+    double delta;
+} SEARCH_PARAMETER;
+
+// Hash table entry, defined in Search.cpp
+struct searchEntryHolder;
+
+// Alpha beta search with iterative deepening, a hash table, null moves and late move reductions
+// Evaluates with the network if one is given and loaded, otherwise with Evaluation
+// Each thread needs its own Search, the network can be shared
+class Search {
+private:
+    std::vector<searchEntryHolder> m_table;
+    const Nnue* m_network;
+    SEARCH_PARAMETERS m_parameters;
+
+    // Hashes of the positions played to reach this one, then the positions on the current line
+    std::vector<HASH> m_path;
+
+    long long m_nodes, m_nodeLimit;
+    std::chrono::steady_clock::time_point m_deadline;
+    bool m_timed;
+    bool m_stopped;
+    // Set by another thread to stop an analysis, null for searches
+    const std::atomic<bool>* m_stop;
+    // Root moves left out of the current search, so each line of an analysis finds the next best move
+    std::vector<Move> m_excluded;
+    // Best move found at the root in the current iteration
+    Move m_rootMove;
+
+    // Quiet moves that caused cutoffs, by ply and by colour and squares
+    Move m_killers[SEARCH_MAX_PLY][2];
+    int m_history[2][GRID_SIZE * GRID_SIZE][GRID_SIZE * GRID_SIZE];
+
+    // Network accumulator for each ply of the current line
+    std::vector<NNUE_ACCUMULATOR> m_accumulators;
+
+    // ----- Read -----
+
+    // Returns the score of the grid for colour to move
+    int evaluate(FLAG colour, const PIECE* grid, int ply) const;
+
+    // Returns if the position repeats one since the last capture or pawn move
+    bool isRepetition(HASH hash, int halfmoves) const;
+
+    // Follows hash moves from after the first move while they are legal and the line does not repeat
+    void principalVariation(const POSITION& position, Move first, std::vector<Move>& line) const;
+
+    // Sorts moves best first, hash move then captures by victim and attacker, then killers and history
+    void order(std::vector<Move>& moves, const PIECE* grid, FLAG colour, Move hashMove, int ply) const;
+
+    // ----- Update -----
+
+    // Counts a node and stops the search once a limit is reached, the clock is only read every SEARCH_TIME_NODES nodes
+    void countNode();
+
+    // Sets up the counters and the path for a new search from the position
+    void start(const POSITION& position, const std::vector<HASH>& history);
+
+    // Plays the move on a copy of the grid, keeping the next accumulator up to date
+    void play(Move move, const PIECE* grid, PIECE* next, int ply);
+
+    int negamax(FLAG colour, const PIECE* grid, int halfmoves, int depth, int ply, int alpha, int beta, bool nullMove);
+
+    // Searches captures and promotions until the position is quiet
+    int quiescence(FLAG colour, const PIECE* grid, int ply, int alpha, int beta);
+
+public:
+    // ----- Creation -----
+
+    // Hash table is rounded down to a power of two entries
+    Search(int hashMegabytes = SEARCH_HASH_MEGABYTES, const Nnue* network = nullptr);
+
+    // ----- Read -----
+
+    // Returns the nodes searched so far by the current or last search
+    long long Nodes() const;
+
+    const SEARCH_PARAMETERS& Parameters() const;
+
+    // Returns every parameter that can be tuned, by name
+    static const std::vector<SEARCH_PARAMETER>& Tunable();
+
+    // Sets the named parameter in parameters, clamped to its range, returns false if there is none by that name
+    static bool setParameter(SEARCH_PARAMETERS& parameters, const std::string& name, int value);
+
+    // ----- Update -----
+
+    // Searches the position until a limit is reached
+    // history holds the hashes of the positions before it in the game, for finding repetitions
+    SEARCH_RESULT search(const POSITION& position, const std::vector<HASH>& history, const SEARCH_LIMITS& limits);
+
+    // Searches the best lines of the position one depth after another until stop is set or SEARCH_MAX_DEPTH is done
+    // Each line is searched with the moves of the lines before it left out of the root, sharing one hash table,
+    // and every depth that finishes is passed to report
+    void analyse(const POSITION& position, const std::vector<HASH>& history, int lines, const std::atomic<bool>& stop, const SEARCH_REPORT& report);
+
+    // Forgets the hash table, killers and history, as before a new game
+    void clear();
+
+    void setParameters(const SEARCH_PARAMETERS& parameters);
+
+    // ----- Destruction -----
+
+    ~Search();
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+#include "Defines.h"
+#include "DtmTablebase.h"
+#include "Nnue.h"
+#include "Search.h"
+#include "Tablebase.h"
+
+typedef struct spsaSettingsHolder {
+    // Iterations to reach in total, a resumed run only plays the ones left
+    int iterations;
+    // Game pairs played each iteration, each pair plays one opening with both colours
+    int pairs;
+    // Limits of the search for every move
+    SEARCH_LIMITS limits;
+    int randomPlies;
+    int threads;
+    // Step size, a parameter moves by at most rate times its perturbation each iteration
+    double rate;
+    // Iteration k plays its openings from seed + k * pairs, so runs can be repeated
+    unsigned long long seed;
+} SPSA_SETTINGS;
+
+// Tunes the search parameters by simultaneous perturbation
+// Each iteration moves every parameter up or down at random for one side and the other way for the other,
+// plays the two against each other and steps the parameters towards whichever side scored better
+namespace Spsa {
+    // Runs from the checkpoint if it exists, otherwise from the defaults, writing the checkpoint after every iteration
+    // Returns false if the checkpoint cannot be read or written
+    bool run(const std::string& checkpoint, const SPSA_SETTINGS& settings, const Nnue* network = nullptr,
+        const Tablebase* tablebase = nullptr, const DtmTablebase* dtm = nullptr);
+
+    // Sets the parameters to the values in a checkpoint, rounded, returns false if it cannot be read
+    bool load(const std::string& checkpoint, SEARCH_PARAMETERS& parameters);
+}
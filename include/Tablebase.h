@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Defines.h"
+#include "Move.h"
+
+// Tables for one material set, such as KRvK, defined in Tablebase.cpp
+struct tablebaseMaterialHolder;
+
+// Probes Syzygy endgame tablebases from local directories
+// Files are found when opened and memory mapped the first time they are probed
+// Probing only reads shared data, so one Tablebase can be used from every thread at once
+class Tablebase {
+private:
+    std::vector<std::unique_ptr<tablebaseMaterialHolder>> m_materials;
+
+    // Materials by name with white's pieces first, each is stored under both colour orders
+    std::unordered_map<std::string, tablebaseMaterialHolder*> m_lookup;
+    int m_maxPieces;
+
+    // ----- Read -----
+
+    // Reads the WDL or DTZ value of the position straight from its table, state is a TABLEBASE_PROBE value
+    int probeTable(FLAG colour, const PIECE* grid, bool dtz, int wdl, int& state) const;
+
+    // Returns the WDL value after looking at captures, and pawn moves too when zeroing is set
+    // Tables store "don't care" values where these are best, so they have to be searched
+    int search(FLAG colour, const PIECE* grid, bool zeroing, int& state) const;
+
+    // Returns the DTZ value, searching one ply when the table only stores the other side to move
+    int searchDTZ(FLAG colour, const PIECE* grid, int& state) const;
+
+public:
+    // ----- Creation -----
+
+    Tablebase();
+
+    // Finds every table in paths, directories are separated by ':' or ';' on Windows
+    // Returns the number of WDL tables found
+    int open(const std::string& paths);
+
+    // ----- Read -----
+
+    // Returns the most pieces, kings included, of any table found, 0 if there are none
+    int MaxPieces() const;
+
+    // Returns if the position has few enough pieces and no castling rights
+    bool canProbe(const PIECE* grid) const;
+
+    // Sets wdl to a TABLEBASE_* result for colour to move, returns false if the tables needed are missing
+    bool probeWDL(FLAG colour, const PIECE* grid, int& wdl) const;
+
+    // Sets dtz to the plies until a capture or pawn move that keeps the result, negative when losing
+    // Zero is a draw, returns false if the tables needed are missing
+    bool probeDTZ(FLAG colour, const PIECE* grid, int& dtz) const;
+
+    // Returns the move that wins fastest, keeps the draw or loses slowest, counting the 50 move rule from halfmoves
+    // Sets wdl to the result, returns a move that is not isMove() if the position cannot be probed
+    Move bestMove(FLAG colour, const PIECE* grid, int halfmoves, int& wdl) const;
+
+    // ----- Destruction -----
+
+    ~Tablebase();
+};
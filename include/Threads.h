@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Runs independent pieces of work across worker threads
+namespace Threads {
+    // Returns the number of threads the machine can run at once, at least 1
+    int available();
+
+    // Calls work(index, thread) for every index below count on up to threads workers
+    // Indices are handed out as workers finish, returns once all work is done
+    void parallelFor(size_t count, int threads, const std::function<void(size_t, int)>& work);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+#include "Defines.h"
+
+typedef struct tuneSettingsHolder {
+    int epochs;
+    int threads;
+    // Adam step size in centipawns
+    double rate;
+    // Share of each target taken from the search score instead of the game result, 0 for results only
+    double lambda;
+} TUNE_SETTINGS;
+
+// Texel tuning of the hand written evaluation from datagen records
+// Each position is turned once into a short list of its pieces, so an epoch only sums weights and gradients
+namespace Tuner {
+    // Loads every record in data, fits the score scale to the results, then runs Adam on the logistic error
+    // Writes the tuned weights to output in the same form as EvaluationWeights.h, returns false if either file fails
+    bool run(const std::string& data, const std::string& output, const TUNE_SETTINGS& settings);
+}
@@ -0,0 +1,328 @@
+#include "Archive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "Fen.h"
+#include "MoveGen.h"
+#include "Packed.h"
+#include "Threads.h"
+
+namespace {
+
+    // Numbers are stored least significant byte first
+    void writeNumber(unsigned char* data, unsigned long long value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            data[i] = (unsigned char)(value >> (8 * i));
+        }
+    }
+
+    unsigned long long readNumber(const unsigned char* data, int bytes) {
+        unsigned long long value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= (unsigned long long)data[i] << (8 * i);
+        }
+        return value;
+    }
+
+}
+
+// ----- Archive -----
+
+FLAG Archive::resultCode(const std::string& result) {
+    if (result == "1-0") {
+        return ARCHIVE_RESULT_WHITE;
+    }
+    if (result == "0-1") {
+        return ARCHIVE_RESULT_BLACK;
+    }
+    if (result == "1/2-1/2") {
+        return ARCHIVE_RESULT_DRAW;
+    }
+    return ARCHIVE_RESULT_NONE;
+}
+
+std::string Archive::resultString(FLAG code) {
+    switch (code) {
+    case ARCHIVE_RESULT_WHITE:
+        return "1-0";
+    case ARCHIVE_RESULT_BLACK:
+        return "0-1";
+    case ARCHIVE_RESULT_DRAW:
+        return "1/2-1/2";
+    default:
+        return "*";
+    }
+}
+
+bool Archive::encode(const GAME& game, std::vector<unsigned char>& data) {
+    if (game.moves.size() > ARCHIVE_MAX_MOVES) {
+        return false;
+    }
+    POSITION position;
+    if (!Pgn::startPosition(game, position)) {
+        return false;
+    }
+
+    // Start position is only stored when it is not the normal one
+    bool hasPosition = !Pgn::getTag(game, "FEN").empty();
+    size_t start = data.size();
+    data.resize(start + ARCHIVE_GAME_SIZE);
+    data[start] = Archive::resultCode(game.result) | (hasPosition ? ARCHIVE_HAS_POSITION : 0);
+    ::writeNumber(&data[start + 1], game.moves.size(), 2);
+    if (hasPosition) {
+        PACKED_POSITION packed;
+        if (!Packed::pack(position, packed)) {
+            data.resize(start);
+            return false;
+        }
+        data.insert(data.end(), packed.data, packed.data + PACKED_SIZE);
+    }
+
+    for (Move move : game.moves) {
+        std::vector<Move> moves = MoveGen::generate(position.colour, position.grid, true);
+        size_t index = 0;
+        while (index < moves.size() && !(moves[index].Start() == move.Start() && moves[index].Target() == move.Target() && moves[index].Kind() == move.Kind())) {
+            index++;
+        }
+        if (index == moves.size()) {
+            data.resize(start);
+            return false;
+        }
+        data.push_back((unsigned char)index);
+
+        Position::play(move, position.grid);
+        position.colour = (position.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+    return true;
+}
+
+bool Archive::decode(const unsigned char* data, size_t size, GAME& game, size_t maxMoves) {
+    game.tags.clear();
+    game.moves.clear();
+    if (size < ARCHIVE_GAME_SIZE) {
+        return false;
+    }
+
+    FLAG state = data[0];
+    size_t count = ::readNumber(&data[1], 2);
+    size_t offset = ARCHIVE_GAME_SIZE;
+    game.result = Archive::resultString(state & MASK_ARCHIVE_RESULT);
+    Pgn::setTag(game, "Result", game.result);
+
+    POSITION position;
+    if (state & ARCHIVE_HAS_POSITION) {
+        PACKED_POSITION packed;
+        if (size < offset + PACKED_SIZE) {
+            return false;
+        }
+        std::memcpy(packed.data, data + offset, PACKED_SIZE);
+        if (!Packed::unpack(packed, position)) {
+            return false;
+        }
+        offset += PACKED_SIZE;
+        Pgn::setTag(game, "SetUp", "1");
+        Pgn::setTag(game, "FEN", Fen::toFEN(position));
+    }
+    else {
+        Pgn::startPosition(game, position);
+    }
+
+    if (size < offset + count) {
+        return false;
+    }
+    if (maxMoves > 0) {
+        count = std::min(count, maxMoves);
+    }
+    game.moves.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::vector<Move> moves = MoveGen::generate(position.colour, position.grid, true);
+        if (data[offset + i] >= moves.size()) {
+            return false;
+        }
+        Move move = moves[data[offset + i]];
+        game.moves.push_back(move);
+
+        Position::play(move, position.grid);
+        position.colour = (position.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+    return true;
+}
+
+bool Archive::isArchive(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[4] = {};
+    file.read(magic, 4);
+    return (file && std::memcmp(magic, ARCHIVE_MAGIC, 4) == 0);
+}
+
+bool Archive::forEachGame(const std::string& path, int threads, size_t maxMoves, const std::function<void(const GAME&, size_t, int)>& onGame) {
+    if (Archive::isArchive(path)) {
+        ArchiveReader archive;
+        if (!archive.open(path)) {
+            return false;
+        }
+        Threads::parallelFor(archive.Count(), threads, [&](size_t index, int thread) {
+            GAME game;
+            if (archive.getGame(index, game, maxMoves)) {
+                onGame(game, index, thread);
+            }
+        });
+        return true;
+    }
+
+    // PGN is streamed in batches, numbers count every game read
+    std::vector<GAME> batch;
+    size_t first = 0;
+    auto flush = [&]() {
+        Threads::parallelFor(batch.size(), threads, [&](size_t index, int thread) {
+            onGame(batch[index], first + index, thread);
+        });
+        first += batch.size();
+        batch.clear();
+    };
+    bool opened = Pgn::read(path, threads, [&](GAME& game) {
+        batch.push_back(std::move(game));
+        if (batch.size() == ARCHIVE_BATCH_SIZE) {
+            flush();
+        }
+        return true;
+    });
+    if (!opened) {
+        return false;
+    }
+    flush();
+    return true;
+}
+
+// ----- Writer ----- Creation -----
+
+ArchiveWriter::ArchiveWriter() {
+    this->m_position = 0;
+}
+
+bool ArchiveWriter::open(const std::string& path) {
+    this->m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!this->m_file) {
+        std::cout << "Could not open archive: " << path << std::endl;
+        return false;
+    }
+
+    // Header is filled in when the archive is closed
+    unsigned char header[ARCHIVE_HEADER_SIZE] = {};
+    this->m_file.write((const char*)header, ARCHIVE_HEADER_SIZE);
+    this->m_offsets.clear();
+    this->m_position = ARCHIVE_HEADER_SIZE;
+    return true;
+}
+
+// ----- Writer ----- Update -----
+
+bool ArchiveWriter::add(const GAME& game) {
+    std::vector<unsigned char> data;
+    if (!Archive::encode(game, data)) {
+        return false;
+    }
+    this->addEncoded(data);
+    return true;
+}
+
+void ArchiveWriter::addEncoded(const std::vector<unsigned char>& data) {
+    this->m_offsets.push_back(this->m_position);
+    this->m_file.write((const char*)data.data(), data.size());
+    this->m_position += data.size();
+}
+
+// ----- Writer ----- Destruction -----
+
+bool ArchiveWriter::close() {
+    if (!this->m_file.is_open()) {
+        return false;
+    }
+
+    // Index of game offsets goes after the last game
+    std::vector<unsigned char> index(this->m_offsets.size() * 8);
+    for (size_t i = 0; i < this->m_offsets.size(); i++) {
+        ::writeNumber(&index[i * 8], this->m_offsets[i], 8);
+    }
+    this->m_file.write((const char*)index.data(), index.size());
+
+    unsigned char header[ARCHIVE_HEADER_SIZE] = {};
+    std::memcpy(header, ARCHIVE_MAGIC, 4);
+    ::writeNumber(&header[4], ARCHIVE_VERSION, 4);
+    ::writeNumber(&header[8], this->m_offsets.size(), 8);
+    ::writeNumber(&header[16], this->m_position, 8);
+    this->m_file.seekp(0);
+    this->m_file.write((const char*)header, ARCHIVE_HEADER_SIZE);
+
+    bool written = (bool)this->m_file;
+    this->m_file.close();
+    return written;
+}
+
+ArchiveWriter::~ArchiveWriter() {
+    this->close();
+}
+
+// ----- Reader ----- Creation -----
+
+ArchiveReader::ArchiveReader() {
+    this->m_count = 0;
+    this->m_index = nullptr;
+}
+
+bool ArchiveReader::open(const std::string& path) {
+    this->m_count = 0;
+    this->m_index = nullptr;
+    if (!this->m_file.open(path)) {
+        std::cout << "Could not open archive: " << path << std::endl;
+        return false;
+    }
+
+    const unsigned char* data = (const unsigned char*)this->m_file.Data();
+    size_t size = this->m_file.Size();
+    if (size < ARCHIVE_HEADER_SIZE || std::memcmp(data, ARCHIVE_MAGIC, 4) != 0 || ::readNumber(&data[4], 4) != ARCHIVE_VERSION) {
+        std::cout << "Not a game archive: " << path << std::endl;
+        this->m_file.close();
+        return false;
+    }
+
+    unsigned long long count = ::readNumber(&data[8], 8);
+    unsigned long long indexOffset = ::readNumber(&data[16], 8);
+    if (indexOffset < ARCHIVE_HEADER_SIZE || indexOffset > size || (size - indexOffset) / 8 < count) {
+        std::cout << "Archive index is damaged: " << path << std::endl;
+        this->m_file.close();
+        return false;
+    }
+    this->m_count = count;
+    this->m_index = data + indexOffset;
+    return true;
+}
+
+// ----- Reader ----- Read -----
+
+size_t ArchiveReader::Count() const {
+    return this->m_count;
+}
+
+bool ArchiveReader::getGame(size_t index, GAME& game, size_t maxMoves) const {
+    size_t size = 0;
+    const unsigned char* data = this->gameData(index, size);
+    return (data && Archive::decode(data, size, game, maxMoves));
+}
+
+const unsigned char* ArchiveReader::gameData(size_t index, size_t& size) const {
+    if (index >= this->m_count) {
+        return nullptr;
+    }
+
+    // Games end where the next one starts, the last one ends at the index
+    unsigned long long start = ::readNumber(this->m_index + index * 8, 8);
+    unsigned long long end = (index + 1 < this->m_count ? ::readNumber(this->m_index + (index + 1) * 8, 8) : (unsigned long long)(this->m_index - (const unsigned char*)this->m_file.Data()));
+    if (start > end || end > this->m_file.Size()) {
+        return nullptr;
+    }
+    size = end - start;
+    return (const unsigned char*)this->m_file.Data() + start;
+}
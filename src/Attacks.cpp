@@ -0,0 +1,70 @@
+#include "Attacks.h"
+
+#include "Piece.h"
+
+namespace {
+
+    // Returns if the piece at index is of the colour and one of the two types
+    bool isAttacker(PIECE piece, FLAG colour, FLAG typeOne, FLAG typeTwo) {
+        if (Piece::getFlag(piece, MASK_COLOUR) != colour) {
+            return false;
+        }
+        FLAG type = Piece::getFlag(piece, MASK_TYPE);
+        return (type == typeOne || type == typeTwo);
+    }
+
+    // Finds attackers of index by looking outwards from it
+    // Returns after the first attacker if firstOnly is set
+    BITBOARD findAttackers(INDEX index, FLAG colour, const PIECE* grid, bool firstOnly) {
+        BITBOARD attackers = BITBOARD_EMPTY;
+
+        // Stepping pieces attack back along the same table entries
+        // Pawns use the opposite colour's table, as they attack forwards
+        FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+        const Attacks::ATTACK_TABLE* tables[] = { &Attacks::knight, &Attacks::king, (enemy == PIECE_WHITE ? &Attacks::whitePawn : &Attacks::blackPawn) };
+        FLAG types[] = { PIECE_KNIGHT, PIECE_KING, PIECE_PAWN };
+        for (int i = 0; i < 3; i++) {
+            BITBOARD squares = tables[i]->squares[index];
+            while (squares) {
+                INDEX square = Attacks::popLowest(squares);
+                if (isAttacker(grid[square], colour, types[i], types[i])) {
+                    attackers |= BITBOARD_INDEX(square);
+                    if (firstOnly) {
+                        return attackers;
+                    }
+                }
+            }
+        }
+
+        // Sliding pieces, the first piece along each ray is the only one that can attack
+        for (int ray = 0; ray < ATTACKS_RAYS; ray++) {
+            FLAG slider = (ray < ATTACKS_DIAGONAL_FIRST ? PIECE_ROOK : PIECE_BISHOP);
+            INDEX square = index;
+            for (INDEX i = 0; i < Attacks::rays.length[index][ray]; i++) {
+                square += Attacks::rayOffsets[ray];
+                // Phantoms are empty squares for everything but pawns
+                if (grid[square] == PIECE_INVALID || grid[square] == PIECE_PHANTOM) {
+                    continue;
+                }
+                if (isAttacker(grid[square], colour, slider, PIECE_QUEEN)) {
+                    attackers |= BITBOARD_INDEX(square);
+                    if (firstOnly) {
+                        return attackers;
+                    }
+                }
+                break;
+            }
+        }
+
+        return attackers;
+    }
+
+}
+
+BITBOARD Attacks::attackersTo(INDEX index, FLAG colour, const PIECE* grid) {
+    return ::findAttackers(index, colour, grid, false);
+}
+
+bool Attacks::isSquareAttacked(INDEX index, FLAG colour, const PIECE* grid) {
+    return (::findAttackers(index, colour, grid, true) != BITBOARD_EMPTY);
+}
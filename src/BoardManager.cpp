@@ -1,15 +1,53 @@
 #include "BoardManager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
 #include "WindowManager.h"
+#include "MoveGen.h"
+#include "Position.h"
+#include "Fen.h"
+#include "Pgn.h"
+#include "San.h"
+#include "Bot.h"
+#include "Archive.h"
 #include "Piece.h"
 #include "Move.h"
+#include "Threads.h"
+#include "Zobrist.h"
+
+namespace {
+
+    // Score for the side to move as shown on the console, in pawns or moves to mate
+    std::string scoreString(int score) {
+        if (std::abs(score) >= SEARCH_MATE_BOUND) {
+            int moves = (SEARCH_MATE - std::abs(score) + 1) / 2;
+            return (score > 0 ? "#" : "#-") + std::to_string(moves);
+        }
+        std::string hundredths = std::to_string(std::abs(score) % 100);
+        return (score >= 0 ? "+" : "-") + std::to_string(std::abs(score) / 100) + "." + (hundredths.size() < 2 ? "0" : "") + hundredths;
+    }
+
+}
 
 // ----- Creation -----
 
-BoardManager::BoardManager(Player& white, Player& black, GLenum boardColourStyle, bool flipBoard, const std::string& FEN) : m_whitePlayer(white), m_blackPlayer(black) {
+BoardManager::BoardManager(Player& white, Player& black, GLenum boardColourStyle, bool flipBoard, const std::string& FEN) : m_whitePlayer(white), m_blackPlayer(black), m_mcts(Threads::available()) {
     // Setup FEN for setting board
     this->m_resetFEN = FEN;
 
+    // Index is optional, the board works without it
+    this->m_positionIndex.open(indexFile);
+    // Book is optional too
+    this->m_book.open(bookFile);
+    if (TABLEBASE_PLAY) {
+        this->m_tablebase.open(tablebasePath);
+    }
+    this->m_dtm.open(dtmPath);
+    this->m_network.load(networkFile);
+
     // Selects board colouring
     this->setBoardColour(boardColourStyle);
     
@@ -18,10 +56,16 @@ BoardManager::BoardManager(Player& white, Player& black, GLenum boardColourStyle
     
     // Setting
     this->m_heldPieceIndex = CODE_INVALID;
+    this->m_heldTargets = BITBOARD_EMPTY;
     this->m_promotionIndex = CODE_INVALID;
     this->m_flipBoard = flipBoard;
     this->m_whitePerspective = true;
     this->m_calculated = false;
+    this->m_useMcts = false;
+    this->m_analysisStop = false;
+    this->m_analysisDepth = 0;
+    this->m_analysing = false;
+    this->m_shownDepth = 0;
 }
 
 // ----- Read -----
@@ -48,6 +92,12 @@ void BoardManager::show() {
         }
     }
 
+    // Arrows go over the pieces but under the held piece
+    if (this->m_analysing) {
+        this->showAnalysis();
+    }
+    this->printMate();
+
     // Renders held piece so its on top
     if (this->m_heldPieceIndex != CODE_INVALID) {
         POINT mousePos = WindowManager::cursorPos();
@@ -91,14 +141,10 @@ void BoardManager::showBoard() {
                 }
 
                 // Check for moves and render as red
-                auto moves = this->m_moveManager.getMoves(this->m_heldPieceIndex);
-                for (Move& move : moves) {
-                    if (index == move.Target()) {
-                        mask.r = 0.3f;
-                        mask.g = -0.3f;
-                        mask.b = -0.3f;
-                        break;
-                    }
+                if (this->m_heldTargets & BITBOARD_INDEX(index)) {
+                    mask.r = 0.3f;
+                    mask.g = -0.3f;
+                    mask.b = -0.3f;
                 }
             }            
 
@@ -117,7 +163,12 @@ void BoardManager::showBoard() {
 
 void BoardManager::ManageInput(INDEX index) {
     // Do nothing if board is in checkmate or stalemate
-    if (this->m_checkmate || this->m_stalemate) {
+    if (this->m_checkmate || this->m_stalemate || this->m_adjudication != ARCHIVE_RESULT_NONE) {
+        return;
+    }
+
+    // Computer players move on their own
+    if (this->m_currentPlayer->Type() == PLAYER_TYPE_BOT) {
         return;
     }
 
@@ -137,21 +188,31 @@ void BoardManager::ManageInput(INDEX index) {
     
     // If a piece is held, try to release it
     if (this->m_heldPieceIndex != CODE_INVALID) {
-        // Store piece incase of valid
-        Move move(this->m_heldPieceIndex, index, 0);
-        bool isMove = this->m_moveManager.isLegal(move);
-        // Only switch turn if piece was placed elsewhere
-        if (index != this->m_heldPieceIndex && isMove) {
+        // Clicking the held piece's square puts it back down
+        if (index == this->m_heldPieceIndex) {
+            Move move(index, index);
             this->release(move);
-            this->m_currentPlayer = (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE ? &this->m_blackPlayer : &this->m_whitePlayer);
-            // Allows board to flip
-            if (this->m_flipBoard) {
-                this->m_whitePerspective = (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE ? true : false);
-            }
+            return;
         }
-        else if (isMove) {
-            this->release(move);
+
+        // Only look up the move if the square is one of the held piece's targets
+        if (index < 0 || index >= GRID_SIZE * GRID_SIZE || !(this->m_heldTargets & BITBOARD_INDEX(index))) {
+            return;
+        }
+
+        // Store piece incase of valid
+        Move move(this->m_heldPieceIndex, index, MOVE_QUIET);
+        if (!this->m_moveManager.isLegal(move)) {
+            return;
+        }
+        // Promotions are played once a piece is selected
+        if (move.isPromotion()) {
+            this->m_promotionMove = move;
+            this->m_promotionIndex = index;
+            return;
         }
+        this->release(move);
+        this->nextTurn();
         return;
     }
 
@@ -172,17 +233,21 @@ void BoardManager::showPromotionOptions() {
 
     // Render over other squares
     GLfloat scale = Library::min(WindowManager::winSize()) / GRID_SIZE;
-    FLAG colour = Piece::getFlag(this->m_grid[this->m_promotionIndex], MASK_COLOUR);
+    FLAG colour = Piece::getFlag(this->m_grid[this->m_promotionMove.Start()], MASK_COLOUR);
 
     // Holds pieces
     PIECE pieces[] = { PIECE_QUEEN, PIECE_ROOK, PIECE_BISHOP, PIECE_KNIGHT };
     
     for (int i = 0; i < 4; i++) {
         // Render square
+        INDEX index = this->m_promotionIndex + (i * nextPiece);
+        if (!this->m_whitePerspective) {
+            index = Library::flipIndex(index);
+        }
 
         // Variable setup for rendering
-        int x = (this->m_promotionIndex % GRID_SIZE);
-        int y = (this->m_promotionIndex / GRID_SIZE) + (i * nextPiece / GRID_SIZE);
+        int x = (index % GRID_SIZE);
+        int y = (index / GRID_SIZE);
 
         // Render a golden square under promotion options
         COLOUR gold = { 0.85f, 0.75f, 0.4f };
@@ -195,55 +260,160 @@ void BoardManager::showPromotionOptions() {
 }
 
 void BoardManager::checkCheckmate(Move& move) {
-    // Calculates if move put king into check
-    this->m_moveManager.clear();
-    this->m_moveManager.calculateMoves(this->m_currentPlayer->Colour(), this->m_grid, false);
-    auto moves = this->m_moveManager.getMoves();
-    if (moves.size() == 1 && (moves[0].Flags(MOVE_CHECK) == MOVE_CHECK)) {
-        if (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE) {
-            // Check black king if white moves
-            Piece::addFlag(&this->m_grid[this->m_blackKing], MOVE_CHECK);
-        }
-        else {
-            // Check white king if black moved
-            Piece::addFlag(&this->m_grid[this->m_whiteKing], MOVE_CHECK);
-        }
-    }
-    
-    // Determine if there are any moves than can prevent checkmate
     FLAG colour = (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE ? PLAYER_COLOUR_BLACK : PLAYER_COLOUR_WHITE);
-    this->m_moveManager.calculateMoves(colour, this->m_grid, true);
-    moves = this->m_moveManager.getMoves();
-    
 
-    int totalPieces = 0;
-    // Determine how many total pieces there are on the board
-    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        if (Piece::getFlag(this->m_grid[i], MASK_COLOUR) == colour) {
-            totalPieces++;
-        }
+    // Determines if move put the enemy king into check
+    bool check = MoveGen::inCheck(colour, this->m_grid);
+    if (check) {
+        INDEX king = (colour == PLAYER_COLOUR_WHITE ? this->m_whiteKing : this->m_blackKing);
+        Piece::addFlag(&this->m_grid[king], MASK_KING_IN_CHECK);
     }
-    // Determine if legal moves is greater than pieces
-    if ((int)this->m_moveManager.getMoves().size() > totalPieces) {
-        // More moves than pieces, theres a legal move somewhere
+
+    // Determine if there are any moves than can prevent checkmate
+    if (MoveGen::hasLegalMove(colour, this->m_grid)) {
         return;
     }
 
     // King is in check with no moves
-    if (Piece::getFlag(this->m_grid[this->m_blackKing], MOVE_CHECK) ||
-        Piece::getFlag(this->m_grid[this->m_whiteKing], MOVE_CHECK)) {
-            // CHECKMATE
-            this->m_checkmate = true;
-            std::cout << "CHECKMATE" << std::endl;
+    if (check) {
+        // CHECKMATE
+        this->m_checkmate = true;
+        std::cout << "CHECKMATE" << std::endl;
     }
     else {
         // King is not in check with no moves
         this->m_stalemate = true;
-        std::cout << Piece::getFlag(this->m_grid[this->m_whiteKing], MOVE_CHECK) << std::endl;;
         std::cout << "STALEMATE" << std::endl;
     }
 }
 
+void BoardManager::checkTablebase() {
+    // Only games the computer plays both sides of are cut short
+    if (this->m_whitePlayer.Type() != PLAYER_TYPE_BOT || this->m_blackPlayer.Type() != PLAYER_TYPE_BOT || this->m_checkmate || this->m_stalemate) {
+        return;
+    }
+    FLAG colour = (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE ? PLAYER_COLOUR_BLACK : PLAYER_COLOUR_WHITE);
+    int wdl = TABLEBASE_DRAW;
+    int plies = 0;
+    if (!this->m_tablebase.probeWDL(colour, this->m_grid, wdl) && !this->m_dtm.probe(colour, this->m_grid, wdl, plies)) {
+        return;
+    }
+
+    // Cursed wins and blessed losses are draws under the 50 move rule
+    if (wdl == TABLEBASE_WIN) {
+        this->m_adjudication = (colour == PLAYER_COLOUR_WHITE ? ARCHIVE_RESULT_WHITE : ARCHIVE_RESULT_BLACK);
+    }
+    else if (wdl == TABLEBASE_LOSS) {
+        this->m_adjudication = (colour == PLAYER_COLOUR_WHITE ? ARCHIVE_RESULT_BLACK : ARCHIVE_RESULT_WHITE);
+    }
+    else {
+        this->m_adjudication = ARCHIVE_RESULT_DRAW;
+    }
+    std::cout << "TABLEBASE " << Archive::resultString(this->m_adjudication) << std::endl;
+}
+
+POSITION BoardManager::currentPosition() {
+    POSITION position;
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        position.grid[i] = this->m_grid[i];
+        Piece::removeFlag(&position.grid[i], MASK_HELD);
+    }
+    position.colour = this->m_currentPlayer->Colour();
+    position.halfmoves = this->m_50moveRule;
+    position.fullmoves = this->m_totalTurns;
+    return position;
+}
+
+void BoardManager::showAnalysis() {
+    // Restarts as soon as the position changes, however it changed
+    POSITION position = this->currentPosition();
+    if (position.colour != this->m_analysisPosition.colour || std::memcmp(position.grid, this->m_analysisPosition.grid, sizeof(position.grid)) != 0) {
+        this->stopAnalysis();
+        this->startAnalysis();
+    }
+
+    std::vector<SEARCH_LINE> lines;
+    int depth;
+    {
+        std::lock_guard<std::mutex> lock(this->m_analysisMutex);
+        lines = this->m_analysisLines;
+        depth = this->m_analysisDepth;
+    }
+    if (lines.empty()) {
+        return;
+    }
+
+    if (depth != this->m_shownDepth) {
+        this->m_shownDepth = depth;
+        std::cout << "DEPTH " << depth << std::endl;
+        for (SEARCH_LINE& line : lines) {
+            POSITION played = position;
+            std::cout << ::scoreString(line.score);
+            for (Move move : line.moves) {
+                std::cout << " " << San::toSAN(move, played.colour, played.grid);
+                Position::play(move, played.grid);
+                played.colour = (played.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // Worst line first so the best arrow is drawn on top
+    GLfloat scale = Library::min(WindowManager::winSize()) / GRID_SIZE;
+    for (int i = (int)lines.size() - 1; i >= 0; i--) {
+        INDEX start = lines[i].moves[0].Start();
+        INDEX target = lines[i].moves[0].Target();
+        if (!this->m_whitePerspective) {
+            start = Library::flipIndex(start);
+            target = Library::flipIndex(target);
+        }
+        COLOUR best = { 0.1f, 0.45f, 0.85f };
+        COLOUR other = { 0.45f, 0.65f, 0.85f };
+        this->m_renderer.arrow((i == 0 ? best : other),
+            (start % GRID_SIZE + 0.5f) * scale, (start / GRID_SIZE + 0.5f) * scale,
+            (target % GRID_SIZE + 0.5f) * scale, (target / GRID_SIZE + 0.5f) * scale,
+            scale / (i == 0 ? 6 : 10));
+    }
+
+    // Evaluation bar along the left edge, white's share grows from white's side of the board
+    int score = (position.colour == PIECE_WHITE ? lines[0].score : -lines[0].score);
+    GLfloat share = 1.f / (1.f + std::pow(10.f, -score / (GLfloat)ANALYSIS_BAR_SCALE));
+    if (std::abs(score) >= SEARCH_MATE_BOUND) {
+        share = (score > 0 ? 1.f : 0.f);
+    }
+    int height = GRID_SIZE * scale;
+    int width = scale / 6;
+    int white = share * height;
+    COLOUR black = { 0.15f, 0.15f, 0.15f };
+    COLOUR light = { 0.95f, 0.95f, 0.95f };
+    this->m_renderer.rect(black, 0, 0, width, height);
+    this->m_renderer.rect(light, 0, (this->m_whitePerspective ? 0 : height - white), width, white);
+}
+
+void BoardManager::printMate() {
+    if (!this->m_mateSearch.valid() || this->m_mateSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    MATE_RESULT result = this->m_mateSearch.get();
+    if (result.status == MATE_NONE) {
+        std::cout << "No mate in " << MATE_MOVES << " with checks" << std::endl;
+        return;
+    }
+    if (result.status == MATE_UNKNOWN) {
+        std::cout << "No mate found in " << MATE_BOARD_NODES << " nodes" << std::endl;
+        return;
+    }
+    // Printed from the position searched, the board may have moved on since
+    POSITION position = this->m_matePosition;
+    std::cout << "MATE IN " << result.moves << ":";
+    for (Move move : result.line) {
+        std::cout << " " << San::toSAN(move, position.colour, position.grid);
+        Position::play(move, position.grid);
+        position.colour = (position.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+    std::cout << std::endl;
+}
+
 // ----- Update -----
 
 bool BoardManager::makeMove(Move& move) {
@@ -320,12 +490,6 @@ void BoardManager::clearBoard() {
         this->m_grid[i] = 0;
     }
 
-    // Reset castling rights
-    this->m_castling[BOARD_CASTLING_BLACK_KING] = false;
-    this->m_castling[BOARD_CASTLING_BLACK_QUEEN] = false;
-    this->m_castling[BOARD_CASTLING_WHITE_KING] = false;
-    this->m_castling[BOARD_CASTLING_WHITE_QUEEN] = false;
-
     // Reset move counts
     this->m_totalTurns = 0;
     this->m_50moveRule = 0;
@@ -333,266 +497,264 @@ void BoardManager::clearBoard() {
 
     // Unholds piece and clears moves
     this->m_heldPieceIndex = CODE_INVALID;
+    this->m_promotionIndex = CODE_INVALID;
+    this->m_heldTargets = BITBOARD_EMPTY;
     this->m_moveManager.clear();
 
-    // Phantom
-    this->m_phantomAttack = CODE_INVALID;
-    this->m_phantomLocation = CODE_INVALID;
-
     // Reset checkmate and stalemate
     this->m_checkmate = false;
     this->m_stalemate = false;
+    this->m_adjudication = ARCHIVE_RESULT_NONE;
+    this->m_history.clear();
 }
 
 void BoardManager::resetBoard() {
     this->clearBoard();
 
-    std::string pieceFEN = this->m_resetFEN.substr(0, this->m_resetFEN.find(' '));
-    std::string metadata = this->m_resetFEN.substr(this->m_resetFEN.find(' ') + 1);
+    // Load pieces and metadata
+    POSITION position;
+    if (!Fen::load(this->m_resetFEN, position)) {
+        Fen::load(startFEN, position);
+    }
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        this->m_grid[i] = position.grid[i];
+    }
+    this->m_currentPlayer = (position.colour == PIECE_WHITE ? &this->m_whitePlayer : &this->m_blackPlayer);
+    this->m_50moveRule = position.halfmoves;
+    this->m_totalTurns = position.fullmoves;
+    this->m_whiteKing = Position::findKing(PIECE_WHITE, this->m_grid);
+    this->m_blackKing = Position::findKing(PIECE_BLACK, this->m_grid);
+    if (this->m_network.isLoaded()) {
+        this->m_network.refresh(this->m_grid, this->m_accumulator);
+    }
+}
 
-    // Load metadata
-    this->readMetadata(metadata);
+void BoardManager::changeFlip() {
+    this->m_flipBoard = !this->m_flipBoard;
+}
 
-    // Loop through each index
-    // Starts from top left, goes to bottom right
-    int x = 0, y = GRID_SIZE - 1;
-    for (char c : pieceFEN) {
-        if (c == ' ') {
-            return;
-        }
+void BoardManager::changePerspective() {
+    this->m_whitePerspective = !this->m_whitePerspective;
+}
 
-        // Checks for rank change key
-        if (c == '/') {
-            x = 0;
-            y--;
-            continue;
-        }
+bool BoardManager::saveGame(const std::string& path) {
+    GAME game;
+    Pgn::setTag(game, "Event", "Chess-Engine game");
+    Pgn::setTag(game, "White", (this->m_whitePlayer.Type() == PLAYER_TYPE_HUMAN ? "Human" : "Computer"));
+    Pgn::setTag(game, "Black", (this->m_blackPlayer.Type() == PLAYER_TYPE_HUMAN ? "Human" : "Computer"));
 
-        // If the char is a number
-        if (isdigit(c)) {
-            x += c - '0';
-        }
-        // Determine what char it is
-        else {
-            FLAG pieceColour = (isupper(c) ? PIECE_WHITE : PIECE_BLACK);
-            FLAG pieceType = 0;
-            switch(c) {
-            case 'p':
-            case 'P':
-                pieceType = PIECE_PAWN;
-                break;
-            case 'n':
-            case 'N':
-                pieceType = PIECE_KNIGHT;
-                break;
-            case 'b':
-            case 'B':
-                pieceType = PIECE_BISHOP;
-                break;
-            case 'r':
-            case 'R':
-                pieceType = PIECE_ROOK;
-                break;
-            case 'q':
-            case 'Q':
-                pieceType = PIECE_QUEEN;
-                break;
-            case 'k':
-            case 'K':
-                pieceType = PIECE_KING;
-                break;
-            default:
-                // If type is undetermined, still increase index but move on
-                x++;
-                continue;
-            }
-            this->m_grid[y * GRID_SIZE + x] = pieceColour | pieceType;
-            x++;
-        }
+    // Result is only known if the game ended on the board
+    std::string result = "*";
+    if (this->m_checkmate) {
+        result = (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE ? "0-1" : "1-0");
     }
-    this->setMetadata();
-}
+    else if (this->m_stalemate) {
+        result = "1/2-1/2";
+    }
+    else if (this->m_adjudication != ARCHIVE_RESULT_NONE) {
+        result = Archive::resultString(this->m_adjudication);
+        Pgn::setTag(game, "Termination", "adjudication");
+    }
+    Pgn::setTag(game, "Result", result);
+    if (this->m_resetFEN != startFEN) {
+        Pgn::setTag(game, "SetUp", "1");
+        Pgn::setTag(game, "FEN", this->m_resetFEN);
+    }
+    game.moves = this->m_history;
+    game.result = result;
 
-void BoardManager::setPromotion(INDEX index) {
-    if (0 <= index && index < GRID_SIZE * GRID_SIZE)
-        this->m_promotionIndex = index;
-    else
-        this->m_promotionIndex = -1;
+    if (!Pgn::write(path, { game })) {
+        return false;
+    }
+    std::cout << "Saved game to " << path << std::endl;
+    return true;
 }
 
-void BoardManager::changeFlip() {
-    this->m_flipBoard = !this->m_flipBoard;
+bool BoardManager::loadGame(const std::string& path) {
+    GAME game;
+    bool found = false;
+    bool opened = Pgn::read(path, 1, [&](GAME& read) {
+        game = read;
+        found = true;
+        return false;
+    });
+    if (!opened || !found) {
+        std::cout << "No game to load in " << path << std::endl;
+        return false;
+    }
+
+    // Game replaces the reset position so resetting goes back to its start
+    std::string fen = Pgn::getTag(game, "FEN");
+    this->m_resetFEN = (fen.empty() ? startFEN : fen);
+    this->resetBoard();
+    for (Move& move : game.moves) {
+        this->release(move);
+        this->nextTurn();
+    }
+    std::cout << "Loaded game from " << path << std::endl;
+    return true;
 }
 
-void BoardManager::changePerspective() {
-    this->m_whitePerspective = !this->m_whitePerspective;
+void BoardManager::showGames() {
+    if (!this->m_positionIndex.isOpen()) {
+        std::cout << "No position index, build one with: Chess-Engine index <games> " << indexFile << std::endl;
+        return;
+    }
+    this->m_positionIndex.showStats(this->m_currentPlayer->Colour(), this->m_grid);
 }
 
-// ----- Update ----- Hidden -----
+void BoardManager::showBook() {
+    if (!this->m_book.isOpen()) {
+        std::cout << "No opening book, place a polyglot book at " << bookFile << std::endl;
+        return;
+    }
 
-void BoardManager::readMetadata(std::string& metadata) {
-    int currentField = 0;
-    for (size_t i = 0; i < metadata.length(); i++) {
-        // Increase field upon finding space
-        if (metadata[i] == ' ') {
-            currentField++;
-            continue;
-        }
+    std::vector<BOOK_MOVE> moves = this->m_book.getMoves(this->m_currentPlayer->Colour(), this->m_grid);
+    if (moves.empty()) {
+        std::cout << "Position is not in the book" << std::endl;
+        return;
+    }
+    for (BOOK_MOVE& move : moves) {
+        std::cout << San::toSAN(move.move, this->m_currentPlayer->Colour(), this->m_grid) << " " << move.weight << std::endl;
+    }
+}
 
-        switch (currentField) {
-        // Current move
-        case 0:
-            this->m_currentPlayer = (metadata[i] == 'w' ? &this->m_whitePlayer : &this->m_blackPlayer);
-            break;
-        // Castling rights
-        case 1:
-            switch (metadata[i]) {
-            // Black kingside
-            case 'k':
-                this->m_castling[BOARD_CASTLING_BLACK_KING] = true;
-                break;
-            // Black queensize
-            case 'q':
-                this->m_castling[BOARD_CASTLING_BLACK_QUEEN] = true;
-                break;
-            // White kingside
-            case 'K':
-                this->m_castling[BOARD_CASTLING_WHITE_KING] = true;
-                break;
-            // White queenside
-            case 'Q':
-                this->m_castling[BOARD_CASTLING_WHITE_QUEEN] = true;
-                break;
-            // No castling, continue
-            case '-':
-                // Reset castling rights
-                this->m_castling[BOARD_CASTLING_BLACK_KING] = false;
-                this->m_castling[BOARD_CASTLING_BLACK_QUEEN] = false;
-                this->m_castling[BOARD_CASTLING_WHITE_KING] = false;
-                this->m_castling[BOARD_CASTLING_WHITE_QUEEN] = false;
-                break;
-            default:
-                break;
-            }
-            break;
-        // En passent
-        case 2:
-            // If no en passent square
-            if (metadata[i] == '-') {
-                continue;
-            }
+void BoardManager::showEvaluation() {
+    if (!this->m_network.isLoaded()) {
+        std::cout << "No network, place one at " << networkFile << std::endl;
+        return;
+    }
+    // Shown from white's side like an evaluation bar
+    int score = this->m_network.evaluate(this->m_accumulator, this->m_currentPlayer->Colour());
+    if (this->m_currentPlayer->Colour() != PLAYER_COLOUR_WHITE) {
+        score = -score;
+    }
+    std::cout << "EVAL " << ::scoreString(score) << std::endl;
+}
 
-            if (metadata.length() >= i + 1) {
-                this->m_phantomLocation = metadata[i + 1] * GRID_SIZE + Library::charToInt(metadata[i]);
-                this->m_grid[this->m_phantomLocation] = PIECE_PHANTOM;
-            }
+void BoardManager::showMate() {
+    // One search at a time, its table is not shared
+    if (this->m_mateSearch.valid()) {
+        std::cout << "Still looking for a mate" << std::endl;
+        return;
+    }
+    this->m_matePosition = this->currentPosition();
+    this->m_mateSearch = std::async(std::launch::async, [this]() {
+        return this->m_mateSolver.solve(this->m_matePosition, MATE_MOVES, MATE_BOARD_NODES);
+    });
+}
+
+void BoardManager::playBot() {
+    bool over = (this->m_currentPlayer->Type() != PLAYER_TYPE_BOT || this->m_checkmate || this->m_stalemate || this->m_adjudication != ARCHIVE_RESULT_NONE);
 
-            // Increase i to account for extra positioning
-            i++;
-            break;
-        // Special move, 50 move rule
-        case 3:
-            this->m_50moveRule = metadata[i] - '0';
-            break;
-        // Total moves
-        case 4:
-            this->m_totalTurns = metadata[i] - '0';
-            break;
-        default:
-            break;
+    // A finished search is only played if nothing changed on the board while it ran
+    if (this->m_botSearch.valid()) {
+        if (this->m_botSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
         }
+        Move move = this->m_botSearch.get().move;
+        bool unchanged = (this->m_botPosition.colour == this->m_currentPlayer->Colour() &&
+            std::memcmp(this->m_botPosition.grid, this->m_grid, sizeof(this->m_grid)) == 0);
+        if (over || !unchanged || !move.isMove()) {
+            return;
+        }
+        this->release(move);
+        this->nextTurn();
+        return;
+    }
+    if (over) {
+        return;
     }
+
+    FLAG colour = this->m_currentPlayer->Colour();
+    Move move = (this->m_useMcts ? Bot::knownMove(colour, this->m_grid, &this->m_book, &this->m_tablebase, this->m_50moveRule, &this->m_dtm) :
+        Bot::chooseMove(colour, this->m_grid, &this->m_book, &this->m_tablebase, this->m_50moveRule, &this->m_dtm));
+    if (!move.isMove() && this->m_useMcts) {
+        std::memcpy(this->m_botPosition.grid, this->m_grid, sizeof(this->m_grid));
+        this->m_botPosition.colour = colour;
+        this->m_botPosition.halfmoves = this->m_50moveRule;
+        this->m_botPosition.fullmoves = this->m_totalTurns;
+        this->m_botSearch = std::async(std::launch::async, [this]() {
+            return this->m_mcts.search(this->m_botPosition, { 0, 0, MCTS_BOT_MILLISECONDS });
+        });
+        return;
+    }
+    if (!move.isMove()) {
+        return;
+    }
+    this->release(move);
+    this->nextTurn();
 }
 
-void BoardManager::setMetadata() {
-    // Adds metadata to pieces on board
-    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        FLAG pieceType = Piece::getFlag(this->m_grid[i], MASK_TYPE);
-        FLAG pieceColour = Piece::getFlag(this->m_grid[i], MASK_COLOUR);
-
-        switch (pieceType) {
-        case PIECE_PAWN: {
-                // White pawn on start square
-                int y = i / GRID_SIZE;
-                if (y == 1 && pieceColour == PIECE_WHITE) {
-                    Piece::addFlag(&this->m_grid[i], MOVE_PAWN_FIRST_MOVE);
-                }
-                else if (y == (GRID_SIZE - 2) && pieceColour == PIECE_BLACK) {
-                    Piece::addFlag(&this->m_grid[i], MOVE_PAWN_FIRST_MOVE);
-                }
-            }
-            break;
-        case PIECE_KNIGHT:
-            break;
-        case PIECE_BISHOP:
-            break;
-        case PIECE_ROOK:
-            // Queen side castling
-            if (i % GRID_SIZE == 0) {
-                Piece::addFlag(&this->m_grid[i], MOVE_ROOK_CAN_CASTLE);
-            }
-            // King side castling
-            if (i % GRID_SIZE == GRID_SIZE - 1) {
-                Piece::addFlag(&this->m_grid[i], MOVE_ROOK_CAN_CASTLE);
-            }
-            break;
-        case PIECE_QUEEN:
-            break;
-        case PIECE_KING:
-            // White meta
-            if (pieceColour == PIECE_WHITE) {
-                this->m_whiteKing = i;
-                if (this->m_castling[BOARD_CASTLING_WHITE_KING]) {
-                    Piece::addFlag(&this->m_grid[i], MOVE_KING_CASTLE_KING);
-                }
-                if (this->m_castling[BOARD_CASTLING_WHITE_QUEEN]) {
-                    Piece::addFlag(&this->m_grid[i], MOVE_KING_CASTLE_QUEEN);
-                }
-            }
-            // Black meta
-            else {
-                this->m_blackKing = i;
-                if (this->m_castling[BOARD_CASTLING_BLACK_KING]) {
-                    Piece::addFlag(&this->m_grid[i], MOVE_KING_CASTLE_KING);
-                }
-                if (this->m_castling[BOARD_CASTLING_BLACK_QUEEN]) {
-                    Piece::addFlag(&this->m_grid[i], MOVE_KING_CASTLE_QUEEN);
-                }
-            }
-            break;
-        default:
-            break;
+void BoardManager::toggleBot() {
+    // Anything held by the human is put back first
+    if (this->m_heldPieceIndex != CODE_INVALID) {
+        Move move(this->m_heldPieceIndex, this->m_heldPieceIndex);
+        this->release(move);
+    }
+    this->m_promotionIndex = CODE_INVALID;
 
-        }
+    FLAG type = (this->m_currentPlayer->Type() == PLAYER_TYPE_BOT ? PLAYER_TYPE_HUMAN : PLAYER_TYPE_BOT);
+    this->m_currentPlayer->setType(type);
+    std::cout << (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE ? "White" : "Black") << " is played by the " << (type == PLAYER_TYPE_BOT ? "computer" : "player") << std::endl;
+}
+
+void BoardManager::toggleMcts() {
+    this->m_useMcts = !this->m_useMcts;
+    if (this->m_useMcts) {
+        std::cout << "Computer searches with MCTS for " << MCTS_BOT_MILLISECONDS << " ms out of book" << std::endl;
+    }
+    else {
+        std::cout << "Computer plays random moves out of book" << std::endl;
     }
 }
 
+void BoardManager::toggleAnalysis() {
+    this->m_analysing = !this->m_analysing;
+    if (this->m_analysing) {
+        std::cout << "Analysing the best " << ANALYSIS_LINES << " lines" << std::endl;
+        this->startAnalysis();
+    }
+    else {
+        this->stopAnalysis();
+        std::cout << "Analysis stopped" << std::endl;
+    }
+}
+
+// ----- Update ----- Hidden -----
+
 void BoardManager::promotionSelection(INDEX index) {
     // Holds value for checking next index
     int checkValue = ((this->m_promotionIndex / GRID_SIZE) == 0 ? GRID_SIZE : (-GRID_SIZE));
 
     // Determine if valid option was clicked
-    FLAG colour = Piece::getFlag(this->m_grid[this->m_promotionIndex], MASK_COLOUR);
+    FLAG type = PIECE_INVALID;
     // Top/Bottom - Queen
     if (index == this->m_promotionIndex) {
-        this->m_grid[this->m_promotionIndex] = PIECE_QUEEN | colour;
-        this->m_promotionIndex = CODE_INVALID;
+        type = PIECE_QUEEN;
     }
     // Second - Rook
     else if (index == this->m_promotionIndex + checkValue) {
-        this->m_grid[this->m_promotionIndex] = PIECE_ROOK | colour;
-        this->m_promotionIndex = CODE_INVALID;
+        type = PIECE_ROOK;
     }
     // Third - Bishop
     else if (index == this->m_promotionIndex + (2 * checkValue)) {
-        this->m_grid[this->m_promotionIndex] = PIECE_BISHOP | colour;
-        this->m_promotionIndex = CODE_INVALID;
+        type = PIECE_BISHOP;
     }
     // Bottom/Top - Knight
     else if (index == this->m_promotionIndex + (3 * checkValue)) {
-        this->m_grid[this->m_promotionIndex] = PIECE_KNIGHT | colour;
-        this->m_promotionIndex = CODE_INVALID;
+        type = PIECE_KNIGHT;
+    }
+
+    // Options are closed either way, a missed click leaves the pawn held
+    this->m_promotionIndex = CODE_INVALID;
+    if (type == PIECE_INVALID) {
+        return;
     }
+
+    this->m_promotionMove.setPromotion(type);
+    this->release(this->m_promotionMove);
+    this->nextTurn();
 }
 
 void BoardManager::hold(INDEX index) {
@@ -608,23 +770,42 @@ void BoardManager::hold(INDEX index) {
         this->m_moveManager.calculateMoves(this->m_currentPlayer->Colour(), this->m_grid, true);
         this->m_calculated = true;
     }
+
+    // Targets only change when a move is made, so they are stored for rendering and input
+    this->m_heldTargets = this->m_moveManager.getTargets(index);
 }
 
 void BoardManager::release(Move& move) {
-    // Put held piece down on specified square
-    PIECE piece = this->m_grid[this->m_heldPieceIndex];
-    Piece::removeFlag(&piece, MASK_HELD);
-    this->m_grid[move.Target()] = piece;
-    
+    // Put held piece down
+    Piece::removeFlag(&this->m_grid[move.Start()], MASK_HELD);
+    this->m_heldPieceIndex = CODE_INVALID;
+    this->m_heldTargets = BITBOARD_EMPTY;
+
     // Make sure not to delete piece if it was not moved
-    if (move.Start() != move.Target()) {
-        // First, unchecks kings
-        Piece::removeFlag(&this->m_grid[this->m_whiteKing], MOVE_CHECK);
-        Piece::removeFlag(&this->m_grid[this->m_blackKing], MOVE_CHECK);
-        this->m_grid[move.Start()] = PIECE_INVALID;
+    if (move.Start() == move.Target()) {
+        return;
     }
 
+    // First, unchecks kings
+    Piece::removeFlag(&this->m_grid[this->m_whiteKing], MASK_KING_IN_CHECK);
+    Piece::removeFlag(&this->m_grid[this->m_blackKing], MASK_KING_IN_CHECK);
+
+    // Pawn moves and captures reset the 50 move rule, black moving finishes a turn
+    bool pawnMove = (Piece::getFlag(this->m_grid[move.Start()], MASK_TYPE) == PIECE_PAWN);
+    this->m_50moveRule = (pawnMove || move.isCapture() ? 0 : this->m_50moveRule + 1);
+    if (Piece::getFlag(this->m_grid[move.Start()], MASK_COLOUR) == PIECE_BLACK) {
+        this->m_totalTurns++;
+    }
+    this->m_history.push_back(move);
+
+    // Moves the piece, along with any castling rook, en passant capture or promotion
+    if (this->m_network.isLoaded()) {
+        this->m_network.update(move, this->m_grid, this->m_accumulator, this->m_accumulator);
+    }
+    Position::play(move, this->m_grid);
+
     // Move king position
+    PIECE piece = this->m_grid[move.Target()];
     if (Piece::getFlag(piece, MASK_TYPE) == PIECE_KING) {
         if (Piece::getFlag(piece, MASK_COLOUR) == PIECE_WHITE) {
             this->m_whiteKing = move.Target();
@@ -633,68 +814,67 @@ void BoardManager::release(Move& move) {
             this->m_blackKing = move.Target();
         }
     }
-    
-    // Deal with phantom
-    this->managePhantom(move);
 
     // Check if move put king into check
-    if (move.Start() != move.Target()) {
-        this->checkCheckmate(move);
-    }
+    this->checkCheckmate(move);
+    this->checkTablebase();
     
     // Clear old data
-    this->m_heldPieceIndex = CODE_INVALID;
-    if (move.Start() != move.Target()) {
-        this->m_moveManager.clear();
-        this->m_calculated = false;
-    }
+    this->m_moveManager.clear();
+    this->m_calculated = false;
+}
 
-    if (move.Start() != move.Target()) {
-        Piece::removeFlags(move.Target(), this->m_grid);
+void BoardManager::nextTurn() {
+    this->m_currentPlayer = (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE ? &this->m_blackPlayer : &this->m_whitePlayer);
+    // Allows board to flip
+    if (this->m_flipBoard) {
+        this->m_whitePerspective = (this->m_currentPlayer->Colour() == PLAYER_COLOUR_WHITE ? true : false);
     }
 }
 
-void BoardManager::managePhantom(Move move) {
-    INDEX target = move.Target();
+void BoardManager::startAnalysis() {
+    // Created on first use so boards that never analyse do not hold a hash table
+    if (!this->m_analysis) {
+        this->m_analysis.reset(new Search(SEARCH_HASH_MEGABYTES, &this->m_network));
+    }
+    this->m_analysisPosition = this->currentPosition();
+    this->m_analysisLines.clear();
+    this->m_analysisDepth = 0;
+    this->m_shownDepth = 0;
+
+    // Positions since the reset FEN, for finding repetitions
+    std::vector<HASH> history;
+    POSITION replay;
+    if (!Fen::load(this->m_resetFEN, replay)) {
+        Fen::load(startFEN, replay);
+    }
+    for (Move move : this->m_history) {
+        history.push_back(Zobrist::hash(replay.colour, replay.grid));
+        Position::play(move, replay.grid);
+        replay.colour = (replay.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+
+    this->m_analysisStop = false;
+    this->m_analysisThread = std::thread([this, history]() {
+        this->m_analysis->analyse(this->m_analysisPosition, history, ANALYSIS_LINES, this->m_analysisStop, [this](const std::vector<SEARCH_LINE>& lines, int depth) {
+            std::lock_guard<std::mutex> lock(this->m_analysisMutex);
+            this->m_analysisLines = lines;
+            this->m_analysisDepth = depth;
+        });
+    });
+}
 
-    // Check if pawn in on phantom square
-    FLAG type = Piece::getFlag(this->m_grid[target], MASK_TYPE);
-    if (type == PIECE_PAWN && target == this->m_phantomLocation) {
-        this->m_grid[m_phantomAttack] = PIECE_INVALID;
-    }
-    
-    // Remove phantom always
-    if (this->m_phantomLocation != CODE_INVALID) {
-        if (this->m_grid[this->m_phantomLocation] == PIECE_PHANTOM) {
-            this->m_grid[m_phantomLocation] = PIECE_INVALID;
-        }
-        this->m_phantomLocation = CODE_INVALID;
-        this->m_phantomAttack = CODE_INVALID;
-    }
-
-    // Check if pawn
-    if (Piece::getFlag(this->m_grid[target], MASK_TYPE) == PIECE_PAWN) {
-        // Check if phantom should be created
-        FLAG moveTwo = (move.Flags() & MOVE_PAWN_MOVE_TWO);
-        if (moveTwo) {
-            FLAG colour = Piece::getFlag(this->m_grid[target], MASK_COLOUR);
-            // White side phantom
-            if (colour == PIECE_WHITE) {
-                this->m_phantomLocation = target - GRID_SIZE;
-            }
-            // Black side phantom
-            else {
-                this->m_phantomLocation = target + GRID_SIZE;
-            }
-            this->m_phantomAttack = target;
-            this->m_grid[m_phantomLocation] = PIECE_PHANTOM;
-        }
+void BoardManager::stopAnalysis() {
+    if (!this->m_analysisThread.joinable()) {
+        return;
     }
+    this->m_analysisStop = true;
+    this->m_analysisThread.join();
 }
 
 //  ----- Destruction -----
 
 BoardManager::~BoardManager() {
-    // Nothing todo
+    this->stopAnalysis();
 }
 
@@ -0,0 +1,428 @@
+#include "Book.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <unordered_map>
+
+#include "Archive.h"
+#include "MoveGen.h"
+#include "Piece.h"
+#include "Position.h"
+#include "Threads.h"
+
+namespace {
+
+    // How often a move was played from a position and what it scored, in half points for the side to move
+    typedef struct bookCountHolder {
+        HASH key;
+        unsigned short move;
+        unsigned int games;
+        unsigned int score;
+    } BOOK_COUNT;
+
+    typedef struct bookKeyHolder {
+        HASH key;
+        unsigned short move;
+
+        bool operator==(const bookKeyHolder& other) const {
+            return (key == other.key && move == other.move);
+        }
+    } BOOK_KEY;
+
+    struct bookKeyHash {
+        size_t operator()(const BOOK_KEY& key) const {
+            return (size_t)(key.key ^ ((HASH)key.move * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    bool countLess(const BOOK_COUNT& a, const BOOK_COUNT& b) {
+        return (a.key != b.key ? a.key < b.key : a.move < b.move);
+    }
+
+    // Polyglot writes castling as the king taking its own rook
+    unsigned short bookMove(Move move) {
+        INDEX start = move.Start();
+        INDEX target = move.Target();
+        if (move.Kind() == MOVE_CASTLE_KING) {
+            target = start + 3;
+        }
+        else if (move.Kind() == MOVE_CASTLE_QUEEN) {
+            target = start - 4;
+        }
+        FLAG promotion = (move.isPromotion() ? move.Promotion() - PIECE_PAWN : 0);
+        return (unsigned short)(target | (start << 6) | (promotion << 12));
+    }
+
+    void writeBigEndian(unsigned char* data, unsigned long long value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            data[i] = (unsigned char)(value >> (8 * (bytes - 1 - i)));
+        }
+    }
+
+    unsigned long long readBigEndian(const unsigned char* data, int bytes) {
+        unsigned long long value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value = (value << 8) | data[i];
+        }
+        return value;
+    }
+
+    // Castling is stored as the king capturing its own rook
+    INDEX castlingTarget(INDEX start, INDEX target, const PIECE* grid) {
+        if (Piece::getFlag(grid[start], MASK_TYPE) != PIECE_KING || start % GRID_SIZE != GRID_SIZE / 2 || start / GRID_SIZE != target / GRID_SIZE) {
+            return target;
+        }
+        if (target % GRID_SIZE == GRID_SIZE - 1) {
+            return start + 2;
+        }
+        if (target % GRID_SIZE == 0) {
+            return start - 2;
+        }
+        return target;
+    }
+
+    typedef std::unordered_map<BOOK_KEY, BOOK_COUNT, bookKeyHash> BOOK_TABLE;
+
+    // Sorts the table's counts into a temporary file and empties the table, the file only lives until the book is written
+    bool writeRun(BOOK_TABLE& table, const std::string& path) {
+        std::vector<BOOK_COUNT> counts;
+        counts.reserve(table.size());
+        for (std::pair<const BOOK_KEY, BOOK_COUNT>& count : table) {
+            counts.push_back(count.second);
+        }
+        BOOK_TABLE().swap(table);
+        std::sort(counts.begin(), counts.end(), ::countLess);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write((const char*)counts.data(), counts.size() * sizeof(BOOK_COUNT));
+        if (!file) {
+            std::cout << "Could not write file: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Reads a run back one count at a time
+    typedef struct bookRunHolder {
+        std::ifstream file;
+        BOOK_COUNT count;
+
+        bool next() {
+            return (bool)file.read((char*)&count, sizeof(BOOK_COUNT));
+        }
+    } BOOK_RUN;
+
+    // Writes one position's moves best first, moves that never scored are left out like polyglot does
+    void writePosition(std::ofstream& file, const std::vector<BOOK_COUNT>& counts, int minGames) {
+        unsigned int best = 0;
+        for (const BOOK_COUNT& count : counts) {
+            if ((int)count.games >= minGames) {
+                best = std::max(best, count.score);
+            }
+        }
+
+        // Scores become weights in place
+        std::vector<BOOK_COUNT> moves;
+        for (const BOOK_COUNT& count : counts) {
+            if ((int)count.games < minGames || count.score == 0) {
+                continue;
+            }
+            BOOK_COUNT move = count;
+            if (best > BOOK_MAX_WEIGHT) {
+                move.score = std::max(1U, (unsigned int)((unsigned long long)move.score * BOOK_MAX_WEIGHT / best));
+            }
+            moves.push_back(move);
+        }
+        std::stable_sort(moves.begin(), moves.end(), [](const BOOK_COUNT& a, const BOOK_COUNT& b) {
+            return a.score > b.score;
+        });
+
+        for (BOOK_COUNT& move : moves) {
+            unsigned char entry[BOOK_ENTRY_SIZE] = {};
+            ::writeBigEndian(entry, move.key, 8);
+            ::writeBigEndian(entry + 8, move.move, 2);
+            ::writeBigEndian(entry + 10, move.score, 2);
+            file.write((const char*)entry, BOOK_ENTRY_SIZE);
+        }
+    }
+
+    // Merges the sorted runs into the book, only the smallest count of each run and one position's moves are held at once
+    bool writeBook(const std::vector<std::string>& paths, const std::string& output, int minGames) {
+        std::vector<std::unique_ptr<BOOK_RUN>> runs;
+        for (const std::string& path : paths) {
+            runs.emplace_back(new BOOK_RUN());
+            runs.back()->file.open(path, std::ios::binary);
+            if (!runs.back()->file) {
+                std::cout << "Could not open file: " << path << std::endl;
+                return false;
+            }
+        }
+        std::ofstream file(output, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cout << "Could not open file: " << output << std::endl;
+            return false;
+        }
+
+        // Smallest count first
+        auto later = [&](size_t a, size_t b) { return ::countLess(runs[b]->count, runs[a]->count); };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(later)> next(later);
+        for (size_t i = 0; i < runs.size(); i++) {
+            if (runs[i]->next()) {
+                next.push(i);
+            }
+        }
+
+        std::vector<BOOK_COUNT> position;
+        while (!next.empty()) {
+            size_t run = next.top();
+            next.pop();
+            BOOK_COUNT count = runs[run]->count;
+            if (runs[run]->next()) {
+                next.push(run);
+            }
+
+            if (!position.empty() && position.back().key == count.key && position.back().move == count.move) {
+                position.back().games += count.games;
+                position.back().score += count.score;
+                continue;
+            }
+            if (!position.empty() && position.back().key != count.key) {
+                ::writePosition(file, position, minGames);
+                position.clear();
+            }
+            position.push_back(count);
+        }
+        if (!position.empty()) {
+            ::writePosition(file, position, minGames);
+        }
+        return (bool)file;
+    }
+
+}
+
+// ----- Creation -----
+
+Book::Book() {
+    this->m_entries = nullptr;
+    this->m_count = 0;
+    this->m_keys = Zobrist::polyglotKeys;
+}
+
+bool Book::open(const std::string& path, const Zobrist::KEY_TABLE& keys) {
+    this->m_entries = nullptr;
+    this->m_count = 0;
+    if (!this->m_file.open(path)) {
+        return false;
+    }
+    if (this->m_file.Size() % BOOK_ENTRY_SIZE) {
+        std::cout << "Not a polyglot book: " << path << std::endl;
+        this->m_file.close();
+        return false;
+    }
+
+    this->m_entries = (const unsigned char*)this->m_file.Data();
+    this->m_count = this->m_file.Size() / BOOK_ENTRY_SIZE;
+    this->m_keys = keys;
+    return true;
+}
+
+bool Book::loadKeys(const std::string& path, Zobrist::KEY_TABLE& keys) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "Could not open keys: " << path << std::endl;
+        return false;
+    }
+
+    // Hex digits are collected until something else ends the number
+    int found = 0;
+    std::string digits;
+    char c;
+    auto endNumber = [&]() {
+        if (digits.size() == 16 && found < ZOBRIST_KEYS) {
+            keys.keys[found++] = std::stoull(digits, nullptr, 16);
+        }
+        digits.clear();
+    };
+    while (file.get(c)) {
+        if (isxdigit((unsigned char)c)) {
+            digits += c;
+        }
+        // Skips the x of a 0x prefix
+        else if ((c == 'x' || c == 'X') && digits == "0") {
+            digits.clear();
+        }
+        else {
+            endNumber();
+        }
+    }
+    endNumber();
+
+    if (found != ZOBRIST_KEYS) {
+        std::cout << "Expected " << ZOBRIST_KEYS << " keys in " << path << ", found " << found << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Book::build(const std::string& input, const std::string& output, const Zobrist::KEY_TABLE& keys, int threads, int maxPly, int minGames) {
+    threads = std::max(threads, 1);
+
+    // Each thread counts into its own table, so nothing is shared while games are read
+    // A full table is written out as a sorted run, so memory stays the same however many games there are
+    std::vector<BOOK_TABLE> tables(threads);
+    std::vector<std::string> runs;
+    std::mutex runMutex;
+    std::atomic<bool> failed(false);
+    auto addRun = [&](BOOK_TABLE& table) {
+        if (table.empty()) {
+            return;
+        }
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(runMutex);
+            path = output + ".run" + std::to_string(runs.size());
+            runs.push_back(path);
+        }
+        if (!::writeRun(table, path)) {
+            failed = true;
+        }
+    };
+
+    bool read = Archive::forEachGame(input, threads, (maxPly > 0 ? maxPly : 0), [&](const GAME& game, size_t, int thread) {
+        FLAG result = Archive::resultCode(game.result);
+        POSITION position;
+        if (result == ARCHIVE_RESULT_NONE || !Pgn::startPosition(game, position) || failed) {
+            return;
+        }
+
+        BOOK_TABLE& table = tables[thread];
+        for (size_t ply = 0; ply < game.moves.size() && (maxPly <= 0 || (int)ply < maxPly); ply++) {
+            Move move = game.moves[ply];
+            BOOK_KEY key = { Zobrist::hash(position.colour, position.grid, keys), ::bookMove(move) };
+            BOOK_COUNT& count = table[key];
+            count.key = key.key;
+            count.move = key.move;
+            count.games++;
+            if (result == ARCHIVE_RESULT_DRAW) {
+                count.score += 1;
+            }
+            else if ((result == ARCHIVE_RESULT_WHITE) == (position.colour == PIECE_WHITE)) {
+                count.score += 2;
+            }
+
+            Position::play(move, position.grid);
+            position.colour = (position.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+        }
+        if (table.size() >= BOOK_BUILD_RUN_PAIRS) {
+            addRun(table);
+        }
+    });
+    Threads::parallelFor(tables.size(), threads, [&](size_t index, int) {
+        addRun(tables[index]);
+    });
+
+    // Runs are merged a count at a time, adding up pairs found in more than one, and written a position at a time
+    bool written = (read && !failed);
+    if (written) {
+        written = ::writeBook(runs, output, minGames);
+    }
+    for (const std::string& run : runs) {
+        std::error_code error;
+        std::filesystem::remove(run, error);
+    }
+    return written;
+}
+
+// ----- Read -----
+
+bool Book::isOpen() const {
+    return (this->m_entries != nullptr);
+}
+
+size_t Book::Count() const {
+    return this->m_count;
+}
+
+HASH Book::getKey(FLAG colour, const PIECE* grid) const {
+    return Zobrist::hash(colour, grid, this->m_keys);
+}
+
+std::vector<BOOK_MOVE> Book::getMoves(FLAG colour, const PIECE* grid) const {
+    std::vector<BOOK_MOVE> moves;
+    if (!this->m_entries) {
+        return moves;
+    }
+
+    // Binary search for the first entry with the key
+    HASH key = this->getKey(colour, grid);
+    size_t low = 0, high = this->m_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (::readBigEndian(this->m_entries + middle * BOOK_ENTRY_SIZE, 8) < key) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    // Book moves are checked against the legal moves in case of a key collision
+    std::vector<Move> legal;
+    for (size_t i = low; i < this->m_count; i++) {
+        const unsigned char* entry = this->m_entries + i * BOOK_ENTRY_SIZE;
+        if (::readBigEndian(entry, 8) != key) {
+            break;
+        }
+        if (legal.empty()) {
+            legal = MoveGen::generate(colour, grid, true);
+        }
+
+        int data = (int)::readBigEndian(entry + 8, 2);
+        INDEX start = (data & MASK_BOOK_START) >> 6;
+        INDEX target = ::castlingTarget(start, data & MASK_BOOK_TARGET, grid);
+        FLAG promotion = (data & MASK_BOOK_PROMOTION) >> 12;
+        promotion = (promotion ? promotion + PIECE_PAWN : PIECE_INVALID);
+
+        Move move = Position::createMove(start, target, promotion, grid);
+        for (Move& check : legal) {
+            if (check.Start() == move.Start() && check.Target() == move.Target() && check.Kind() == move.Kind()) {
+                moves.push_back({ move, (int)::readBigEndian(entry + 10, 2) });
+                break;
+            }
+        }
+    }
+    return moves;
+}
+
+Move Book::pickMove(FLAG colour, const PIECE* grid) const {
+    std::vector<BOOK_MOVE> moves = this->getMoves(colour, grid);
+    if (moves.empty()) {
+        return Move();
+    }
+
+    // Moves with no weight are only played if every move has no weight
+    int total = 0;
+    for (BOOK_MOVE& move : moves) {
+        total += move.weight;
+    }
+    thread_local std::mt19937 random(std::random_device{}());
+    if (total == 0) {
+        return moves[random() % moves.size()].move;
+    }
+    int pick = (int)(random() % total);
+    for (BOOK_MOVE& move : moves) {
+        pick -= move.weight;
+        if (pick < 0) {
+            return move.move;
+        }
+    }
+    return moves.back().move;
+}
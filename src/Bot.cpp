@@ -0,0 +1,45 @@
+#include "Bot.h"
+
+#include <random>
+
+#include "MoveGen.h"
+
+Move Bot::knownMove(FLAG colour, const PIECE* grid, const Book* book, const Tablebase* tablebase, int halfmoves, const DtmTablebase* dtm) {
+    if (tablebase && tablebase->canProbe(grid)) {
+        int wdl = TABLEBASE_DRAW;
+        Move move = tablebase->bestMove(colour, grid, halfmoves, wdl);
+        if (move.isMove()) {
+            return move;
+        }
+    }
+    // Generated tables mate fastest but know nothing of the 50 move rule, so Syzygy is asked first
+    if (dtm && dtm->canProbe(grid)) {
+        int wdl = TABLEBASE_DRAW, plies = 0;
+        Move move = dtm->bestMove(colour, grid, wdl, plies);
+        if (move.isMove()) {
+            return move;
+        }
+    }
+    if (book && book->isOpen()) {
+        Move move = book->pickMove(colour, grid);
+        if (move.isMove()) {
+            return move;
+        }
+    }
+    return Move();
+}
+
+Move Bot::chooseMove(FLAG colour, const PIECE* grid, const Book* book, const Tablebase* tablebase, int halfmoves, const DtmTablebase* dtm) {
+    Move move = Bot::knownMove(colour, grid, book, tablebase, halfmoves, dtm);
+    if (move.isMove()) {
+        return move;
+    }
+
+    // Out of book the bot plays any legal move, unless the board searches with Mcts instead
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+    if (moves.empty()) {
+        return Move();
+    }
+    thread_local std::mt19937 random(std::random_device{}());
+    return moves[random() % moves.size()];
+}
@@ -0,0 +1,1361 @@
+#include "Console.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include "Archive.h"
+#include "Book.h"
+#include "Datagen.h"
+#include "Defines.h"
+#include "DtmTablebase.h"
+#include "Epd.h"
+#include "Fen.h"
+#include "MateSolver.h"
+#include "Mcts.h"
+#include "MoveGen.h"
+#include "Nnue.h"
+#include "Packed.h"
+#include "Pgn.h"
+#include "Piece.h"
+#include "PositionIndex.h"
+#include "Perft.h"
+#include "San.h"
+#include "Search.h"
+#include "Spsa.h"
+#include "Tablebase.h"
+#include "Threads.h"
+#include "Tuner.h"
+
+namespace {
+
+    // Prints all commands to console
+    void showHelp() {
+        std::cout << "perft <depth> [fen] [-t threads] [-h megabytes]: Count leaf positions at depth" << std::endl;
+        std::cout << "divide <depth> [fen]: Count leaf positions under each root move" << std::endl;
+        std::cout << "epd <file> [-t threads]: Load every position in an EPD file" << std::endl;
+        std::cout << "pack <epd> <output>: Convert an EPD file to packed binary positions" << std::endl;
+        std::cout << "unpack <file> <output>: Convert packed binary positions to an EPD file" << std::endl;
+        std::cout << "pgn <file> [-t threads] [-o output]: Read every game in a PGN file, optionally writing them back out" << std::endl;
+        std::cout << "archive <pgn> <output>: Store every game in a PGN file as a game archive" << std::endl;
+        std::cout << "unarchive <archive> <output> [game]: Write the games in an archive, or just one of them, as PGN" << std::endl;
+        std::cout << "index <games> <output> [-t threads] [-p plies]: Index every position in a PGN file or game archive" << std::endl;
+        std::cout << "query <index> [fen]: Show the games and moves that reached a position" << std::endl;
+        std::cout << "book <book> [fen] [-k keys]: Show the moves a polyglot book has for a position, -k reads other keys than polyglot's" << std::endl;
+        std::cout << "probe [fen] [-d directories]: Show the tablebase result and best move for a position" << std::endl;
+        std::cout << "bookbuild <games> <output> [-t threads] [-p plies] [-m min games] [-k keys]: Build a polyglot book from a PGN file or game archive, keyed with polyglot's keys unless -k reads others" << std::endl;
+        std::cout << "tbgen <material> [-d directory] [-t threads]: Generate distance to mate tables for material such as KRvK" << std::endl;
+        std::cout << "dtm [fen] [-d directory]: Show the distance to mate and best move from generated tables" << std::endl;
+        std::cout << "tbcheck <material> [-d directories] [-g directory] [-t threads]: Check every Syzygy WDL and DTZ value of the material against tables generated by tbgen" << std::endl;
+        std::cout << "eval [fen] [-n network] [-k avx2|sse2|scalar] [-b evaluations]: Show the network's evaluation, optionally timing incremental evaluations" << std::endl;
+        std::cout << "search [fen] [-d depth] [-m nodes] [-l milliseconds] [-n network] [-c checkpoint]: Search a position and show the best move, -c uses the parameters from spsa" << std::endl;
+        std::cout << "mcts [fen] [-l milliseconds] [-m playouts] [-t threads] [-e]: Search a position with MCTS and show the best move and playouts per second, -e scores leaves without playouts" << std::endl;
+        std::cout << "versus [-g games] [-l milliseconds] [-r random plies] [-t threads] [-s seed] [-e]: Play MCTS against the alpha beta search with the same time for each move" << std::endl;
+        std::cout << "mate [fen] [-u moves] [-m nodes] [-a]: Find the shortest mate in up to u moves or prove there is none, -a tries every attacking move instead of only checks" << std::endl;
+        std::cout << "mates <epd> [-u moves] [-m nodes] [-a] [-t threads] [-o output]: Solve every position in an EPD file, optionally writing them with dm and bm operations" << std::endl;
+        std::cout << "datagen <output> [-g games] [-d depth] [-m nodes] [-r random plies] [-t threads] [-n network] [-s seed]: Play self play games and store their positions, scores and results" << std::endl;
+        std::cout << "spsa <checkpoint> [-i iterations] [-p pairs] [-d depth] [-m nodes] [-r random plies] [-t threads] [-a rate] [-n network] [-s seed]: Tune the search parameters by playing perturbed searches against each other, resuming from the checkpoint if it exists" << std::endl;
+        std::cout << "tune <data> [-o output] [-e epochs] [-t threads] [-r rate] [-l lambda]: Tune the evaluation weights on datagen records and write them as a header" << std::endl;
+        std::cout << "score <epd> [-n network] [-t threads] [-o output] [-c]: Evaluate every position in an EPD file in batches, -c also times them one at a time" << std::endl;
+        std::cout << std::endl;
+    }
+
+    // Loads the FEN at argv[index], or the start position if there is none
+    // The FEN can also be the name of one of the positions in Defines.h
+    // Returns false if the FEN is invalid, which Fen::load has already reported
+    bool loadPosition(int argc, char** argv, int index, POSITION& position) {
+        std::string fen = (index < argc ? argv[index] : startFEN);
+        if (fen == "startFEN") {
+            fen = startFEN;
+        }
+        else if (fen == "testFEN1") {
+            fen = testFEN1;
+        }
+        else if (fen == "testFEN2") {
+            fen = testFEN2;
+        }
+        return Fen::load(fen, position);
+    }
+
+    int runPerft(int argc, char** argv, bool divide) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        int depth = std::atoi(argv[2]);
+
+        // Options can come before or after the FEN
+        int threads = Threads::available();
+        int hashMegabytes = PERFT_HASH_MEGABYTES;
+        int fenIndex = argc;
+        for (int i = 3; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-t" && i + 1 < argc) {
+                threads = std::atoi(argv[++i]);
+            }
+            else if (argument == "-h" && i + 1 < argc) {
+                hashMegabytes = std::atoi(argv[++i]);
+            }
+            else {
+                fenIndex = i;
+            }
+        }
+        POSITION position;
+        if (!::loadPosition(argc, argv, fenIndex, position)) {
+            return EXIT_FAILURE;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        unsigned long long nodes;
+        if (divide) {
+            nodes = Perft::divide(position.colour, position.grid, depth);
+        }
+        else {
+            nodes = Perft::perft(position.colour, position.grid, depth, threads, hashMegabytes);
+            std::cout << "Nodes: " << nodes << std::endl;
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+        std::cout << "Time: " << time.count() << "s" << std::endl;
+        if (time.count() > 0) {
+            std::cout << "Nodes/s: " << (unsigned long long)(nodes / time.count()) << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    int runEpd(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        int threads = Threads::available();
+        if (argc > 4 && std::string(argv[3]) == "-t") {
+            threads = std::atoi(argv[4]);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<POSITION> positions;
+        if (!Epd::load(argv[2], positions, threads)) {
+            return EXIT_FAILURE;
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+        std::cout << "Positions: " << positions.size() << std::endl;
+        std::cout << "Time: " << time.count() << "s" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runPack(int argc, char** argv, bool pack) {
+        if (argc < 4) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+
+        std::vector<POSITION> positions;
+        if (pack) {
+            if (!Epd::load(argv[2], positions, Threads::available()) || !Packed::write(argv[3], positions)) {
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            if (!Packed::read(argv[2], positions, Threads::available())) {
+                return EXIT_FAILURE;
+            }
+            std::ofstream file(argv[3]);
+            for (POSITION& position : positions) {
+                std::string fen = Fen::toFEN(position);
+                // EPD has no clocks
+                file << fen.substr(0, fen.rfind(' ', fen.rfind(' ') - 1)) << '\n';
+            }
+        }
+
+        std::cout << "Positions: " << positions.size() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runPgn(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        int threads = Threads::available();
+        std::string output;
+        for (int i = 3; i + 1 < argc; i += 2) {
+            std::string argument = argv[i];
+            if (argument == "-t") {
+                threads = std::atoi(argv[i + 1]);
+            }
+            else if (argument == "-o") {
+                output = argv[i + 1];
+            }
+        }
+        if (!output.empty() && !Pgn::write(output, {})) {
+            return EXIT_FAILURE;
+        }
+
+        // Games are written as they are read so the whole file is never in memory
+        auto start = std::chrono::steady_clock::now();
+        unsigned long long games = 0, plies = 0;
+        std::vector<GAME> batch;
+        bool success = Pgn::read(argv[2], threads, [&](GAME& game) {
+            games++;
+            plies += game.moves.size();
+            if (!output.empty()) {
+                batch.push_back(game);
+                if (batch.size() == 1024) {
+                    Pgn::write(output, batch, true);
+                    batch.clear();
+                }
+            }
+            return true;
+        });
+        if (!output.empty()) {
+            Pgn::write(output, batch, true);
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+        std::cout << "Games: " << games << std::endl;
+        std::cout << "Plies: " << plies << std::endl;
+        std::cout << "Time: " << time.count() << "s" << std::endl;
+        return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int runArchive(int argc, char** argv) {
+        if (argc < 4) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        ArchiveWriter writer;
+        if (!writer.open(argv[3])) {
+            return EXIT_FAILURE;
+        }
+
+        // Batches of games are encoded across threads, then written in order
+        int threads = Threads::available();
+        unsigned long long games = 0, skipped = 0;
+        std::vector<GAME> batch;
+        auto flush = [&]() {
+            std::vector<std::vector<unsigned char>> encoded(batch.size());
+            std::vector<char> valid(batch.size());
+            Threads::parallelFor(batch.size(), threads, [&](size_t index, int) {
+                valid[index] = Archive::encode(batch[index], encoded[index]);
+            });
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (valid[i]) {
+                    writer.addEncoded(encoded[i]);
+                    games++;
+                }
+                else {
+                    skipped++;
+                }
+            }
+            batch.clear();
+        };
+
+        bool success = Pgn::read(argv[2], threads, [&](GAME& game) {
+            batch.push_back(game);
+            if (batch.size() == 4096) {
+                flush();
+            }
+            return true;
+        });
+        flush();
+        success &= writer.close();
+
+        std::cout << "Games: " << games << std::endl;
+        if (skipped) {
+            std::cout << "Skipped: " << skipped << std::endl;
+        }
+        return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int runUnarchive(int argc, char** argv) {
+        if (argc < 4) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        ArchiveReader reader;
+        if (!reader.open(argv[2]) || !Pgn::write(argv[3], {})) {
+            return EXIT_FAILURE;
+        }
+
+        // Games are looked up by number through the index
+        size_t first = (argc > 4 ? std::atoll(argv[4]) : 0);
+        size_t last = (argc > 4 ? first + 1 : reader.Count());
+        std::vector<GAME> batch;
+        for (size_t i = first; i < last; i++) {
+            GAME game;
+            if (!reader.getGame(i, game)) {
+                std::cout << "Game " << i << " could not be read" << std::endl;
+                return EXIT_FAILURE;
+            }
+            batch.push_back(game);
+            if (batch.size() == 1024 || i + 1 == last) {
+                Pgn::write(argv[3], batch, true);
+                batch.clear();
+            }
+        }
+
+        std::cout << "Games: " << last - first << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runIndex(int argc, char** argv) {
+        if (argc < 4) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        int threads = Threads::available();
+        int plies = 0;
+        for (int i = 4; i + 1 < argc; i += 2) {
+            std::string argument = argv[i];
+            if (argument == "-t") {
+                threads = std::atoi(argv[i + 1]);
+            }
+            else if (argument == "-p") {
+                plies = std::atoi(argv[i + 1]);
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (!PositionIndex::build(argv[2], argv[3], threads, plies)) {
+            return EXIT_FAILURE;
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+        PositionIndex index;
+        index.open(argv[3]);
+        std::cout << "Positions: " << index.Count() << std::endl;
+        std::cout << "Time: " << time.count() << "s" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runQuery(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        PositionIndex index;
+        if (!index.open(argv[2])) {
+            std::cout << "Could not open index: " << argv[2] << std::endl;
+            return EXIT_FAILURE;
+        }
+        POSITION position;
+        if (!::loadPosition(argc, argv, 3, position)) {
+            return EXIT_FAILURE;
+        }
+        index.showStats(position.colour, position.grid);
+        return EXIT_SUCCESS;
+    }
+
+    // Uses polyglot's keys, or reads them from path when -k gives one
+    bool loadKeys(const std::string& path, Zobrist::KEY_TABLE& keys) {
+        keys = Zobrist::polyglotKeys;
+        return (path.empty() || Book::loadKeys(path, keys));
+    }
+
+    int runBook(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+
+        // Options can come before or after the FEN
+        std::string keysPath;
+        int fenIndex = argc;
+        for (int i = 3; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-k" && i + 1 < argc) {
+                keysPath = argv[++i];
+            }
+            else if (fenIndex == argc) {
+                fenIndex = i;
+            }
+        }
+
+        Zobrist::KEY_TABLE keys;
+        if (!::loadKeys(keysPath, keys)) {
+            return EXIT_FAILURE;
+        }
+        Book book;
+        if (!book.open(argv[2], keys)) {
+            std::cout << "Could not open book: " << argv[2] << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        POSITION position;
+        if (!::loadPosition(argc, argv, fenIndex, position)) {
+            return EXIT_FAILURE;
+        }
+        std::vector<BOOK_MOVE> moves = book.getMoves(position.colour, position.grid);
+        std::cout << "Key: " << std::hex << book.getKey(position.colour, position.grid) << std::dec << std::endl;
+        std::cout << "Entries: " << book.Count() << std::endl;
+        if (moves.empty()) {
+            std::cout << "Position is not in the book" << std::endl;
+        }
+        for (BOOK_MOVE& move : moves) {
+            std::cout << San::toSAN(move.move, position.colour, position.grid) << " " << move.weight << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    int runBookBuild(int argc, char** argv) {
+        if (argc < 4) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        int threads = Threads::available();
+        int plies = BOOK_BUILD_PLY;
+        int minGames = BOOK_BUILD_MIN_GAMES;
+        std::string keysPath;
+        for (int i = 4; i + 1 < argc; i += 2) {
+            std::string argument = argv[i];
+            if (argument == "-t") {
+                threads = std::atoi(argv[i + 1]);
+            }
+            else if (argument == "-p") {
+                plies = std::atoi(argv[i + 1]);
+            }
+            else if (argument == "-m") {
+                minGames = std::atoi(argv[i + 1]);
+            }
+            else if (argument == "-k") {
+                keysPath = argv[i + 1];
+            }
+        }
+
+        Zobrist::KEY_TABLE keys;
+        if (!::loadKeys(keysPath, keys)) {
+            return EXIT_FAILURE;
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (!Book::build(argv[2], argv[3], keys, threads, plies, minGames)) {
+            return EXIT_FAILURE;
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+        Book book;
+        book.open(argv[3], keys);
+        std::cout << "Entries: " << book.Count() << std::endl;
+        std::cout << "Time: " << time.count() << "s" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runProbe(int argc, char** argv) {
+        // Options can come before or after the FEN
+        std::string paths = tablebasePath;
+        int fenIndex = argc;
+        for (int i = 2; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-d" && i + 1 < argc) {
+                paths = argv[++i];
+            }
+            else if (fenIndex == argc) {
+                fenIndex = i;
+            }
+        }
+
+        Tablebase tablebase;
+        int tables = tablebase.open(paths);
+        std::cout << "Tables: " << tables << ", up to " << tablebase.MaxPieces() << " pieces" << std::endl;
+        POSITION position;
+        if (!::loadPosition(argc, argv, fenIndex, position)) {
+            return EXIT_FAILURE;
+        }
+
+        int wdl = TABLEBASE_DRAW, dtz = 0;
+        if (!tablebase.probeWDL(position.colour, position.grid, wdl)) {
+            std::cout << "Position is not in the tablebases" << std::endl;
+            return EXIT_FAILURE;
+        }
+        const char* results[] = { "Loss", "Blessed loss", "Draw", "Cursed win", "Win" };
+        std::cout << "WDL: " << results[wdl - TABLEBASE_LOSS] << std::endl;
+        if (tablebase.probeDTZ(position.colour, position.grid, dtz)) {
+            std::cout << "DTZ: " << dtz << std::endl;
+        }
+        Move move = tablebase.bestMove(position.colour, position.grid, position.halfmoves, wdl);
+        if (move.isMove()) {
+            std::cout << "Best move: " << San::toSAN(move, position.colour, position.grid) << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    int runTableGen(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        std::string directory = dtmPath;
+        int threads = Threads::available();
+        for (int i = 3; i + 1 < argc; i += 2) {
+            std::string argument = argv[i];
+            if (argument == "-d") {
+                directory = argv[i + 1];
+            }
+            else if (argument == "-t") {
+                threads = std::atoi(argv[i + 1]);
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (!DtmTablebase::generate(argv[2], directory, threads)) {
+            return EXIT_FAILURE;
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        std::cout << "Time: " << time.count() << "s" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runDtm(int argc, char** argv) {
+        // Options can come before or after the FEN
+        std::string directory = dtmPath;
+        int fenIndex = argc;
+        for (int i = 2; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-d" && i + 1 < argc) {
+                directory = argv[++i];
+            }
+            else if (fenIndex == argc) {
+                fenIndex = i;
+            }
+        }
+
+        DtmTablebase tables;
+        int count = tables.open(directory);
+        std::cout << "Tables: " << count << ", up to " << tables.MaxPieces() << " pieces" << std::endl;
+        POSITION position;
+        if (!::loadPosition(argc, argv, fenIndex, position)) {
+            return EXIT_FAILURE;
+        }
+
+        int wdl = TABLEBASE_DRAW, plies = 0;
+        if (!tables.probe(position.colour, position.grid, wdl, plies)) {
+            std::cout << "Position is not in the tables" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (wdl == TABLEBASE_DRAW) {
+            std::cout << "Result: Draw" << std::endl;
+        }
+        else {
+            std::cout << "Result: " << (wdl == TABLEBASE_WIN ? "Win" : "Loss") << ", mate in " << plies << " plies" << std::endl;
+        }
+        Move move = tables.bestMove(position.colour, position.grid, wdl, plies);
+        if (move.isMove()) {
+            std::cout << "Best move: " << San::toSAN(move, position.colour, position.grid) << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    int runTbCheck(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        std::string paths = tablebasePath;
+        std::string directory = dtmPath;
+        int threads = Threads::available();
+        for (int i = 3; i + 1 < argc; i += 2) {
+            std::string argument = argv[i];
+            if (argument == "-d") {
+                paths = argv[i + 1];
+            }
+            else if (argument == "-g") {
+                directory = argv[i + 1];
+            }
+            else if (argument == "-t") {
+                threads = std::atoi(argv[i + 1]);
+            }
+        }
+
+        // Generated tables never read a Syzygy file, so they check the decoding as well as the indexing
+        std::string material = argv[2];
+        if (!DtmTablebase::generate(material, directory, threads)) {
+            return EXIT_FAILURE;
+        }
+        Tablebase tablebase;
+        DtmTablebase dtm;
+        std::cout << "Syzygy tables: " << tablebase.open(paths) << ", generated tables: " << dtm.open(directory) << std::endl;
+
+        const std::string letters = "PNBRQK";
+        std::vector<PIECE> pieces;
+        FLAG side = PIECE_WHITE;
+        for (char letter : material) {
+            if (letter == 'v') {
+                side = PIECE_BLACK;
+                continue;
+            }
+            pieces.push_back((PIECE)((letters.find(letter) + 1) | side));
+        }
+
+        // The first two pieces' squares are split across threads, the rest are counted through on each
+        int count = (int)pieces.size();
+        long long rest = 1;
+        for (int i = 2; i < count; i++) {
+            rest *= GRID_SIZE * GRID_SIZE;
+        }
+        std::atomic<long long> positions(0), missing(0), wdlErrors(0), dtzErrors(0), mirrorErrors(0);
+        std::atomic<long long> results[2][3] = {};
+        std::mutex print;
+        int shown = 0;
+        auto report = [&](const char* problem, const POSITION& position, int wdl, int dtz, int expected) {
+            std::lock_guard<std::mutex> lock(print);
+            if (shown++ < 10) {
+                std::cout << problem << ": " << Fen::toFEN(position) << " WDL " << wdl << " DTZ " << dtz << " expected " << expected << std::endl;
+            }
+        };
+
+        Threads::parallelFor(GRID_SIZE * GRID_SIZE * GRID_SIZE * GRID_SIZE, threads, [&](size_t first, int) {
+            for (long long index = 0; index < rest; index++) {
+                INDEX squares[TABLEBASE_MAX_PIECES];
+                squares[0] = (INDEX)(first / (GRID_SIZE * GRID_SIZE));
+                squares[1] = (INDEX)(first % (GRID_SIZE * GRID_SIZE));
+                long long remaining = index;
+                for (int i = 2; i < count; i++) {
+                    squares[i] = (INDEX)(remaining % (GRID_SIZE * GRID_SIZE));
+                    remaining /= GRID_SIZE * GRID_SIZE;
+                }
+
+                POSITION position = {};
+                position.fullmoves = 1;
+                bool valid = true;
+                for (int i = 0; i < count && valid; i++) {
+                    int rank = squares[i] / GRID_SIZE;
+                    bool pawn = (Piece::getFlag(pieces[i], MASK_TYPE) == PIECE_PAWN);
+                    valid = (position.grid[squares[i]] == PIECE_INVALID && !(pawn && (rank == 0 || rank == GRID_SIZE - 1)));
+                    position.grid[squares[i]] = pieces[i];
+                }
+                if (!valid) {
+                    continue;
+                }
+
+                for (FLAG colour : { PIECE_WHITE, PIECE_BLACK }) {
+                    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+                    if (MoveGen::inCheck(enemy, position.grid)) {
+                        continue;
+                    }
+                    position.colour = colour;
+                    positions++;
+
+                    int wdl = TABLEBASE_DRAW, dtz = 0, expected = TABLEBASE_DRAW, plies = 0;
+                    if (!tablebase.probeWDL(colour, position.grid, wdl) || !tablebase.probeDTZ(colour, position.grid, dtz) ||
+                        !dtm.probe(colour, position.grid, expected, plies)) {
+                        missing++;
+                        continue;
+                    }
+                    results[colour == PIECE_WHITE ? 0 : 1][wdl > 0 ? 0 : (wdl == 0 ? 1 : 2)]++;
+
+                    // Generated tables ignore the 50 move rule, so cursed wins and blessed losses are wins and losses there
+                    if ((wdl > 0) != (expected > 0) || (wdl < 0) != (expected < 0)) {
+                        wdlErrors++;
+                        report("WDL", position, wdl, dtz, expected);
+                        continue;
+                    }
+                    // DTZ can be one ply over, and never takes longer than mate
+                    bool dtzValid = ((dtz > 0) == (wdl > 0) && (dtz < 0) == (wdl < 0) && std::abs(dtz) <= plies + 1 &&
+                        (std::abs(wdl) != TABLEBASE_WIN || std::abs(dtz) <= 101) && (std::abs(wdl) != TABLEBASE_CURSED_WIN || std::abs(dtz) >= 100));
+                    if (!dtzValid) {
+                        dtzErrors++;
+                        report("DTZ", position, wdl, dtz, plies);
+                    }
+
+                    // Same position with the colours swapped and the board mirrored looks the table up the other way round
+                    POSITION mirrored = {};
+                    mirrored.fullmoves = 1;
+                    mirrored.colour = enemy;
+                    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+                        if (position.grid[i] != PIECE_INVALID) {
+                            mirrored.grid[i ^ (GRID_SIZE * (GRID_SIZE - 1))] = position.grid[i] ^ MASK_COLOUR;
+                        }
+                    }
+                    int mirroredWdl = TABLEBASE_DRAW, mirroredDtz = 0;
+                    if (!tablebase.probeWDL(enemy, mirrored.grid, mirroredWdl) || !tablebase.probeDTZ(enemy, mirrored.grid, mirroredDtz) ||
+                        mirroredWdl != wdl || mirroredDtz != dtz) {
+                        mirrorErrors++;
+                        report("Mirror", mirrored, mirroredWdl, mirroredDtz, wdl);
+                    }
+                }
+            }
+        });
+
+        std::cout << "Positions: " << positions << ", not probed: " << missing << std::endl;
+        for (int side = 0; side < 2; side++) {
+            std::cout << (side == 0 ? "White" : "Black") << " to move: " << results[side][0] << " wins, " << results[side][1] << " draws, "
+                << results[side][2] << " losses" << std::endl;
+        }
+        std::cout << "WDL errors: " << wdlErrors << ", DTZ errors: " << dtzErrors << ", mirror errors: " << mirrorErrors << std::endl;
+        return (missing == 0 && wdlErrors == 0 && dtzErrors == 0 && mirrorErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int runEval(int argc, char** argv) {
+        // Options can come before or after the FEN
+        std::string path = networkFile;
+        std::string kernel;
+        long long count = 0;
+        int fenIndex = argc;
+        for (int i = 2; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-n" && i + 1 < argc) {
+                path = argv[++i];
+            }
+            else if (argument == "-k" && i + 1 < argc) {
+                kernel = argv[++i];
+            }
+            else if (argument == "-b" && i + 1 < argc) {
+                count = std::atoll(argv[++i]);
+            }
+            else if (fenIndex == argc) {
+                fenIndex = i;
+            }
+        }
+
+        if (!kernel.empty() && !Nnue::useKernel(kernel)) {
+            std::cout << "Kernel not supported: " << kernel << std::endl;
+            return EXIT_FAILURE;
+        }
+        Nnue network;
+        if (!network.load(path)) {
+            std::cout << "Could not load network: " << path << std::endl;
+            return EXIT_FAILURE;
+        }
+        POSITION position;
+        if (!::loadPosition(argc, argv, fenIndex, position)) {
+            return EXIT_FAILURE;
+        }
+        std::cout << "Kernel: " << Nnue::Kernel() << std::endl;
+        std::cout << "Evaluation: " << network.evaluate(position.colour, position.grid) << std::endl;
+        if (count <= 0) {
+            return EXIT_SUCCESS;
+        }
+
+        // Game of pseudo random moves from the position, every update is checked against a refresh before timing
+        std::vector<Move> moves;
+        std::vector<POSITION> positions;
+        POSITION current = position;
+        NNUE_ACCUMULATOR accumulator, refreshed;
+        network.refresh(current.grid, accumulator);
+        while (moves.size() < NNUE_BENCH_PLIES) {
+            std::vector<Move> legal = MoveGen::generate(current.colour, current.grid, true);
+            if (legal.empty()) {
+                break;
+            }
+            Move move = legal[(moves.size() * 7919) % legal.size()];
+            positions.push_back(current);
+            moves.push_back(move);
+            network.update(move, current.grid, accumulator, accumulator);
+            Position::play(move, current.grid);
+            current.colour = (current.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+            network.refresh(current.grid, refreshed);
+            if (std::memcmp(&accumulator, &refreshed, sizeof(accumulator)) != 0) {
+                std::cout << "Incremental update differs from a refresh after " << moves.size() << " moves" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        if (moves.empty()) {
+            std::cout << "Position has no moves to time" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Each evaluation is one move made on the accumulator and the dense layers
+        long long total = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < count; i++) {
+            size_t ply = (size_t)(i % (long long)moves.size());
+            if (ply == 0) {
+                network.refresh(position.grid, accumulator);
+            }
+            network.update(moves[ply], positions[ply].grid, accumulator, accumulator);
+            total += network.evaluate(accumulator, positions[ply].colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+        }
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        std::cout << "Evaluations: " << count << ", checksum " << total << std::endl;
+        std::cout << "Time: " << time.count() << "s" << std::endl;
+        std::cout << "Evaluations per second: " << (long long)(count / std::max(time.count(), 1e-9)) << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runScore(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        std::string path = networkFile;
+        std::string output;
+        int threads = Threads::available();
+        bool compare = false;
+        for (int i = 3; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-n" && i + 1 < argc) {
+                path = argv[++i];
+            }
+            else if (argument == "-t" && i + 1 < argc) {
+                threads = std::atoi(argv[++i]);
+            }
+            else if (argument == "-o" && i + 1 < argc) {
+                output = argv[++i];
+            }
+            else if (argument == "-c") {
+                compare = true;
+            }
+        }
+
+        Nnue network;
+        if (!network.load(path)) {
+            std::cout << "Could not load network: " << path << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector<POSITION> positions;
+        if (!Epd::load(argv[2], positions, threads)) {
+            return EXIT_FAILURE;
+        }
+
+        // Each thread converts and scores whole batches
+        std::vector<int> scores(positions.size());
+        size_t batches = (positions.size() + NNUE_BATCH_SIZE - 1) / NNUE_BATCH_SIZE;
+        auto start = std::chrono::steady_clock::now();
+        Threads::parallelFor(batches, threads, [&](size_t index, int) {
+            size_t first = index * NNUE_BATCH_SIZE;
+            NNUE_BATCH batch;
+            Nnue::toBatch(positions.data() + first, std::min<size_t>(positions.size() - first, NNUE_BATCH_SIZE), batch);
+            network.evaluate(batch, scores.data() + first);
+        });
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        std::cout << "Kernel: " << Nnue::Kernel() << std::endl;
+        std::cout << "Positions: " << positions.size() << std::endl;
+        std::cout << "Time: " << time.count() << "s" << std::endl;
+        std::cout << "Positions per second: " << (long long)(positions.size() / std::max(time.count(), 1e-9)) << std::endl;
+
+        if (compare) {
+            std::vector<int> single(positions.size());
+            start = std::chrono::steady_clock::now();
+            Threads::parallelFor(positions.size(), threads, [&](size_t index, int) {
+                single[index] = network.evaluate(positions[index].colour, positions[index].grid);
+            });
+            time = std::chrono::steady_clock::now() - start;
+            size_t differences = 0;
+            for (size_t i = 0; i < positions.size(); i++) {
+                differences += (single[i] != scores[i]);
+            }
+            std::cout << "One at a time: " << time.count() << "s, " << (long long)(positions.size() / std::max(time.count(), 1e-9)) << " per second" << std::endl;
+            if (differences) {
+                std::cout << "Scores that differ from batches: " << differences << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        // Scores are written as centipawn evaluations for the side to move
+        if (!output.empty()) {
+            std::ofstream file(output);
+            if (!file) {
+                std::cout << "Could not open output: " << output << std::endl;
+                return EXIT_FAILURE;
+            }
+            for (size_t i = 0; i < positions.size(); i++) {
+                file << Epd::positionFields(Fen::toFEN(positions[i])) << " ce " << scores[i] << ";\n";
+            }
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Reads the options shared by search and datagen, returns the index of the first argument that is not one
+    int readSearchOptions(int argc, char** argv, int first, SEARCH_LIMITS& limits, std::string& network) {
+        int other = argc;
+        for (int i = first; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-d" && i + 1 < argc) {
+                limits.depth = std::atoi(argv[++i]);
+            }
+            else if (argument == "-m" && i + 1 < argc) {
+                limits.nodes = std::atoll(argv[++i]);
+            }
+            else if (argument == "-l" && i + 1 < argc) {
+                limits.milliseconds = std::atoll(argv[++i]);
+            }
+            else if (argument == "-n" && i + 1 < argc) {
+                network = argv[++i];
+            }
+            // Options of the commands using these, read by them
+            else if ((argument == "-c" || argument == "-t") && i + 1 < argc) {
+                i++;
+            }
+            else if (argument == "-e") {}
+            else if (other == argc) {
+                other = i;
+            }
+        }
+        return other;
+    }
+
+    // Loads the network if its file exists, the search uses the hand written evaluation otherwise
+    void loadNetwork(Nnue& network, const std::string& path) {
+        network.load(path);
+        std::cout << "Evaluation: " << (network.isLoaded() ? path : "material and piece squares") << std::endl;
+    }
+
+    int runSearch(int argc, char** argv) {
+        SEARCH_LIMITS limits = { 0, 0, 0 };
+        std::string path = networkFile;
+        int fenIndex = ::readSearchOptions(argc, argv, 2, limits, path);
+        if (limits.depth <= 0 && limits.nodes <= 0 && limits.milliseconds <= 0) {
+            limits.depth = DATAGEN_DEPTH;
+        }
+
+        Nnue network;
+        ::loadNetwork(network, path);
+        POSITION position;
+        if (!::loadPosition(argc, argv, fenIndex, position)) {
+            return EXIT_FAILURE;
+        }
+        Search search(SEARCH_HASH_MEGABYTES, &network);
+        for (int i = 2; i + 1 < argc; i++) {
+            SEARCH_PARAMETERS parameters;
+            if (std::string(argv[i]) == "-c" && Spsa::load(argv[i + 1], parameters)) {
+                search.setParameters(parameters);
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        SEARCH_RESULT result = search.search(position, {}, limits);
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        if (!result.move.isMove()) {
+            std::cout << "Position has no moves" << std::endl;
+            return EXIT_SUCCESS;
+        }
+        std::cout << "Best move: " << San::toSAN(result.move, position.colour, position.grid) << " (" << result.move.toString() << ")" << std::endl;
+        std::cout << "Score: " << result.score << ", depth " << result.depth << std::endl;
+        std::cout << "Nodes: " << result.nodes << ", " << (long long)(result.nodes / std::max(time.count(), 1e-9)) << " per second" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runMcts(int argc, char** argv) {
+        SEARCH_LIMITS limits = { 0, 0, 0 };
+        std::string path;
+        int fenIndex = ::readSearchOptions(argc, argv, 2, limits, path);
+        int threads = Threads::available();
+        bool playouts = true;
+        for (int i = 2; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-t" && i + 1 < argc) {
+                threads = std::atoi(argv[++i]);
+            }
+            else if (argument == "-e") {
+                playouts = false;
+            }
+        }
+        if (limits.nodes <= 0 && limits.milliseconds <= 0) {
+            limits.milliseconds = MCTS_BOT_MILLISECONDS;
+        }
+
+        POSITION position;
+        if (!::loadPosition(argc, argv, fenIndex, position)) {
+            return EXIT_FAILURE;
+        }
+        Mcts mcts(threads, playouts);
+
+        auto start = std::chrono::steady_clock::now();
+        SEARCH_RESULT result = mcts.search(position, limits);
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        if (!result.move.isMove()) {
+            std::cout << "Position has no moves" << std::endl;
+            return EXIT_SUCCESS;
+        }
+        std::cout << "Best move: " << San::toSAN(result.move, position.colour, position.grid) << " (" << result.move.toString() << ")" << std::endl;
+        std::cout << "Score: " << result.score << ", deepest line " << result.depth << " plies, tree " << mcts.Nodes() << " nodes" << std::endl;
+        std::cout << "Playouts: " << result.nodes << ", " << (long long)(result.nodes / std::max(time.count(), 1e-9)) << " per second" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Each game runs on one thread with one thread for MCTS, so both sides get the same CPU time for each move
+    int runVersus(int argc, char** argv) {
+        long long games = 10;
+        long long milliseconds = 100;
+        int randomPlies = DATAGEN_RANDOM_PLIES, threads = Threads::available();
+        unsigned long long seed = 0;
+        bool evaluate = false;
+        for (int i = 2; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-g" && i + 1 < argc) {
+                games = std::atoll(argv[++i]);
+            }
+            else if (argument == "-l" && i + 1 < argc) {
+                milliseconds = std::atoll(argv[++i]);
+            }
+            else if (argument == "-r" && i + 1 < argc) {
+                randomPlies = std::atoi(argv[++i]);
+            }
+            else if (argument == "-t" && i + 1 < argc) {
+                threads = std::max(std::atoi(argv[++i]), 1);
+            }
+            else if (argument == "-s" && i + 1 < argc) {
+                seed = std::strtoull(argv[++i], nullptr, 10);
+            }
+            else if (argument == "-e") {
+                evaluate = true;
+            }
+        }
+
+        // Pairs of games share an opening with colours swapped
+        SEARCH_LIMITS limits = { 0, 0, milliseconds };
+        std::vector<int> scores((size_t)std::max(games, 0LL));
+        std::vector<long long> playoutCounts(scores.size()), nodeCounts(scores.size());
+        Threads::parallelFor(scores.size(), threads, [&](size_t index, int) {
+            Mcts mcts(1, !evaluate);
+            Search search;
+            POSITION position;
+            std::vector<HASH> history;
+            Datagen::playOpening(seed + index / 2, randomPlies, position, history);
+            DATAGEN_PLAYER mctsPlayer = [&](const POSITION& current, const std::vector<HASH>&) {
+                SEARCH_RESULT result = mcts.search(current, limits);
+                playoutCounts[index] += result.nodes;
+                return result;
+            };
+            DATAGEN_PLAYER searchPlayer = [&](const POSITION& current, const std::vector<HASH>& previous) {
+                SEARCH_RESULT result = search.search(current, previous, limits);
+                nodeCounts[index] += result.nodes;
+                return result;
+            };
+            bool mctsWhite = (index % 2 == 0);
+            FLAG result = Datagen::playGame(mctsWhite ? mctsPlayer : searchPlayer, mctsWhite ? searchPlayer : mctsPlayer, position, history);
+            int score = (result == ARCHIVE_RESULT_WHITE ? 1 : (result == ARCHIVE_RESULT_BLACK ? -1 : 0));
+            scores[index] = (mctsWhite ? score : -score);
+            std::cout << "Game " << index + 1 << ": " << Archive::resultString(result) << " with MCTS as " << (mctsWhite ? "white" : "black") << std::endl;
+        });
+
+        long long playouts = 0, nodes = 0;
+        for (size_t i = 0; i < scores.size(); i++) {
+            playouts += playoutCounts[i];
+            nodes += nodeCounts[i];
+        }
+        std::cout << "MCTS: +" << std::count(scores.begin(), scores.end(), 1) << " -" << std::count(scores.begin(), scores.end(), -1)
+            << " =" << std::count(scores.begin(), scores.end(), 0) << " against alpha beta" << std::endl;
+        std::cout << "Playouts: " << playouts << ", alpha beta nodes: " << nodes << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Reads the options shared by mate and mates, returns the index of the first argument that is not one
+    int readMateOptions(int argc, char** argv, int first, int& moves, long long& nodes, bool& checksOnly, int& threads, std::string& output) {
+        int other = argc;
+        for (int i = first; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-u" && i + 1 < argc) {
+                moves = std::atoi(argv[++i]);
+            }
+            else if (argument == "-m" && i + 1 < argc) {
+                nodes = std::atoll(argv[++i]);
+            }
+            else if (argument == "-t" && i + 1 < argc) {
+                threads = std::atoi(argv[++i]);
+            }
+            else if (argument == "-o" && i + 1 < argc) {
+                output = argv[++i];
+            }
+            else if (argument == "-a") {
+                checksOnly = false;
+            }
+            else if (other == argc) {
+                other = i;
+            }
+        }
+        return other;
+    }
+
+    // Writes the mating line as SAN, playing it out on a copy of the position
+    std::string mateLine(const POSITION& position, const std::vector<Move>& line) {
+        POSITION current = position;
+        std::string text;
+        for (Move move : line) {
+            text += (text.empty() ? "" : " ") + San::toSAN(move, current.colour, current.grid);
+            Position::play(move, current.grid);
+            current.colour = (current.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+        }
+        return text;
+    }
+
+    int runMate(int argc, char** argv) {
+        int moves = MATE_MOVES, threads = 1;
+        long long nodes = MATE_NODES;
+        bool checksOnly = true;
+        std::string output;
+        int fenIndex = ::readMateOptions(argc, argv, 2, moves, nodes, checksOnly, threads, output);
+
+        POSITION position;
+        if (!::loadPosition(argc, argv, fenIndex, position)) {
+            return EXIT_FAILURE;
+        }
+        MateSolver solver;
+        auto start = std::chrono::steady_clock::now();
+        MATE_RESULT result = solver.solve(position, moves, nodes, checksOnly);
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+        if (result.status == MATE_FOUND) {
+            std::cout << "Mate in " << result.moves << ": " << ::mateLine(position, result.line) << std::endl;
+        }
+        else if (result.status == MATE_NONE) {
+            std::cout << "No mate in " << moves << (checksOnly ? " with checks" : "") << std::endl;
+        }
+        else {
+            std::cout << "Unknown, node limit reached" << std::endl;
+        }
+        std::cout << "Nodes: " << result.nodes << ", " << (long long)(result.nodes / std::max(time.count(), 1e-9)) << " per second" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int runMates(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        int moves = MATE_MOVES, threads = Threads::available();
+        long long nodes = MATE_NODES;
+        bool checksOnly = true;
+        std::string output;
+        ::readMateOptions(argc, argv, 3, moves, nodes, checksOnly, threads, output);
+
+        std::vector<POSITION> positions;
+        if (!Epd::load(argv[2], positions, threads)) {
+            return EXIT_FAILURE;
+        }
+
+        // One solver and hash table per worker, results stored for one position stay true for the next
+        threads = std::max(threads, 1);
+        std::vector<std::unique_ptr<MateSolver>> solvers;
+        for (int i = 0; i < threads; i++) {
+            solvers.emplace_back(new MateSolver());
+        }
+        std::vector<MATE_RESULT> results(positions.size());
+        auto start = std::chrono::steady_clock::now();
+        Threads::parallelFor(positions.size(), threads, [&](size_t index, int worker) {
+            results[index] = solvers[worker]->solve(positions[index], moves, nodes, checksOnly);
+        });
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+        long long counts[3] = { 0, 0, 0 }, totalNodes = 0;
+        for (const MATE_RESULT& result : results) {
+            counts[result.status]++;
+            totalNodes += result.nodes;
+        }
+        std::cout << "Mates: " << counts[MATE_FOUND] << ", no mate: " << counts[MATE_NONE] << ", unknown: " << counts[MATE_UNKNOWN] << std::endl;
+        std::cout << "Time: " << time.count() << "s, nodes: " << totalNodes << std::endl;
+
+        if (!output.empty()) {
+            std::ofstream file(output);
+            if (!file) {
+                std::cout << "Could not open output: " << output << std::endl;
+                return EXIT_FAILURE;
+            }
+            for (size_t i = 0; i < positions.size(); i++) {
+                file << Epd::positionFields(Fen::toFEN(positions[i]));
+                if (results[i].status == MATE_FOUND) {
+                    file << " dm " << results[i].moves << "; bm " << San::toSAN(results[i].line[0], positions[i].colour, positions[i].grid) << ";";
+                }
+                else {
+                    file << " c0 \"" << (results[i].status == MATE_NONE ? "no mate" : "unknown") << "\";";
+                }
+                file << "\n";
+            }
+        }
+        return EXIT_SUCCESS;
+    }
+
+    int runDatagen(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        DATAGEN_SETTINGS settings = { 100, { 0, 0, 0 }, DATAGEN_RANDOM_PLIES, Threads::available(), 0 };
+        std::string path = networkFile;
+        for (int i = 3; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-g" && i + 1 < argc) {
+                settings.games = std::atoll(argv[++i]);
+            }
+            else if (argument == "-r" && i + 1 < argc) {
+                settings.randomPlies = std::atoi(argv[++i]);
+            }
+            else if (argument == "-t" && i + 1 < argc) {
+                settings.threads = std::atoi(argv[++i]);
+            }
+            else if (argument == "-s" && i + 1 < argc) {
+                settings.seed = std::strtoull(argv[++i], nullptr, 10);
+            }
+        }
+        ::readSearchOptions(argc, argv, 3, settings.limits, path);
+        if (settings.limits.depth <= 0 && settings.limits.nodes <= 0) {
+            settings.limits.depth = DATAGEN_DEPTH;
+        }
+
+        // Games are adjudicated from the same tablebases the board uses
+        Nnue network;
+        ::loadNetwork(network, path);
+        Tablebase tablebase;
+        DtmTablebase dtm;
+        if (TABLEBASE_PLAY) {
+            tablebase.open(tablebasePath);
+        }
+        dtm.open(dtmPath);
+        return (Datagen::run(argv[2], settings, &network, &tablebase, &dtm) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int runSpsa(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        SPSA_SETTINGS settings = { SPSA_ITERATIONS, SPSA_PAIRS, { 0, 0, 0 }, SPSA_RANDOM_PLIES, Threads::available(), SPSA_RATE, 0 };
+        std::string path = networkFile;
+        for (int i = 3; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-i" && i + 1 < argc) {
+                settings.iterations = std::atoi(argv[++i]);
+            }
+            else if (argument == "-p" && i + 1 < argc) {
+                settings.pairs = std::atoi(argv[++i]);
+            }
+            else if (argument == "-r" && i + 1 < argc) {
+                settings.randomPlies = std::atoi(argv[++i]);
+            }
+            else if (argument == "-t" && i + 1 < argc) {
+                settings.threads = std::atoi(argv[++i]);
+            }
+            else if (argument == "-a" && i + 1 < argc) {
+                settings.rate = std::atof(argv[++i]);
+            }
+            else if (argument == "-s" && i + 1 < argc) {
+                settings.seed = std::strtoull(argv[++i], nullptr, 10);
+            }
+        }
+        ::readSearchOptions(argc, argv, 3, settings.limits, path);
+        if (settings.limits.depth <= 0 && settings.limits.nodes <= 0) {
+            settings.limits.nodes = SPSA_NODES;
+        }
+
+        Nnue network;
+        ::loadNetwork(network, path);
+        Tablebase tablebase;
+        DtmTablebase dtm;
+        if (TABLEBASE_PLAY) {
+            tablebase.open(tablebasePath);
+        }
+        dtm.open(dtmPath);
+        return (Spsa::run(argv[2], settings, &network, &tablebase, &dtm) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int runTune(int argc, char** argv) {
+        if (argc < 3) {
+            ::showHelp();
+            return EXIT_FAILURE;
+        }
+        TUNE_SETTINGS settings = { TUNE_EPOCHS, Threads::available(), TUNE_RATE, 0.0 };
+        std::string output = tuneFile;
+        for (int i = 3; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "-o" && i + 1 < argc) {
+                output = argv[++i];
+            }
+            else if (argument == "-e" && i + 1 < argc) {
+                settings.epochs = std::atoi(argv[++i]);
+            }
+            else if (argument == "-t" && i + 1 < argc) {
+                settings.threads = std::atoi(argv[++i]);
+            }
+            else if (argument == "-r" && i + 1 < argc) {
+                settings.rate = std::atof(argv[++i]);
+            }
+            else if (argument == "-l" && i + 1 < argc) {
+                settings.lambda = std::atof(argv[++i]);
+            }
+        }
+        return (Tuner::run(argv[2], output, settings) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+}
+
+int Console::run(int argc, char** argv) {
+    std::string command = argv[1];
+    if (command == "perft") {
+        return ::runPerft(argc, argv, false);
+    }
+    if (command == "divide") {
+        return ::runPerft(argc, argv, true);
+    }
+    if (command == "epd") {
+        return ::runEpd(argc, argv);
+    }
+    if (command == "pgn") {
+        return ::runPgn(argc, argv);
+    }
+    if (command == "archive") {
+        return ::runArchive(argc, argv);
+    }
+    if (command == "unarchive") {
+        return ::runUnarchive(argc, argv);
+    }
+    if (command == "index") {
+        return ::runIndex(argc, argv);
+    }
+    if (command == "query") {
+        return ::runQuery(argc, argv);
+    }
+    if (command == "book") {
+        return ::runBook(argc, argv);
+    }
+    if (command == "probe") {
+        return ::runProbe(argc, argv);
+    }
+    if (command == "bookbuild") {
+        return ::runBookBuild(argc, argv);
+    }
+    if (command == "tbgen") {
+        return ::runTableGen(argc, argv);
+    }
+    if (command == "tbcheck") {
+        return ::runTbCheck(argc, argv);
+    }
+    if (command == "dtm") {
+        return ::runDtm(argc, argv);
+    }
+    if (command == "eval") {
+        return ::runEval(argc, argv);
+    }
+    if (command == "search") {
+        return ::runSearch(argc, argv);
+    }
+    if (command == "mcts") {
+        return ::runMcts(argc, argv);
+    }
+    if (command == "versus") {
+        return ::runVersus(argc, argv);
+    }
+    if (command == "mate") {
+        return ::runMate(argc, argv);
+    }
+    if (command == "mates") {
+        return ::runMates(argc, argv);
+    }
+    if (command == "datagen") {
+        return ::runDatagen(argc, argv);
+    }
+    if (command == "spsa") {
+        return ::runSpsa(argc, argv);
+    }
+    if (command == "tune") {
+        return ::runTune(argc, argv);
+    }
+    if (command == "score") {
+        return ::runScore(argc, argv);
+    }
+    if (command == "pack") {
+        return ::runPack(argc, argv, true);
+    }
+    if (command == "unpack") {
+        return ::runPack(argc, argv, false);
+    }
+
+    std::cout << "Unknown command: " << command << std::endl;
+    ::showHelp();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,252 @@
+#include "Datagen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Fen.h"
+#include "MoveGen.h"
+#include "Piece.h"
+#include "Threads.h"
+#include "Zobrist.h"
+
+namespace {
+
+    // Games waiting to be written, shared by the workers and the writer thread
+    typedef struct writerHolder {
+        std::mutex mutex;
+        // Signals the writer when a game is queued and the workers when there is room again
+        std::condition_variable queued, room;
+        std::deque<std::vector<PACKED_POSITION>> games;
+        bool finished = false;
+
+        std::ofstream file;
+        long long gamesWritten = 0, positionsWritten = 0;
+        bool failed = false;
+    } WRITER;
+
+    void queueGame(WRITER& writer, std::vector<PACKED_POSITION>&& records) {
+        std::unique_lock<std::mutex> lock(writer.mutex);
+        writer.room.wait(lock, [&]() { return writer.games.size() < DATAGEN_QUEUE_GAMES; });
+        writer.games.push_back(std::move(records));
+        writer.queued.notify_one();
+    }
+
+    // Runs on its own thread, buffering records until there are enough to write at once
+    void writeGames(WRITER& writer) {
+        std::vector<unsigned char> buffer;
+        buffer.reserve(DATAGEN_BUFFER_SIZE + DATAGEN_MAX_PLIES * PACKED_SIZE);
+        auto start = std::chrono::steady_clock::now();
+        auto report = start;
+
+        while (true) {
+            std::vector<PACKED_POSITION> records;
+            bool finished;
+            {
+                std::unique_lock<std::mutex> lock(writer.mutex);
+                writer.queued.wait(lock, [&]() { return !writer.games.empty() || writer.finished; });
+                finished = writer.games.empty();
+                if (!finished) {
+                    records = std::move(writer.games.front());
+                    writer.games.pop_front();
+                    writer.room.notify_one();
+                }
+            }
+
+            for (const PACKED_POSITION& record : records) {
+                buffer.insert(buffer.end(), record.data, record.data + PACKED_SIZE);
+            }
+            if (buffer.size() >= DATAGEN_BUFFER_SIZE || (finished && !buffer.empty())) {
+                writer.file.write((const char*)buffer.data(), buffer.size());
+                writer.failed |= !writer.file;
+                buffer.clear();
+            }
+            if (finished) {
+                return;
+            }
+            writer.gamesWritten++;
+            writer.positionsWritten += records.size();
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - report >= std::chrono::seconds(1)) {
+                report = now;
+                std::chrono::duration<double> time = now - start;
+                std::cout << "Games: " << writer.gamesWritten << ", positions: " << writer.positionsWritten
+                    << ", positions per second: " << (long long)(writer.positionsWritten / time.count()) << std::endl;
+            }
+        }
+    }
+
+    FLAG enemyOf(FLAG colour) {
+        return (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+
+    // Plays the move, keeping the clocks the same way the board does
+    void playMove(Move move, POSITION& position) {
+        bool pawnMove = (Piece::getFlag(position.grid[move.Start()], MASK_TYPE) == PIECE_PAWN);
+        position.halfmoves = (pawnMove || move.isCapture() ? 0 : position.halfmoves + 1);
+        if (position.colour == PIECE_BLACK) {
+            position.fullmoves++;
+        }
+        Position::play(move, position.grid);
+        position.colour = ::enemyOf(position.colour);
+    }
+
+    // Counts earlier positions with the same side to move since the last capture or pawn move
+    int repetitions(HASH hash, const std::vector<HASH>& history, int halfmoves) {
+        int count = 0;
+        int size = (int)history.size();
+        for (int i = 2; i <= halfmoves && i <= size; i += 2) {
+            count += (history[size - i] == hash);
+        }
+        return count;
+    }
+
+    // Plays random moves from the start position, returns false if the game ended during them
+    bool tryOpening(std::mt19937_64& random, int plies, POSITION& position, std::vector<HASH>& history) {
+        Fen::load(startFEN, position);
+        history.clear();
+        for (int ply = 0; ply < plies; ply++) {
+            std::vector<Move> moves = MoveGen::generate(position.colour, position.grid, true);
+            if (moves.empty()) {
+                return false;
+            }
+            history.push_back(Zobrist::hash(position.colour, position.grid));
+            ::playMove(moves[random() % moves.size()], position);
+        }
+        return MoveGen::hasLegalMove(position.colour, position.grid);
+    }
+
+    // Sets the result if the tablebases know the position, returns false if neither can probe it
+    bool adjudicate(const POSITION& position, const Tablebase* tablebase, const DtmTablebase* dtm, FLAG& result) {
+        int wdl = TABLEBASE_DRAW;
+        int plies = 0;
+        if (!(tablebase && tablebase->probeWDL(position.colour, position.grid, wdl)) && !(dtm && dtm->probe(position.colour, position.grid, wdl, plies))) {
+            return false;
+        }
+
+        // Cursed wins and blessed losses are draws under the 50 move rule
+        if (wdl == TABLEBASE_WIN) {
+            result = (position.colour == PIECE_WHITE ? ARCHIVE_RESULT_WHITE : ARCHIVE_RESULT_BLACK);
+        }
+        else if (wdl == TABLEBASE_LOSS) {
+            result = (position.colour == PIECE_WHITE ? ARCHIVE_RESULT_BLACK : ARCHIVE_RESULT_WHITE);
+        }
+        else {
+            result = ARCHIVE_RESULT_DRAW;
+        }
+        return true;
+    }
+
+    // Plays one self play game, returns its records with the result filled in
+    std::vector<PACKED_POSITION> playGame(Search& search, const DATAGEN_SETTINGS& settings, unsigned long long seed, const Tablebase* tablebase, const DtmTablebase* dtm) {
+        POSITION position;
+        std::vector<HASH> history;
+        Datagen::playOpening(seed, settings.randomPlies, position, history);
+        search.clear();
+
+        std::vector<PACKED_POSITION> records;
+        FLAG result = Datagen::playGame(search, search, position, history, settings.limits, tablebase, dtm, &records);
+        for (PACKED_POSITION& record : records) {
+            record.data[DATAGEN_RESULT] = (unsigned char)result;
+        }
+        return records;
+    }
+
+}
+
+bool Datagen::run(const std::string& path, const DATAGEN_SETTINGS& settings, const Nnue* network, const Tablebase* tablebase, const DtmTablebase* dtm) {
+    WRITER writer;
+    writer.file.open(path, std::ios::binary | std::ios::app);
+    if (!writer.file) {
+        std::cout << "Could not open output: " << path << std::endl;
+        return false;
+    }
+    std::thread thread(::writeGames, std::ref(writer));
+
+    // One search and hash table per worker
+    int threads = std::max(settings.threads, 1);
+    std::vector<std::unique_ptr<Search>> searches;
+    for (int i = 0; i < threads; i++) {
+        searches.emplace_back(new Search(SEARCH_HASH_MEGABYTES, network));
+    }
+    Threads::parallelFor((size_t)std::max(settings.games, 0LL), threads, [&](size_t index, int worker) {
+        ::queueGame(writer, ::playGame(*searches[worker], settings, settings.seed + index, tablebase, dtm));
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(writer.mutex);
+        writer.finished = true;
+        writer.queued.notify_one();
+    }
+    thread.join();
+    std::cout << "Games: " << writer.gamesWritten << ", positions: " << writer.positionsWritten << std::endl;
+    if (writer.failed) {
+        std::cout << "Could not write to " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Datagen::playOpening(unsigned long long seed, int plies, POSITION& position, std::vector<HASH>& history) {
+    std::mt19937_64 random(seed);
+    while (!::tryOpening(random, plies, position, history)) {}
+}
+
+FLAG Datagen::playGame(Search& white, Search& black, POSITION& position, std::vector<HASH>& history, const SEARCH_LIMITS& limits,
+    const Tablebase* tablebase, const DtmTablebase* dtm, std::vector<PACKED_POSITION>* records) {
+    return Datagen::playGame(
+        [&](const POSITION& current, const std::vector<HASH>& previous) { return white.search(current, previous, limits); },
+        [&](const POSITION& current, const std::vector<HASH>& previous) { return black.search(current, previous, limits); },
+        position, history, tablebase, dtm, records);
+}
+
+FLAG Datagen::playGame(const DATAGEN_PLAYER& white, const DATAGEN_PLAYER& black, POSITION& position, std::vector<HASH>& history,
+    const Tablebase* tablebase, const DtmTablebase* dtm, std::vector<PACKED_POSITION>* records) {
+    // Same endings as the board, checkmate, stalemate, the 50 move rule and tablebase results, with threefold repetition and a ply limit added
+    FLAG result = ARCHIVE_RESULT_DRAW;
+    for (int ply = 0; ply < DATAGEN_MAX_PLIES; ply++) {
+        HASH hash = Zobrist::hash(position.colour, position.grid);
+        if (position.halfmoves >= 100 || ::repetitions(hash, history, position.halfmoves) >= 2 || ::adjudicate(position, tablebase, dtm, result)) {
+            break;
+        }
+        SEARCH_RESULT best = (position.colour == PIECE_WHITE ? white : black)(position, history);
+        if (!best.move.isMove()) {
+            if (MoveGen::inCheck(position.colour, position.grid)) {
+                result = (position.colour == PIECE_WHITE ? ARCHIVE_RESULT_BLACK : ARCHIVE_RESULT_WHITE);
+            }
+            break;
+        }
+
+        // Only quiet positions are kept, where the score is what the evaluation should learn
+        bool quiet = (!MoveGen::inCheck(position.colour, position.grid) && !best.move.isCapture() && !best.move.isPromotion());
+        PACKED_POSITION record;
+        if (records && quiet && std::abs(best.score) < SEARCH_MATE_BOUND && Packed::pack(position, record)) {
+            record.data[DATAGEN_SCORE] = (unsigned char)(best.score & 0xFF);
+            record.data[DATAGEN_SCORE + 1] = (unsigned char)((best.score >> 8) & 0xFF);
+            records->push_back(record);
+        }
+
+        history.push_back(hash);
+        ::playMove(best.move, position);
+    }
+    return result;
+}
+
+bool Datagen::read(const PACKED_POSITION& record, POSITION& position, int& score, FLAG& result) {
+    if (!Packed::unpack(record, position)) {
+        return false;
+    }
+    score = (short)(record.data[DATAGEN_SCORE] | (record.data[DATAGEN_SCORE + 1] << 8));
+    result = record.data[DATAGEN_RESULT] & MASK_ARCHIVE_RESULT;
+    return (result != ARCHIVE_RESULT_NONE);
+}
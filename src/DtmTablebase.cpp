@@ -0,0 +1,823 @@
+#include "DtmTablebase.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+#include "Attacks.h"
+#include "MappedFile.h"
+#include "MoveGen.h"
+#include "Piece.h"
+#include "Position.h"
+#include "Threads.h"
+
+namespace {
+
+    // ----- Material -----
+
+    // Pieces in the order they are written in names, strongest first
+    const char pieceOrder[] = "KQRBNP";
+    const char letters[] = " PNBRQK";
+
+    // Squares in the a1-d1-d4 triangle, the white king of a pawnless position is always moved into it
+    constexpr int triangle[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+    // Where each piece goes in an index and how large the index is
+    // Slots are the white king, the black king, then the other pieces in name order, white first
+    typedef struct dtmMaterialHolder {
+        // Name with the stronger side first, such as KRvK
+        std::string name;
+        int count;
+        PIECE pieces[DTM_MAX_PIECES];
+        bool hasPawns;
+        // Squares the white king can be moved into, 10 without pawns and files a to d with them
+        int regions;
+        unsigned long long size;
+    } DTM_MATERIAL;
+
+    FLAG typeOf(char letter) {
+        return (FLAG)(std::strchr(letters, letter) - letters);
+    }
+
+    std::string sortSide(std::string side) {
+        std::sort(side.begin(), side.end(), [](char a, char b) {
+            return std::strchr(pieceOrder, a) < std::strchr(pieceOrder, b);
+        });
+        return side;
+    }
+
+    int sideValue(const std::string& side) {
+        const int values[] = { 0, 1, 3, 3, 5, 9, 0 };
+        int value = 0;
+        for (char letter : side) {
+            value += values[::typeOf(letter)];
+        }
+        return value;
+    }
+
+    // Tables are stored once, with the side that has more material first
+    std::string tableName(const std::string& white, const std::string& black) {
+        int whiteValue = ::sideValue(white), blackValue = ::sideValue(black);
+        bool whiteLeads = (whiteValue != blackValue ? whiteValue > blackValue : (white.size() != black.size() ? white.size() > black.size() : white >= black));
+        return (whiteLeads ? white + "v" + black : black + "v" + white);
+    }
+
+    // Returns the material as a table name with white's pieces first, phantoms are not counted
+    std::string materialName(const PIECE* grid) {
+        std::string sides[2];
+        for (FLAG type = PIECE_KING; type >= PIECE_PAWN; type--) {
+            for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+                if (Piece::getFlag(grid[i], MASK_TYPE) == type) {
+                    sides[Piece::getFlag(grid[i], MASK_COLOUR) == PIECE_WHITE ? 0 : 1] += letters[type];
+                }
+            }
+        }
+        return sides[0] + "v" + sides[1];
+    }
+
+    // Reads a name such as KRvK, pieces can be in any order and are stored under the table's own name
+    bool parseMaterial(const std::string& name, DTM_MATERIAL& material) {
+        size_t split = name.find('v');
+        if (split == std::string::npos || name.find_first_not_of("KQRBNPv") != std::string::npos || name.size() - 1 > DTM_MAX_PIECES) {
+            return false;
+        }
+        std::string sides[2] = { ::sortSide(name.substr(0, split)), ::sortSide(name.substr(split + 1)) };
+        for (const std::string& side : sides) {
+            if (std::count(side.begin(), side.end(), 'K') != 1 || side.find('v') != std::string::npos) {
+                return false;
+            }
+        }
+        material.name = ::tableName(sides[0], sides[1]);
+        sides[0] = material.name.substr(0, material.name.find('v'));
+        sides[1] = material.name.substr(material.name.find('v') + 1);
+
+        material.count = 2;
+        material.pieces[0] = PIECE_KING | PIECE_WHITE;
+        material.pieces[1] = PIECE_KING | PIECE_BLACK;
+        for (int side = 0; side < 2; side++) {
+            for (size_t i = 1; i < sides[side].size(); i++) {
+                material.pieces[material.count++] = ::typeOf(sides[side][i]) | (side == 0 ? PIECE_WHITE : PIECE_BLACK);
+            }
+        }
+        material.hasPawns = (material.name.find('P') != std::string::npos);
+        material.regions = (material.hasPawns ? GRID_SIZE * GRID_SIZE / 2 : 10);
+        material.size = 2 * material.regions;
+        for (int i = 1; i < material.count; i++) {
+            material.size *= GRID_SIZE * GRID_SIZE;
+        }
+        return true;
+    }
+
+    // Adds every table reached by a capture or promotion before the table itself, smallest first
+    void collectMaterials(const std::string& name, std::vector<std::string>& order) {
+        if (std::find(order.begin(), order.end(), name) != order.end()) {
+            return;
+        }
+        std::string sides[2] = { name.substr(0, name.find('v')), name.substr(name.find('v') + 1) };
+        auto add = [&](const std::string& white, const std::string& black) {
+            // Bare kings are always drawn and need no table
+            if (white.size() + black.size() > 2) {
+                ::collectMaterials(::tableName(::sortSide(white), ::sortSide(black)), order);
+            }
+        };
+
+        for (int side = 0; side < 2; side++) {
+            const std::string& own = sides[side];
+            const std::string& other = sides[1 - side];
+            // Captures take any piece but the king
+            for (size_t i = 1; i < other.size(); i++) {
+                std::string captured = other.substr(0, i) + other.substr(i + 1);
+                add(side == 0 ? own : captured, side == 0 ? captured : own);
+            }
+            // Promotions, with or without a capture
+            size_t pawn = own.find('P');
+            if (pawn == std::string::npos) {
+                continue;
+            }
+            for (char promotion : std::string("QRBN")) {
+                std::string promoted = own;
+                promoted[pawn] = promotion;
+                add(side == 0 ? promoted : other, side == 0 ? other : promoted);
+                for (size_t i = 1; i < other.size(); i++) {
+                    std::string captured = other.substr(0, i) + other.substr(i + 1);
+                    add(side == 0 ? promoted : captured, side == 0 ? captured : promoted);
+                }
+            }
+        }
+        order.push_back(name);
+    }
+
+    // ----- Index -----
+
+    // Applies one of the 8 board symmetries, bit 0 mirrors files, bit 1 mirrors ranks and bit 2 swaps the two
+    int transform(int square, int symmetry) {
+        int rank = square / GRID_SIZE, file = square % GRID_SIZE;
+        if (symmetry & 1) {
+            file = GRID_SIZE - 1 - file;
+        }
+        if (symmetry & 2) {
+            rank = GRID_SIZE - 1 - rank;
+        }
+        if (symmetry & 4) {
+            std::swap(rank, file);
+        }
+        return rank * GRID_SIZE + file;
+    }
+
+    int kingRegion(const DTM_MATERIAL& material, int square) {
+        if (material.hasPawns) {
+            int file = square % GRID_SIZE;
+            return (file < GRID_SIZE / 2 ? (square / GRID_SIZE) * (GRID_SIZE / 2) + file : -1);
+        }
+        const int* found = std::find(::triangle, ::triangle + 10, square);
+        return (found == ::triangle + 10 ? -1 : (int)(found - ::triangle));
+    }
+
+    int regionSquare(const DTM_MATERIAL& material, int region) {
+        if (material.hasPawns) {
+            return (region / (GRID_SIZE / 2)) * GRID_SIZE + region % (GRID_SIZE / 2);
+        }
+        return ::triangle[region];
+    }
+
+    // Returns the lowest index of any symmetry of the position, so every symmetry shares one entry
+    // Pawns only allow mirroring files, identical pieces are sorted by square
+    unsigned long long encode(const DTM_MATERIAL& material, const int* squares, int stm) {
+        unsigned long long best = ULLONG_MAX;
+        for (int symmetry = 0; symmetry < (material.hasPawns ? 2 : 8); symmetry++) {
+            int region = ::kingRegion(material, ::transform(squares[0], symmetry));
+            if (region < 0) {
+                continue;
+            }
+            int moved[DTM_MAX_PIECES];
+            for (int i = 1; i < material.count; i++) {
+                moved[i] = ::transform(squares[i], symmetry);
+                for (int j = i; j > 2 && material.pieces[j] == material.pieces[j - 1] && moved[j] < moved[j - 1]; j--) {
+                    std::swap(moved[j], moved[j - 1]);
+                }
+            }
+
+            unsigned long long index = (unsigned long long)stm * material.regions + region;
+            for (int i = 1; i < material.count; i++) {
+                index = index * GRID_SIZE * GRID_SIZE + moved[i];
+            }
+            best = std::min(best, index);
+        }
+        return best;
+    }
+
+    void decode(const DTM_MATERIAL& material, unsigned long long index, int* squares, int& stm) {
+        for (int i = material.count - 1; i >= 1; i--) {
+            squares[i] = (int)(index % (GRID_SIZE * GRID_SIZE));
+            index /= GRID_SIZE * GRID_SIZE;
+        }
+        squares[0] = ::regionSquare(material, (int)(index % material.regions));
+        stm = (int)(index / material.regions);
+    }
+
+    // Finds the square of each slot's piece, returns false if the grid has other material
+    bool findSquares(const DTM_MATERIAL& material, const PIECE* grid, int* squares) {
+        BITBOARD used = 0;
+        for (int slot = 0; slot < material.count; slot++) {
+            squares[slot] = -1;
+            for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+                if (!(used & BITBOARD_INDEX(i)) && Piece::getFlag(grid[i], MASK_TYPE | MASK_COLOUR) == material.pieces[slot]) {
+                    squares[slot] = i;
+                    used |= BITBOARD_INDEX(i);
+                    break;
+                }
+            }
+            if (squares[slot] < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void setGrid(const DTM_MATERIAL& material, const int* squares, PIECE* grid) {
+        std::memset(grid, 0, sizeof(PIECE) * GRID_SIZE * GRID_SIZE);
+        for (int i = 0; i < material.count; i++) {
+            grid[squares[i]] = material.pieces[i];
+        }
+        Position::setFlags(0, grid);
+    }
+
+    // Returns if the index is the one a legal position with its pieces is stored under
+    bool isValid(const DTM_MATERIAL& material, unsigned long long index, const int* squares, int stm, PIECE* grid) {
+        BITBOARD occupied = 0;
+        for (int i = 0; i < material.count; i++) {
+            int rank = squares[i] / GRID_SIZE;
+            if ((occupied & BITBOARD_INDEX(squares[i])) || (Piece::getFlag(material.pieces[i], MASK_TYPE) == PIECE_PAWN && (rank == 0 || rank == GRID_SIZE - 1))) {
+                return false;
+            }
+            occupied |= BITBOARD_INDEX(squares[i]);
+        }
+        if (::encode(material, squares, stm) != index) {
+            return false;
+        }
+        ::setGrid(material, squares, grid);
+        // Side that just moved cannot be left in check
+        return !MoveGen::inCheck(stm ? PIECE_WHITE : PIECE_BLACK, grid);
+    }
+
+    // Calls onPredecessor with the squares of every position the side that just moved could have come from
+    // Captures and promotions change the material, so only quiet moves and pawn pushes are taken back
+    void forEachUnmove(const DTM_MATERIAL& material, const int* squares, int stm, const std::function<void(const int*)>& onPredecessor) {
+        FLAG moved = (stm ? PIECE_WHITE : PIECE_BLACK);
+        FLAG toMove = (stm ? PIECE_BLACK : PIECE_WHITE);
+        BITBOARD occupied = 0;
+        for (int i = 0; i < material.count; i++) {
+            occupied |= BITBOARD_INDEX(squares[i]);
+        }
+
+        int previous[DTM_MAX_PIECES];
+        PIECE grid[GRID_SIZE * GRID_SIZE];
+        for (int slot = 0; slot < material.count; slot++) {
+            if (Piece::getFlag(material.pieces[slot], MASK_COLOUR) != moved) {
+                continue;
+            }
+            INDEX square = squares[slot];
+            FLAG type = Piece::getFlag(material.pieces[slot], MASK_TYPE);
+            BITBOARD starts = 0;
+            if (type == PIECE_KNIGHT) {
+                starts = Attacks::knight.squares[square] & ~occupied;
+            }
+            else if (type == PIECE_KING) {
+                starts = Attacks::king.squares[square] & ~occupied;
+            }
+            else if (type == PIECE_PAWN) {
+                INDEX step = (moved == PIECE_WHITE ? -GRID_SIZE : GRID_SIZE);
+                INDEX start = square + step;
+                int rank = start / GRID_SIZE;
+                if (rank != 0 && rank != GRID_SIZE - 1 && !(occupied & BITBOARD_INDEX(start))) {
+                    starts |= BITBOARD_INDEX(start);
+                    // Two squares from the start rank
+                    int startRank = (moved == PIECE_WHITE ? 1 : GRID_SIZE - 2);
+                    if (rank - (moved == PIECE_WHITE ? 1 : -1) == startRank && !(occupied & BITBOARD_INDEX(start + step))) {
+                        starts |= BITBOARD_INDEX(start + step);
+                    }
+                }
+            }
+            else {
+                int first = (type == PIECE_BISHOP ? ATTACKS_RAYS / 2 : 0);
+                int last = (type == PIECE_ROOK ? ATTACKS_RAYS / 2 : ATTACKS_RAYS);
+                for (int ray = first; ray < last; ray++) {
+                    INDEX start = square;
+                    for (int i = 0; i < Attacks::rays.length[square][ray]; i++) {
+                        start += Attacks::rayOffsets[ray];
+                        if (occupied & BITBOARD_INDEX(start)) {
+                            break;
+                        }
+                        starts |= BITBOARD_INDEX(start);
+                    }
+                }
+            }
+
+            while (starts) {
+                INDEX start = Attacks::popLowest(starts);
+                std::memcpy(previous, squares, sizeof(int) * material.count);
+                previous[slot] = start;
+                // Side to move now could not have been in check with the other side to move
+                ::setGrid(material, previous, grid);
+                if (!MoveGen::inCheck(toMove, grid)) {
+                    onPredecessor(previous);
+                }
+            }
+        }
+    }
+
+    // ----- Generation -----
+
+    // Best capture or promotion of each position while generating
+    // 0 when there are none, 1 when the best is a draw, otherwise plies to mate plus 2 with odd plies winning
+    unsigned char exitCode(int wdl, int plies) {
+        return (unsigned char)(wdl == TABLEBASE_DRAW ? 1 : plies + 2);
+    }
+
+    // Higher is better for the side to move, shorter wins and longer losses come first
+    int score(int wdl, int plies) {
+        return (wdl == TABLEBASE_WIN ? 1000 - plies : (wdl == TABLEBASE_LOSS ? -1000 + plies : 0));
+    }
+
+    int exitScore(unsigned char exit) {
+        if (exit == 0) {
+            return INT_MIN;
+        }
+        if (exit == 1) {
+            return 0;
+        }
+        int plies = exit - 2;
+        return ::score((plies & 1) ? TABLEBASE_WIN : TABLEBASE_LOSS, plies);
+    }
+
+    // Numbers are stored least significant byte first
+    void writeNumber(unsigned char* data, unsigned long long value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            data[i] = (unsigned char)(value >> (8 * i));
+        }
+    }
+
+    unsigned long long readNumber(const unsigned char* data, int bytes) {
+        unsigned long long value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= (unsigned long long)data[i] << (8 * i);
+        }
+        return value;
+    }
+
+    // Run length encodes every block on its own so a probe only decodes one
+    // Positions that cannot happen take the value before them, which makes runs longer
+    bool writeTable(const std::string& path, const std::vector<std::atomic<unsigned char>>& values, int threads) {
+        size_t blocks = (values.size() + DTM_BLOCK_SIZE - 1) / DTM_BLOCK_SIZE;
+        std::vector<std::vector<unsigned char>> data(blocks);
+        Threads::parallelFor(blocks, threads, [&](size_t block, int) {
+            size_t end = std::min(values.size(), (block + 1) * DTM_BLOCK_SIZE);
+            unsigned char last = DTM_DRAW;
+            int run = 0;
+            for (size_t i = block * DTM_BLOCK_SIZE; i < end; i++) {
+                unsigned char value = values[i].load(std::memory_order_relaxed);
+                value = (value == DTM_INVALID ? last : value);
+                if (run > 0 && (value != last || run == 256)) {
+                    data[block].push_back(last);
+                    data[block].push_back((unsigned char)(run - 1));
+                    run = 0;
+                }
+                last = value;
+                run++;
+            }
+            data[block].push_back(last);
+            data[block].push_back((unsigned char)(run - 1));
+        });
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cout << "Could not open table file: " << path << std::endl;
+            return false;
+        }
+        unsigned char header[DTM_HEADER_SIZE] = {};
+        std::memcpy(header, DTM_MAGIC, 4);
+        ::writeNumber(&header[4], DTM_VERSION, 4);
+        ::writeNumber(&header[8], values.size(), 8);
+        ::writeNumber(&header[16], DTM_BLOCK_SIZE, 4);
+        ::writeNumber(&header[20], blocks, 4);
+        file.write((const char*)header, DTM_HEADER_SIZE);
+
+        // Offsets are from the end of the offsets, with one more giving the end of the last block
+        std::vector<unsigned char> offsets((blocks + 1) * 8);
+        unsigned long long offset = 0;
+        for (size_t i = 0; i <= blocks; i++) {
+            ::writeNumber(&offsets[i * 8], offset, 8);
+            offset += (i < blocks ? data[i].size() : 0);
+        }
+        file.write((const char*)offsets.data(), offsets.size());
+        for (const std::vector<unsigned char>& block : data) {
+            file.write((const char*)block.data(), block.size());
+        }
+        return (bool)file;
+    }
+
+    // Builds one table by retrograde analysis, smaller tables have to be in tables already
+    // Values are 0 until known, so positions never reached are the draws once generation ends
+    bool generateTable(const DTM_MATERIAL& material, const DtmTablebase& tables, const std::string& path, int threads) {
+        std::vector<std::atomic<unsigned char>> values(material.size);
+        std::vector<std::atomic<unsigned char>> counters(material.size);
+        std::vector<unsigned char> exits(material.size);
+        size_t blocks = (material.size + DTM_BLOCK_SIZE - 1) / DTM_BLOCK_SIZE;
+        std::atomic<int> longest(0);
+        std::atomic<bool> failed(false);
+        auto setLongest = [&](int plies) {
+            int current = longest.load(std::memory_order_relaxed);
+            while (plies > current && !longest.compare_exchange_weak(current, plies)) {
+            }
+            if (plies > DTM_MAX_PLIES) {
+                failed = true;
+            }
+        };
+
+        // Every position counts its moves that stay in the table, captures and promotions are read from smaller tables
+        Threads::parallelFor(blocks, threads, [&](size_t block, int) {
+            int squares[DTM_MAX_PIECES], next[DTM_MAX_PIECES];
+            PIECE grid[GRID_SIZE * GRID_SIZE], child[GRID_SIZE * GRID_SIZE];
+            std::vector<unsigned long long> children;
+            size_t end = std::min((size_t)material.size, (block + 1) * DTM_BLOCK_SIZE);
+            for (size_t index = block * DTM_BLOCK_SIZE; index < end; index++) {
+                int stm = 0;
+                ::decode(material, index, squares, stm);
+                if (!::isValid(material, index, squares, stm, grid)) {
+                    values[index].store(DTM_INVALID, std::memory_order_relaxed);
+                    continue;
+                }
+
+                FLAG colour = (stm ? PIECE_BLACK : PIECE_WHITE);
+                FLAG enemy = (stm ? PIECE_WHITE : PIECE_BLACK);
+                std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+                if (moves.empty()) {
+                    // Mated now, stalemates are left as draws
+                    if (MoveGen::inCheck(colour, grid)) {
+                        values[index].store(1, std::memory_order_relaxed);
+                    }
+                    continue;
+                }
+
+                unsigned char exit = 0;
+                children.clear();
+                for (Move& move : moves) {
+                    std::memcpy(child, grid, sizeof(child));
+                    Position::play(move, child);
+                    if (move.isCapture() || move.isPromotion()) {
+                        int wdl = TABLEBASE_DRAW, plies = 0;
+                        if (!tables.probe(enemy, child, wdl, plies)) {
+                            failed = true;
+                            continue;
+                        }
+                        unsigned char code = ::exitCode(-wdl, plies + 1);
+                        if (::exitScore(code) > ::exitScore(exit)) {
+                            exit = code;
+                        }
+                    }
+                    else if (::findSquares(material, child, next)) {
+                        children.push_back(::encode(material, next, 1 - stm));
+                    }
+                }
+
+                // Symmetries can make two moves reach the same entry, it is only counted once
+                std::sort(children.begin(), children.end());
+                children.erase(std::unique(children.begin(), children.end()), children.end());
+                counters[index].store((unsigned char)children.size(), std::memory_order_relaxed);
+                exits[index] = exit;
+                if (exit > 1) {
+                    setLongest(exit - 2);
+                    // Nothing else to wait for
+                    if (children.empty()) {
+                        values[index].store(exit - 1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+        if (failed) {
+            std::cout << "Could not read the tables " << material.name << " converts into" << std::endl;
+            return false;
+        }
+
+        // Positions mated in plies are found in order, then every move back to them
+        // A move back to a loss is a win one ply longer, a position with every move back to a win is a loss
+        for (int plies = 0; plies <= longest && !failed; plies++) {
+            Threads::parallelFor(blocks, threads, [&](size_t block, int) {
+                int squares[DTM_MAX_PIECES];
+                std::vector<unsigned long long> previous;
+                size_t end = std::min((size_t)material.size, (block + 1) * DTM_BLOCK_SIZE);
+                for (size_t index = block * DTM_BLOCK_SIZE; index < end; index++) {
+                    unsigned char value = values[index].load(std::memory_order_relaxed);
+                    // Winning captures and promotions count once no quicker win was found
+                    if (value == 0 && exits[index] == plies + 2 && (plies & 1)) {
+                        unsigned char expected = 0;
+                        values[index].compare_exchange_strong(expected, (unsigned char)(plies + 1));
+                        value = values[index].load(std::memory_order_relaxed);
+                    }
+                    if (value != plies + 1) {
+                        continue;
+                    }
+
+                    int stm = 0;
+                    ::decode(material, index, squares, stm);
+                    previous.clear();
+                    ::forEachUnmove(material, squares, stm, [&](const int* from) {
+                        previous.push_back(::encode(material, from, 1 - stm));
+                    });
+                    std::sort(previous.begin(), previous.end());
+                    previous.erase(std::unique(previous.begin(), previous.end()), previous.end());
+
+                    for (unsigned long long from : previous) {
+                        if (!(plies & 1)) {
+                            unsigned char expected = 0;
+                            if (values[from].compare_exchange_strong(expected, (unsigned char)(plies + 2))) {
+                                setLongest(plies + 1);
+                            }
+                            continue;
+                        }
+                        if (values[from].load(std::memory_order_relaxed) != 0 || counters[from].fetch_sub(1) != 1) {
+                            continue;
+                        }
+                        // Captures and promotions that win or draw are better than every move left
+                        unsigned char exit = exits[from];
+                        if (exit == 1 || (exit > 1 && ((exit - 2) & 1))) {
+                            continue;
+                        }
+                        int loss = std::max(plies + 1, exit > 1 ? exit - 2 : 0);
+                        unsigned char expected = 0;
+                        if (values[from].compare_exchange_strong(expected, (unsigned char)(loss + 1))) {
+                            setLongest(loss);
+                        }
+                    }
+                }
+            });
+        }
+        if (failed) {
+            std::cout << material.name << " has mates longer than " << DTM_MAX_PLIES << " plies" << std::endl;
+            return false;
+        }
+
+        if (!::writeTable(path, values, threads)) {
+            return false;
+        }
+        std::cout << material.name << ": " << material.size << " positions, longest mate " << longest << " plies" << std::endl;
+        return true;
+    }
+
+}
+
+struct dtmTableHolder {
+    DTM_MATERIAL material;
+    std::string path;
+    std::atomic<bool> ready;
+    bool failed;
+    std::mutex lock;
+    MappedFile file;
+    const unsigned char* offsets;
+    const unsigned char* blocks;
+    unsigned long long entries;
+    unsigned long long blockCount;
+};
+
+namespace {
+
+    // Maps the file on first use, other threads wait until it is ready
+    bool mapTable(dtmTableHolder& table) {
+        if (table.ready.load(std::memory_order_acquire)) {
+            return !table.failed;
+        }
+        std::lock_guard<std::mutex> guard(table.lock);
+        if (table.ready.load(std::memory_order_relaxed)) {
+            return !table.failed;
+        }
+
+        table.failed = true;
+        if (table.file.open(table.path)) {
+            const unsigned char* data = (const unsigned char*)table.file.Data();
+            size_t size = table.file.Size();
+            bool valid = (size >= DTM_HEADER_SIZE && std::memcmp(data, DTM_MAGIC, 4) == 0 && ::readNumber(&data[4], 4) == DTM_VERSION);
+            if (valid) {
+                table.entries = ::readNumber(&data[8], 8);
+                table.blockCount = ::readNumber(&data[20], 4);
+                table.offsets = data + DTM_HEADER_SIZE;
+                table.blocks = table.offsets + (table.blockCount + 1) * 8;
+                valid = (table.entries == table.material.size && ::readNumber(&data[16], 4) == DTM_BLOCK_SIZE
+                    && table.blockCount == (table.entries + DTM_BLOCK_SIZE - 1) / DTM_BLOCK_SIZE
+                    && (size - DTM_HEADER_SIZE) / 8 > table.blockCount
+                    && ::readNumber(table.offsets + table.blockCount * 8, 8) <= size - (table.blocks - data));
+            }
+            if (valid) {
+                table.failed = false;
+            }
+            else {
+                std::cout << "Corrupt table file: " << table.path << std::endl;
+                table.file.close();
+            }
+        }
+        table.ready.store(true, std::memory_order_release);
+        return !table.failed;
+    }
+
+    // Walks the runs of the entry's block
+    unsigned char readEntry(const dtmTableHolder& table, unsigned long long index) {
+        unsigned long long block = index / DTM_BLOCK_SIZE;
+        const unsigned char* data = table.blocks + ::readNumber(table.offsets + block * 8, 8);
+        const unsigned char* end = table.blocks + ::readNumber(table.offsets + (block + 1) * 8, 8);
+        unsigned long long position = index % DTM_BLOCK_SIZE;
+        for (; data + 1 < end; data += 2) {
+            unsigned long long run = data[1] + 1ULL;
+            if (position < run) {
+                return data[0];
+            }
+            position -= run;
+        }
+        return DTM_INVALID;
+    }
+
+}
+
+// ----- Creation -----
+
+DtmTablebase::DtmTablebase() {
+    this->m_maxPieces = 0;
+}
+
+int DtmTablebase::open(const std::string& directory) {
+    this->m_tables.clear();
+    this->m_lookup.clear();
+    this->m_maxPieces = 0;
+
+    std::error_code error;
+    std::filesystem::directory_iterator files(directory, error);
+    if (error) {
+        return 0;
+    }
+    for (const std::filesystem::directory_entry& entry : files) {
+        if (entry.path().extension().string() != dtmExtension) {
+            continue;
+        }
+        std::unique_ptr<dtmTableHolder> table(new dtmTableHolder());
+        // Only files named after their own table are used
+        if (!::parseMaterial(entry.path().stem().string(), table->material) || table->material.name != entry.path().stem().string()) {
+            continue;
+        }
+        table->path = entry.path().string();
+        table->ready = false;
+        table->failed = false;
+
+        const std::string& name = table->material.name;
+        size_t split = name.find('v');
+        this->m_lookup[name] = table.get();
+        this->m_lookup[name.substr(split + 1) + "v" + name.substr(0, split)] = table.get();
+        this->m_maxPieces = std::max(this->m_maxPieces, table->material.count);
+        this->m_tables.push_back(std::move(table));
+    }
+    return (int)this->m_tables.size();
+}
+
+bool DtmTablebase::generate(const std::string& material, const std::string& directory, int threads) {
+    DTM_MATERIAL target;
+    if (!::parseMaterial(material, target)) {
+        std::cout << "Invalid material: " << material << ", tables have a king each and up to " << DTM_MAX_PIECES << " pieces" << std::endl;
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    std::vector<std::string> order;
+    ::collectMaterials(target.name, order);
+    for (const std::string& name : order) {
+        std::string path = (std::filesystem::path(directory) / (name + dtmExtension)).string();
+        if (std::filesystem::exists(path, error)) {
+            continue;
+        }
+        DTM_MATERIAL table;
+        ::parseMaterial(name, table);
+        // Opened again for each table so the ones just written are found
+        DtmTablebase tables;
+        tables.open(directory);
+        if (!::generateTable(table, tables, path, threads)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ----- Read -----
+
+int DtmTablebase::MaxPieces() const {
+    return this->m_maxPieces;
+}
+
+bool DtmTablebase::canProbe(const PIECE* grid) const {
+    int count = 0;
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        FLAG type = Piece::getFlag(grid[i], MASK_TYPE);
+        count += (type != PIECE_INVALID && type != PIECE_PHANTOM);
+    }
+    // Bare kings need no table
+    return ((count == 2 || count <= this->m_maxPieces) && Position::castlingRights(grid) == 0);
+}
+
+bool DtmTablebase::probe(FLAG colour, const PIECE* grid, int& wdl, int& plies) const {
+    if (!this->canProbe(grid)) {
+        return false;
+    }
+    // Tables have no en passant, so positions with a capture open are searched
+    if (Position::findPhantom(colour, grid) != CODE_INVALID) {
+        Move best;
+        return this->search(colour, grid, best, wdl, plies);
+    }
+    return this->probeTable(colour, grid, wdl, plies);
+}
+
+Move DtmTablebase::bestMove(FLAG colour, const PIECE* grid, int& wdl, int& plies) const {
+    Move best;
+    if (!this->canProbe(grid) || !this->search(colour, grid, best, wdl, plies)) {
+        return Move();
+    }
+    return best;
+}
+
+// ----- Read ----- Hidden -----
+
+bool DtmTablebase::probeTable(FLAG colour, const PIECE* grid, int& wdl, int& plies) const {
+    wdl = TABLEBASE_DRAW;
+    plies = 0;
+    std::string name = ::materialName(grid);
+    // Bare kings are always drawn
+    if (name == "KvK") {
+        return true;
+    }
+    auto found = this->m_lookup.find(name);
+    if (found == this->m_lookup.end() || !::mapTable(*found->second)) {
+        return false;
+    }
+    const dtmTableHolder& table = *found->second;
+
+    // Tables are stored with the stronger side as white, so the board is flipped for the other order
+    PIECE flipped[GRID_SIZE * GRID_SIZE] = {};
+    if (name != table.material.name) {
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            FLAG type = Piece::getFlag(grid[i], MASK_TYPE);
+            if (type != PIECE_INVALID && type != PIECE_PHANTOM) {
+                flipped[i ^ (GRID_SIZE * (GRID_SIZE - 1))] = type | (Piece::getFlag(grid[i], MASK_COLOUR) == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+            }
+        }
+        grid = flipped;
+        colour = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+
+    int squares[DTM_MAX_PIECES];
+    if (!::findSquares(table.material, grid, squares)) {
+        return false;
+    }
+    unsigned char value = ::readEntry(table, ::encode(table.material, squares, colour == PIECE_WHITE ? 0 : 1));
+    if (value == DTM_INVALID) {
+        return false;
+    }
+    if (value != DTM_DRAW) {
+        plies = value - 1;
+        wdl = ((plies & 1) ? TABLEBASE_WIN : TABLEBASE_LOSS);
+    }
+    return true;
+}
+
+bool DtmTablebase::search(FLAG colour, const PIECE* grid, Move& best, int& wdl, int& plies) const {
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+    best = Move();
+    wdl = (moves.empty() && MoveGen::inCheck(colour, grid) ? TABLEBASE_LOSS : TABLEBASE_DRAW);
+    plies = 0;
+
+    int bestScore = INT_MIN;
+    for (Move& move : moves) {
+        PIECE next[GRID_SIZE * GRID_SIZE];
+        std::memcpy(next, grid, sizeof(next));
+        Position::play(move, next);
+        int childWdl = TABLEBASE_DRAW, childPlies = 0;
+        if (!this->probe(enemy, next, childWdl, childPlies)) {
+            return false;
+        }
+        int moveWdl = -childWdl;
+        int movePlies = (childWdl == TABLEBASE_DRAW ? 0 : childPlies + 1);
+        int moveScore = ::score(moveWdl, movePlies);
+        if (moveScore > bestScore) {
+            best = move;
+            bestScore = moveScore;
+            wdl = moveWdl;
+            plies = movePlies;
+        }
+    }
+    return true;
+}
+
+// ----- Destruction -----
+
+DtmTablebase::~DtmTablebase() {}
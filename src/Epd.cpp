@@ -0,0 +1,106 @@
+#include "Epd.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Fen.h"
+#include "MappedFile.h"
+#include "Threads.h"
+
+namespace {
+
+    // Errors from one line, numbered within its chunk until chunks are joined
+    typedef struct epdError {
+        size_t line;
+        std::string message;
+    } EPD_ERROR;
+
+    typedef struct epdChunk {
+        std::string_view text;
+        size_t lines;
+        std::vector<POSITION> positions;
+        std::vector<EPD_ERROR> errors;
+    } EPD_CHUNK;
+
+    void parseChunk(EPD_CHUNK& chunk) {
+        std::string_view text = chunk.text;
+        chunk.lines = 0;
+        std::string error;
+        while (!text.empty()) {
+            size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            chunk.lines++;
+
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.find_first_not_of(' ') == std::string_view::npos) {
+                continue;
+            }
+
+            POSITION position;
+            if (Fen::parse(Epd::positionFields(line), position, error)) {
+                chunk.positions.push_back(position);
+            }
+            else {
+                chunk.errors.push_back({ chunk.lines, error });
+            }
+        }
+    }
+
+}
+
+std::string_view Epd::positionFields(std::string_view line) {
+    // End of the fourth field
+    size_t end = 0;
+    for (int field = 0; field < 4 && end != std::string_view::npos; field++) {
+        end = line.find_first_not_of(' ', end);
+        end = (end == std::string_view::npos ? end : line.find(' ', end));
+    }
+    return line.substr(0, end);
+}
+
+bool Epd::load(const std::string& path, std::vector<POSITION>& positions, int threads) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cout << "Could not open EPD file: " << path << std::endl;
+        return false;
+    }
+
+    // Several chunks per thread keeps threads busy when line lengths vary
+    std::string_view text(file.Data(), file.Size());
+    size_t chunkCount = (size_t)(threads > 0 ? threads : 1) * 8;
+    std::vector<EPD_CHUNK> chunks;
+    size_t start = 0;
+    for (size_t i = 1; i <= chunkCount && start < text.size(); i++) {
+        // Chunks end just after a newline so no line is split
+        size_t end = (i == chunkCount ? text.size() : text.find('\n', text.size() * i / chunkCount));
+        end = (end == std::string_view::npos ? text.size() : std::max(end + 1, start));
+        if (end > start) {
+            chunks.push_back({ text.substr(start, end - start), 0, {}, {} });
+        }
+        start = end;
+    }
+
+    Threads::parallelFor(chunks.size(), threads, [&](size_t index, int) {
+        ::parseChunk(chunks[index]);
+    });
+
+    // Join chunks back together in file order
+    size_t total = positions.size();
+    for (EPD_CHUNK& chunk : chunks) {
+        total += chunk.positions.size();
+    }
+    positions.reserve(total);
+
+    size_t firstLine = 0;
+    for (EPD_CHUNK& chunk : chunks) {
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        for (EPD_ERROR& error : chunk.errors) {
+            std::cout << path << ":" << firstLine + error.line << ": " << error.message << std::endl;
+        }
+        firstLine += chunk.lines;
+    }
+    return true;
+}
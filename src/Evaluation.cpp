@@ -0,0 +1,49 @@
+#include "Evaluation.h"
+
+#include <algorithm>
+
+#include "EvaluationWeights.h"
+#include "Piece.h"
+
+namespace {
+
+    // Phase of each piece type from pawn to king
+    constexpr int piecePhase[6] = { 0, 1, 1, 2, 4, 0 };
+
+}
+
+int Evaluation::phase(const PIECE* grid) {
+    int phase = 0;
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        FLAG type = Piece::getFlag(grid[i], MASK_TYPE);
+        if (PIECE_PAWN <= type && type <= PIECE_KING) {
+            phase += piecePhase[type - PIECE_PAWN];
+        }
+    }
+    return phase;
+}
+
+int Evaluation::evaluate(FLAG colour, const PIECE* grid) {
+    // Middlegame and endgame scores from white's view
+    int scores[2] = { 0, 0 };
+    int phase = 0;
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        FLAG type = Piece::getFlag(grid[i], MASK_TYPE);
+        if (type < PIECE_PAWN || type > PIECE_KING) {
+            continue;
+        }
+        int piece = type - PIECE_PAWN;
+        bool white = (Piece::getFlag(grid[i], MASK_COLOUR) == PIECE_WHITE);
+        INDEX square = (white ? i : i ^ (GRID_SIZE * (GRID_SIZE - 1)));
+        for (int stage = 0; stage < 2; stage++) {
+            int value = evaluationMaterial[stage][piece] + evaluationSquares[stage][piece][square];
+            scores[stage] += (white ? value : -value);
+        }
+        phase += piecePhase[piece];
+    }
+
+    // Promotions can take the phase past the maximum
+    phase = std::min(phase, EVALUATION_PHASE_MAX);
+    int score = (scores[0] * phase + scores[1] * (EVALUATION_PHASE_MAX - phase)) / EVALUATION_PHASE_MAX;
+    return (colour == PIECE_WHITE ? score : -score);
+}
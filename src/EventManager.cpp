@@ -7,10 +7,8 @@
 
 bool EventManager::s_eventClick = false;
 bool EventManager::s_eventKey = false;
-bool EventManager::s_eventPromotion = false;
 POINT EventManager::s_mousePos = { 0, 0 };
 int EventManager::s_key = 0;
-INDEX EventManager::s_indexPromotion = CODE_INVALID;
 
 
 EventManager::EventManager() {
@@ -30,11 +28,6 @@ void EventManager::manageEvents() {
         s_eventKey = false;
         this->manageKeyEvents();
     }
-    // Deals with pawn promotions
-    if (s_eventPromotion) {
-        this->s_eventPromotion = false;
-        this->managePromotionEvents();
-    }
 }
 
 INDEX EventManager::getClickIndex() {
@@ -72,11 +65,33 @@ void EventManager::manageKeyEvents() {
     else if (s_key == GLFW_KEY_P) {
         this->m_board->changePerspective();
     }
-}
-
-void EventManager::managePromotionEvents() {
-    this->m_board->setPromotion(s_indexPromotion);
-    this->s_indexPromotion = CODE_INVALID;
+    else if (s_key == GLFW_KEY_S) {
+        this->m_board->saveGame();
+    }
+    else if (s_key == GLFW_KEY_L) {
+        this->m_board->loadGame();
+    }
+    else if (s_key == GLFW_KEY_I) {
+        this->m_board->showGames();
+    }
+    else if (s_key == GLFW_KEY_B) {
+        this->m_board->showBook();
+    }
+    else if (s_key == GLFW_KEY_C) {
+        this->m_board->toggleBot();
+    }
+    else if (s_key == GLFW_KEY_E) {
+        this->m_board->showEvaluation();
+    }
+    else if (s_key == GLFW_KEY_M) {
+        this->m_board->toggleMcts();
+    }
+    else if (s_key == GLFW_KEY_X) {
+        this->m_board->showMate();
+    }
+    else if (s_key == GLFW_KEY_A) {
+        this->m_board->toggleAnalysis();
+    }
 }
 
 void EventManager::showHelp() {
@@ -84,6 +99,15 @@ void EventManager::showHelp() {
     std::cout << "R: Reset board" << std::endl;
     std::cout << "F: Enable/disable board flipping" << std::endl;
     std::cout << "P: Change board perspective" << std::endl;
+    std::cout << "S: Save game to " << gameFile << std::endl;
+    std::cout << "L: Load game from " << gameFile << std::endl;
+    std::cout << "I: Show indexed games that reached this position" << std::endl;
+    std::cout << "B: Show book moves from " << bookFile << std::endl;
+    std::cout << "C: Let the computer play the side to move" << std::endl;
+    std::cout << "E: Show the network's evaluation from " << networkFile << std::endl;
+    std::cout << "M: Switch the computer between random moves and MCTS" << std::endl;
+    std::cout << "X: Find a mate by checks for the side to move" << std::endl;
+    std::cout << "A: Analyse the position, drawing the best lines and an evaluation bar" << std::endl;
     std::cout << "`: Show FPS" << std::endl;
     std::cout << "ESC: Close program" << std::endl;
     std::cout << std::endl;
@@ -111,11 +135,6 @@ void EventManager::eventKey(int key) {
     s_key = key;
 }
 
-void EventManager::eventPromotion(INDEX index) {
-    s_indexPromotion = index;
-    s_eventPromotion = true;
-}
-
 // ----- Destruction -----
 
 EventManager::~EventManager() {
@@ -0,0 +1,294 @@
+#include "Fen.h"
+
+#include <charconv>
+#include <iostream>
+
+#include "MoveGen.h"
+#include "Piece.h"
+
+namespace {
+
+    // Returns the next space separated field and moves fen past it
+    std::string_view nextField(std::string_view& fen) {
+        size_t start = fen.find_first_not_of(' ');
+        if (start == std::string_view::npos) {
+            fen = std::string_view();
+            return fen;
+        }
+        fen.remove_prefix(start);
+        size_t end = fen.find(' ');
+        std::string_view field = fen.substr(0, end);
+        fen.remove_prefix(end == std::string_view::npos ? fen.size() : end);
+        return field;
+    }
+
+    FLAG pieceType(char c) {
+        switch (tolower(c)) {
+        case 'p':
+            return PIECE_PAWN;
+        case 'n':
+            return PIECE_KNIGHT;
+        case 'b':
+            return PIECE_BISHOP;
+        case 'r':
+            return PIECE_ROOK;
+        case 'q':
+            return PIECE_QUEEN;
+        case 'k':
+            return PIECE_KING;
+        default:
+            return PIECE_INVALID;
+        }
+    }
+
+    char pieceChar(PIECE piece) {
+        const char chars[] = " pnbrqk";
+        char c = chars[Piece::getFlag(piece, MASK_TYPE)];
+        return (Piece::getFlag(piece, MASK_COLOUR) == PIECE_WHITE ? toupper(c) : c);
+    }
+
+    // Starts from top left, goes to bottom right
+    bool readPieces(std::string_view field, POSITION& position, std::string& error) {
+        int x = 0, y = GRID_SIZE - 1;
+        for (char c : field) {
+            // Checks for rank change key
+            if (c == '/') {
+                if (x != GRID_SIZE || y == 0) {
+                    error = "Rank " + std::to_string(y + 1) + " does not have 8 squares";
+                    return false;
+                }
+                x = 0;
+                y--;
+                continue;
+            }
+
+            if ('1' <= c && c <= '8') {
+                x += c - '0';
+            }
+            else {
+                FLAG type = ::pieceType(c);
+                if (type == PIECE_INVALID) {
+                    error = std::string("Unknown piece '") + c + "'";
+                    return false;
+                }
+                if (x >= GRID_SIZE) {
+                    error = "Rank " + std::to_string(y + 1) + " has more than 8 squares";
+                    return false;
+                }
+                position.grid[y * GRID_SIZE + x] = (isupper(c) ? PIECE_WHITE : PIECE_BLACK) | type;
+                x++;
+            }
+
+            if (x > GRID_SIZE) {
+                error = "Rank " + std::to_string(y + 1) + " has more than 8 squares";
+                return false;
+            }
+        }
+
+        if (y != 0 || x != GRID_SIZE) {
+            error = "Board does not have 8 full ranks";
+            return false;
+        }
+        return true;
+    }
+
+    bool readCastling(std::string_view field, FLAG& rights, std::string& error) {
+        rights = 0;
+        if (field == "-") {
+            return true;
+        }
+        for (char c : field) {
+            switch (c) {
+            case 'k':
+                rights |= (1 << BOARD_CASTLING_BLACK_KING);
+                break;
+            case 'q':
+                rights |= (1 << BOARD_CASTLING_BLACK_QUEEN);
+                break;
+            case 'K':
+                rights |= (1 << BOARD_CASTLING_WHITE_KING);
+                break;
+            case 'Q':
+                rights |= (1 << BOARD_CASTLING_WHITE_QUEEN);
+                break;
+            default:
+                error = std::string("Unknown castling right '") + c + "'";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Move generation and evaluation expect exactly one king each
+    bool checkKings(const POSITION& position, std::string& error) {
+        int white = 0, black = 0;
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            if (Piece::getFlag(position.grid[i], MASK_TYPE) == PIECE_KING) {
+                (Piece::getFlag(position.grid[i], MASK_COLOUR) == PIECE_WHITE ? white : black)++;
+            }
+        }
+        if (white != 1 || black != 1) {
+            error = "Board must have one king for each side";
+            return false;
+        }
+        return true;
+    }
+
+    // Phantom is placed on the square the pawn skipped
+    bool readEnPassant(std::string_view field, POSITION& position, std::string& error) {
+        if (field == "-") {
+            return true;
+        }
+        char rank = (position.colour == PIECE_WHITE ? '6' : '3');
+        if (field.size() != 2 || field[0] < 'a' || field[0] > 'h' || field[1] != rank) {
+            error = "Invalid en passant square '" + std::string(field) + "'";
+            return false;
+        }
+        INDEX phantom = (field[1] - '1') * GRID_SIZE + (field[0] - 'a');
+        if (position.grid[phantom]) {
+            error = "En passant square '" + std::string(field) + "' is not empty";
+            return false;
+        }
+        position.grid[phantom] = PIECE_PHANTOM;
+        return true;
+    }
+
+    // Clocks can be missing, but must be whole numbers if they are there
+    bool readClock(std::string_view field, int& clock, int fallback, std::string& error) {
+        if (field.empty()) {
+            clock = fallback;
+            return true;
+        }
+        auto result = std::from_chars(field.data(), field.data() + field.size(), clock);
+        if (result.ec != std::errc() || result.ptr != field.data() + field.size() || clock < 0) {
+            error = "Invalid move clock '" + std::string(field) + "'";
+            return false;
+        }
+        return true;
+    }
+
+}
+
+bool Fen::parse(std::string_view fen, POSITION& position, std::string& error) {
+    // Empty all pieces
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        position.grid[i] = PIECE_INVALID;
+    }
+    position.colour = PIECE_WHITE;
+    position.halfmoves = 0;
+    position.fullmoves = 1;
+
+    std::string_view pieces = ::nextField(fen);
+    std::string_view colour = ::nextField(fen);
+    std::string_view castling = ::nextField(fen);
+    std::string_view enPassant = ::nextField(fen);
+    std::string_view halfmoves = ::nextField(fen);
+    std::string_view fullmoves = ::nextField(fen);
+
+    if (pieces.empty() || colour.empty() || castling.empty() || enPassant.empty()) {
+        error = "FEN needs pieces, colour, castling and en passant fields";
+        return false;
+    }
+    if (!::nextField(fen).empty()) {
+        error = "FEN has too many fields";
+        return false;
+    }
+
+    if (!::readPieces(pieces, position, error) || !::checkKings(position, error)) {
+        return false;
+    }
+
+    if (colour != "w" && colour != "b") {
+        error = "Invalid colour '" + std::string(colour) + "'";
+        return false;
+    }
+    position.colour = (colour == "w" ? PIECE_WHITE : PIECE_BLACK);
+
+    // The side to move could take the king
+    FLAG enemy = (position.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    if (MoveGen::inCheck(enemy, position.grid)) {
+        error = std::string(enemy == PIECE_WHITE ? "White" : "Black") + " is in check but it is not their move";
+        return false;
+    }
+
+    FLAG rights = 0;
+    if (!::readCastling(castling, rights, error) ||
+        !::readEnPassant(enPassant, position, error) ||
+        !::readClock(halfmoves, position.halfmoves, 0, error) ||
+        !::readClock(fullmoves, position.fullmoves, 1, error)) {
+        return false;
+    }
+
+    // Castling rights are moved onto the kings and rooks once pieces are placed
+    Position::setFlags(rights, position.grid);
+    return true;
+}
+
+bool Fen::load(std::string_view fen, POSITION& position) {
+    std::string error;
+    if (!Fen::parse(fen, position, error)) {
+        std::cout << "Invalid FEN \"" << fen << "\": " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string Fen::toFEN(const POSITION& position) {
+    std::string fen;
+
+    // Pieces from top left to bottom right, phantoms are empty squares
+    for (int y = GRID_SIZE - 1; y >= 0; y--) {
+        int empty = 0;
+        for (int x = 0; x < GRID_SIZE; x++) {
+            PIECE piece = position.grid[y * GRID_SIZE + x];
+            FLAG type = Piece::getFlag(piece, MASK_TYPE);
+            if (type == PIECE_INVALID || type == PIECE_PHANTOM) {
+                empty++;
+                continue;
+            }
+            if (empty) {
+                fen += (char)('0' + empty);
+                empty = 0;
+            }
+            fen += ::pieceChar(piece);
+        }
+        if (empty) {
+            fen += (char)('0' + empty);
+        }
+        if (y) {
+            fen += '/';
+        }
+    }
+
+    fen += (position.colour == PIECE_WHITE ? " w " : " b ");
+
+    FLAG rights = Position::castlingRights(position.grid);
+    if (!rights) {
+        fen += '-';
+    }
+    if (rights & (1 << BOARD_CASTLING_WHITE_KING)) {
+        fen += 'K';
+    }
+    if (rights & (1 << BOARD_CASTLING_WHITE_QUEEN)) {
+        fen += 'Q';
+    }
+    if (rights & (1 << BOARD_CASTLING_BLACK_KING)) {
+        fen += 'k';
+    }
+    if (rights & (1 << BOARD_CASTLING_BLACK_QUEEN)) {
+        fen += 'q';
+    }
+
+    INDEX phantom = Position::findPhantom(position.colour, position.grid);
+    if (phantom == CODE_INVALID) {
+        fen += " -";
+    }
+    else {
+        fen += ' ';
+        fen += (char)('a' + phantom % GRID_SIZE);
+        fen += (char)('1' + phantom / GRID_SIZE);
+    }
+
+    fen += ' ' + std::to_string(position.halfmoves) + ' ' + std::to_string(position.fullmoves);
+    return fen;
+}
@@ -145,6 +145,10 @@ bool operator==(Move& m1, Move& m2) {
     if (m1.Target() != m2.Target()) {
         return false;
     }
+    // Promotions share squares, so the kind must match too
+    if (m1.Kind() != m2.Kind()) {
+        return false;
+    }
     return true;
 }
 
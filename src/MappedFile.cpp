@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ----- Creation -----
+
+MappedFile::MappedFile() {
+    this->m_data = nullptr;
+    this->m_size = 0;
+#ifdef _WIN32
+    this->m_file = INVALID_HANDLE_VALUE;
+    this->m_mapping = nullptr;
+#endif
+}
+
+bool MappedFile::open(const std::string& path) {
+    this->close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    this->m_file = file;
+    this->m_size = (size_t)size.QuadPart;
+    if (this->m_size == 0) {
+        // Empty files have nothing to map but are still open
+        this->m_data = "";
+        return true;
+    }
+
+    this->m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!this->m_mapping) {
+        this->close();
+        return false;
+    }
+    this->m_data = (const char*)MapViewOfFile(this->m_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        ::close(file);
+        return false;
+    }
+    this->m_size = (size_t)info.st_size;
+    if (this->m_size == 0) {
+        ::close(file);
+        // Empty files have nothing to map but are still open
+        this->m_data = "";
+        return true;
+    }
+
+    // Mapping stays valid after the file is closed
+    void* data = mmap(nullptr, this->m_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    this->m_data = (data == MAP_FAILED ? nullptr : (const char*)data);
+#endif
+
+    if (!this->m_data) {
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+// ----- Read -----
+
+const char* MappedFile::Data() const {
+    return this->m_data;
+}
+
+size_t MappedFile::Size() const {
+    return this->m_size;
+}
+
+bool MappedFile::isOpen() const {
+    return (this->m_data != nullptr);
+}
+
+// ----- Destruction -----
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (this->m_data && this->m_mapping) {
+        UnmapViewOfFile(this->m_data);
+    }
+    if (this->m_mapping) {
+        CloseHandle(this->m_mapping);
+    }
+    if (this->m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->m_file);
+    }
+    this->m_mapping = nullptr;
+    this->m_file = INVALID_HANDLE_VALUE;
+#else
+    if (this->m_data && this->m_size) {
+        munmap((void*)this->m_data, this->m_size);
+    }
+#endif
+    this->m_data = nullptr;
+    this->m_size = 0;
+}
+
+MappedFile::~MappedFile() {
+    this->close();
+}
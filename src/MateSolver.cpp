@@ -0,0 +1,234 @@
+#include "MateSolver.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "MoveGen.h"
+#include "Zobrist.h"
+
+struct mateEntryHolder {
+    HASH key = 0;
+    int phi = 1, delta = 1;
+    // Attacker moves left and if the attacker is to move, the same position is a different problem for each
+    signed char remaining = -1;
+    bool attacker = false;
+};
+
+namespace {
+
+    FLAG enemyOf(FLAG colour) {
+        return (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+
+    size_t indexOf(HASH hash, bool attacker, int remaining, size_t size) {
+        return (hash ^ ((HASH)(remaining * 2 + attacker) * 0x9E3779B97F4A7C15ULL)) & (size - 1);
+    }
+
+    // Sums stay below MATE_INFINITE so they never overflow
+    int add(int first, int second) {
+        return std::min(first + second, MATE_INFINITE);
+    }
+
+}
+
+// ----- Creation -----
+
+MateSolver::MateSolver(int hashMegabytes) {
+    size_t entries = 1;
+    while (entries * 2 * sizeof(mateEntryHolder) <= ((size_t)std::max(hashMegabytes, 1) << 20)) {
+        entries *= 2;
+    }
+    this->m_table.resize(entries);
+    this->m_nodes = 0;
+    this->m_nodeLimit = 0;
+    this->m_checksOnly = true;
+}
+
+// ----- Read -----
+
+void MateSolver::lookup(HASH hash, bool attacker, int remaining, int& phi, int& delta) const {
+    const mateEntryHolder& entry = this->m_table[::indexOf(hash, attacker, remaining, this->m_table.size())];
+    if (entry.key == hash && entry.attacker == attacker && entry.remaining == remaining) {
+        phi = entry.phi;
+        delta = entry.delta;
+        return;
+    }
+    phi = 1;
+    delta = 1;
+}
+
+std::vector<Move> MateSolver::movesOf(FLAG colour, const PIECE* grid, bool attacker) const {
+    if (!attacker) {
+        return MoveGen::generateEvasions(colour, grid);
+    }
+    return (this->m_checksOnly ? MoveGen::generateChecks(colour, grid) : MoveGen::generate(colour, grid, true));
+}
+
+void MateSolver::findLine(const POSITION& position, int moves, std::vector<Move>& line) const {
+    PIECE grid[GRID_SIZE * GRID_SIZE];
+    std::memcpy(grid, position.grid, sizeof(grid));
+    FLAG colour = position.colour;
+    PIECE next[GRID_SIZE * GRID_SIZE];
+    int phi, delta;
+
+    for (int remaining = moves; remaining > 0; remaining--) {
+        // Attacker plays any move whose reply is proven lost
+        Move mate;
+        for (Move move : this->movesOf(colour, grid, true)) {
+            std::memcpy(next, grid, sizeof(next));
+            Position::play(move, next);
+            this->lookup(Zobrist::hash(::enemyOf(colour), next), false, remaining - 1, phi, delta);
+            if (delta == 0) {
+                mate = move;
+                break;
+            }
+        }
+        if (!mate.isMove()) {
+            return;
+        }
+        line.push_back(mate);
+        Position::play(mate, grid);
+        colour = ::enemyOf(colour);
+
+        // Defender plays the reply that is still proven lost with the most moves left
+        Move longest;
+        int longestMoves = 0;
+        for (Move move : this->movesOf(colour, grid, false)) {
+            std::memcpy(next, grid, sizeof(next));
+            Position::play(move, next);
+            HASH hash = Zobrist::hash(::enemyOf(colour), next);
+            int shortest = remaining - 1;
+            for (int shorter = remaining - 2; shorter > 0; shorter--) {
+                this->lookup(hash, true, shorter, phi, delta);
+                if (phi != 0) {
+                    break;
+                }
+                shortest = shorter;
+            }
+            if (shortest > longestMoves) {
+                longestMoves = shortest;
+                longest = move;
+            }
+        }
+        if (!longest.isMove()) {
+            return;
+        }
+        line.push_back(longest);
+        Position::play(longest, grid);
+        colour = ::enemyOf(colour);
+    }
+}
+
+// ----- Update -----
+
+void MateSolver::store(HASH hash, bool attacker, int remaining, int phi, int delta) {
+    mateEntryHolder& entry = this->m_table[::indexOf(hash, attacker, remaining, this->m_table.size())];
+    entry.key = hash;
+    entry.attacker = attacker;
+    entry.remaining = (signed char)remaining;
+    entry.phi = phi;
+    entry.delta = delta;
+}
+
+void MateSolver::expand(FLAG colour, const PIECE* grid, bool attacker, int remaining, int thresholdPhi, int thresholdDelta, int& phi, int& delta) {
+    this->m_nodes++;
+    HASH hash = Zobrist::hash(colour, grid);
+
+    // Attacker out of moves or checks has failed, defender out of moves is mated or stalemated
+    std::vector<Move> moves;
+    if (!attacker || remaining > 0) {
+        moves = this->movesOf(colour, grid, attacker);
+    }
+    if (moves.empty()) {
+        bool lost = (attacker || MoveGen::inCheck(colour, grid));
+        phi = (lost ? MATE_INFINITE : 0);
+        delta = (lost ? 0 : MATE_INFINITE);
+        this->store(hash, attacker, remaining, phi, delta);
+        return;
+    }
+    if (!attacker && remaining == 0) {
+        phi = 0;
+        delta = MATE_INFINITE;
+        this->store(hash, attacker, remaining, phi, delta);
+        return;
+    }
+
+    // Children are played once, their numbers are kept here and updated as each returns
+    FLAG enemy = ::enemyOf(colour);
+    int childRemaining = (attacker ? remaining - 1 : remaining);
+    std::vector<PIECE> grids(moves.size() * GRID_SIZE * GRID_SIZE);
+    std::vector<int> phis(moves.size()), deltas(moves.size());
+    for (size_t i = 0; i < moves.size(); i++) {
+        PIECE* child = &grids[i * GRID_SIZE * GRID_SIZE];
+        std::memcpy(child, grid, sizeof(PIECE) * GRID_SIZE * GRID_SIZE);
+        Position::play(moves[i], child);
+        this->lookup(Zobrist::hash(enemy, child), !attacker, childRemaining, phis[i], deltas[i]);
+    }
+
+    // A node is proven once any child is lost for the player to move there and disproven once all of them are won
+    while (true) {
+        phi = MATE_INFINITE;
+        delta = 0;
+        size_t best = 0;
+        int secondDelta = MATE_INFINITE;
+        for (size_t i = 0; i < moves.size(); i++) {
+            delta = ::add(delta, phis[i]);
+            if (deltas[i] < phi) {
+                secondDelta = phi;
+                phi = deltas[i];
+                best = i;
+            }
+            else if (deltas[i] < secondDelta) {
+                secondDelta = deltas[i];
+            }
+        }
+        if (phi >= thresholdPhi || delta >= thresholdDelta || (this->m_nodeLimit && this->m_nodes >= this->m_nodeLimit)) {
+            break;
+        }
+
+        // Best child is searched until it is no longer best or the node's own thresholds would be crossed
+        int childPhi = thresholdDelta + phis[best] - delta;
+        int childDelta = std::min(thresholdPhi, ::add(secondDelta, 1));
+        this->expand(enemy, &grids[best * GRID_SIZE * GRID_SIZE], !attacker, childRemaining, childPhi, childDelta, phis[best], deltas[best]);
+    }
+    this->store(hash, attacker, remaining, phi, delta);
+}
+
+MATE_RESULT MateSolver::solve(const POSITION& position, int maxMoves, long long nodeLimit, bool checksOnly) {
+    MATE_RESULT result = { MATE_NONE, 0, {}, 0 };
+    // Stored numbers are only true for the moves they were found with
+    if (checksOnly != this->m_checksOnly) {
+        this->clear();
+    }
+    this->m_nodes = 0;
+    this->m_nodeLimit = nodeLimit;
+    this->m_checksOnly = checksOnly;
+
+    // Shorter mates are tried first so the first found is the shortest, their results stay in the table for the longer ones
+    for (int moves = 1; moves <= std::min(maxMoves, MATE_MAX_MOVES); moves++) {
+        int phi = 1, delta = 1;
+        while (phi != 0 && delta != 0 && !(nodeLimit && this->m_nodes >= nodeLimit)) {
+            this->expand(position.colour, position.grid, true, moves, MATE_INFINITE, MATE_INFINITE, phi, delta);
+        }
+        if (phi == 0) {
+            result.status = MATE_FOUND;
+            result.moves = moves;
+            this->findLine(position, moves, result.line);
+            break;
+        }
+        if (delta != 0) {
+            result.status = MATE_UNKNOWN;
+            break;
+        }
+    }
+    result.nodes = this->m_nodes;
+    return result;
+}
+
+void MateSolver::clear() {
+    std::fill(this->m_table.begin(), this->m_table.end(), mateEntryHolder());
+}
+
+// ----- Destruction -----
+
+MateSolver::~MateSolver() {}
@@ -0,0 +1,361 @@
+#include "Mcts.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include "Evaluation.h"
+#include "MoveGen.h"
+#include "Threads.h"
+
+struct mctsNodeHolder {
+    // Move that reached this node from its parent
+    Move move;
+    // Visits include the virtual losses of threads still below the node
+    std::atomic<int> visits;
+    // Sum of results for the side that played move, MCTS_VALUE_SCALE for each win
+    std::atomic<long long> value;
+    // MCTS_NODE_LEAF, MCTS_NODE_EXPANDING or MCTS_NODE_EXPANDED, children are only read once it is expanded
+    std::atomic<int> state;
+    mctsNodeHolder* children;
+    int childCount;
+};
+
+// Hands out nodes from large blocks so expanding never calls new, nodes are only freed by resetting the whole pool
+struct mctsPoolHolder {
+    std::vector<std::unique_ptr<mctsNodeHolder[]>> blocks;
+    // Blocks handed out from and nodes used in the last of them
+    size_t inUse = 0, used = 0;
+
+    mctsNodeHolder* allocate(int count) {
+        if (this->inUse == 0 || this->used + count > MCTS_POOL_BLOCK) {
+            if (this->inUse == this->blocks.size()) {
+                this->blocks.emplace_back(new mctsNodeHolder[MCTS_POOL_BLOCK]);
+            }
+            this->inUse++;
+            this->used = 0;
+        }
+        mctsNodeHolder* nodes = this->blocks[this->inUse - 1].get() + this->used;
+        this->used += count;
+        for (int i = 0; i < count; i++) {
+            nodes[i].move = Move();
+            nodes[i].visits.store(0, std::memory_order_relaxed);
+            nodes[i].value.store(0, std::memory_order_relaxed);
+            nodes[i].state.store(MCTS_NODE_LEAF, std::memory_order_relaxed);
+            nodes[i].children = nullptr;
+            nodes[i].childCount = 0;
+        }
+        return nodes;
+    }
+
+    void reset() {
+        this->inUse = 0;
+        this->used = 0;
+    }
+};
+
+namespace {
+
+    FLAG enemyOf(FLAG colour) {
+        return (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+
+    // Chance of winning for the side to move from a centipawn score
+    long long toValue(int score) {
+        return (long long)(MCTS_VALUE_SCALE / (1.0 + std::pow(10.0, -score / 400.0)));
+    }
+
+    int toScore(double value) {
+        value = std::clamp(value, 0.001, 0.999);
+        return (int)std::lround(-400.0 * std::log10(1.0 / value - 1.0));
+    }
+
+    // Result for colour to move of a position without legal moves
+    long long endValue(FLAG colour, const PIECE* grid) {
+        return (MoveGen::inCheck(colour, grid) ? 0 : MCTS_VALUE_SCALE / 2);
+    }
+
+    bool samePosition(const POSITION& position, FLAG colour, const PIECE* grid) {
+        return (position.colour == colour && std::memcmp(position.grid, grid, sizeof(PIECE) * GRID_SIZE * GRID_SIZE) == 0);
+    }
+
+    // Copies the node and everything under it into the pool, nodes no search is running through
+    void copyTree(const mctsNodeHolder& from, mctsNodeHolder& to, mctsPoolHolder& pool, long long& nodes) {
+        to.move = from.move;
+        to.visits.store(from.visits.load());
+        to.value.store(from.value.load());
+        to.state.store(from.state.load());
+        to.childCount = from.childCount;
+        to.children = nullptr;
+        if (from.childCount > 0) {
+            to.children = pool.allocate(from.childCount);
+            nodes += from.childCount;
+            for (int i = 0; i < from.childCount; i++) {
+                ::copyTree(from.children[i], to.children[i], pool, nodes);
+            }
+        }
+    }
+
+}
+
+// ----- Creation -----
+
+Mcts::Mcts(int threads, bool playouts) {
+    this->m_threads = std::max(threads, 1);
+    this->m_playouts = playouts;
+    this->m_pools[0].resize(this->m_threads);
+    this->m_pools[1].resize(this->m_threads);
+    this->m_generation = 0;
+    this->m_nodes = 0;
+    this->m_root = nullptr;
+    this->m_playoutCount = 0;
+    this->m_depth = 0;
+    this->m_stopped = false;
+    this->m_playoutLimit = 0;
+    this->m_timed = false;
+}
+
+// ----- Read -----
+
+long long Mcts::Nodes() const {
+    return this->m_nodes;
+}
+
+mctsNodeHolder* Mcts::select(mctsNodeHolder* node) const {
+    double logVisits = std::log((double)std::max(node->visits.load(std::memory_order_relaxed), 1));
+    mctsNodeHolder* best = nullptr;
+    double bestBound = -1.0;
+    for (int i = 0; i < node->childCount; i++) {
+        mctsNodeHolder* child = &node->children[i];
+        int visits = child->visits.load(std::memory_order_relaxed);
+        if (visits == 0) {
+            return child;
+        }
+        double mean = (double)child->value.load(std::memory_order_relaxed) / ((double)MCTS_VALUE_SCALE * visits);
+        double bound = mean + MCTS_EXPLORATION * std::sqrt(logVisits / visits);
+        if (bound > bestBound) {
+            bestBound = bound;
+            best = child;
+        }
+    }
+    return best;
+}
+
+long long Mcts::playout(FLAG colour, PIECE* grid, unsigned long long& random) const {
+    FLAG side = colour;
+    long long value = -1;
+    for (int ply = 0; ply < MCTS_PLAYOUT_PLIES && this->m_playouts; ply++) {
+        // Picking from the valid moves and only checking the picked one is the same as picking from the legal moves
+        // but saves testing every move for legality
+        std::vector<Move> moves = MoveGen::generate(colour, grid, false);
+        Move move;
+        while (!moves.empty()) {
+            // Xorshift is enough to pick moves and keeps the playout on the generator
+            random ^= random << 13;
+            random ^= random >> 7;
+            random ^= random << 17;
+            size_t index = random % moves.size();
+            if (MoveGen::isLegal(moves[index], colour, grid)) {
+                move = moves[index];
+                break;
+            }
+            moves[index] = moves.back();
+            moves.pop_back();
+        }
+        if (!move.isMove()) {
+            value = ::endValue(colour, grid);
+            break;
+        }
+        Position::play(move, grid);
+        colour = ::enemyOf(colour);
+    }
+    if (value < 0) {
+        if (!this->m_playouts && !MoveGen::hasLegalMove(colour, grid)) {
+            value = ::endValue(colour, grid);
+        }
+        else {
+            value = ::toValue(Evaluation::evaluate(colour, grid));
+        }
+    }
+    return (colour == side ? value : MCTS_VALUE_SCALE - value);
+}
+
+// ----- Update -----
+
+bool Mcts::expand(mctsNodeHolder* node, FLAG colour, const PIECE* grid, mctsPoolHolder& pool) {
+    int leaf = MCTS_NODE_LEAF;
+    if (!node->state.compare_exchange_strong(leaf, MCTS_NODE_EXPANDING)) {
+        return false;
+    }
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+    if (!moves.empty()) {
+        node->children = pool.allocate((int)moves.size());
+        for (size_t i = 0; i < moves.size(); i++) {
+            node->children[i].move = moves[i];
+        }
+        this->m_nodes += moves.size();
+    }
+    node->childCount = (int)moves.size();
+    node->state.store(MCTS_NODE_EXPANDED, std::memory_order_release);
+    return true;
+}
+
+void Mcts::work(int thread) {
+    mctsPoolHolder& pool = this->m_pools[this->m_generation][thread];
+    unsigned long long random = std::mt19937_64(this->m_playoutCount + thread * 0x9E3779B97F4A7C15ULL)() | 1;
+    std::vector<mctsNodeHolder*> path;
+    PIECE grid[GRID_SIZE * GRID_SIZE];
+
+    for (long long playouts = 1; !this->m_stopped.load(std::memory_order_relaxed); playouts++) {
+        std::memcpy(grid, this->m_position.grid, sizeof(grid));
+        FLAG colour = this->m_position.colour;
+        mctsNodeHolder* node = this->m_root;
+        node->visits += MCTS_VIRTUAL_LOSS;
+        path.assign(1, node);
+
+        // Down to a leaf, counting each node as lost until the result comes back up
+        while (node->state.load(std::memory_order_acquire) == MCTS_NODE_EXPANDED && node->childCount > 0) {
+            node = this->select(node);
+            node->visits += MCTS_VIRTUAL_LOSS;
+            Position::play(node->move, grid);
+            colour = ::enemyOf(colour);
+            path.push_back(node);
+        }
+
+        // Leaves are expanded once they have been visited, while the tree has room
+        long long value;
+        bool visited = (node->visits.load(std::memory_order_relaxed) > MCTS_VIRTUAL_LOSS);
+        if (node->state.load(std::memory_order_acquire) == MCTS_NODE_EXPANDED) {
+            value = ::endValue(colour, grid);
+        }
+        else if (visited && this->m_nodes < MCTS_MAX_NODES && this->expand(node, colour, grid, pool)) {
+            if (node->childCount == 0) {
+                value = ::endValue(colour, grid);
+            }
+            else {
+                node = &node->children[random % node->childCount];
+                node->visits += MCTS_VIRTUAL_LOSS;
+                Position::play(node->move, grid);
+                colour = ::enemyOf(colour);
+                path.push_back(node);
+                value = this->playout(colour, grid, random);
+            }
+        }
+        else {
+            value = this->playout(colour, grid, random);
+        }
+
+        // Each node holds the result for the side that moved into it, the opposite of the side to move there
+        for (size_t i = path.size(); i-- > 0;) {
+            value = MCTS_VALUE_SCALE - value;
+            path[i]->value += value;
+            path[i]->visits -= MCTS_VIRTUAL_LOSS - 1;
+        }
+
+        int depth = (int)path.size() - 1;
+        int deepest = this->m_depth.load(std::memory_order_relaxed);
+        while (depth > deepest && !this->m_depth.compare_exchange_weak(deepest, depth)) {}
+        long long total = ++this->m_playoutCount;
+        if (this->m_playoutLimit && total >= this->m_playoutLimit) {
+            this->m_stopped = true;
+        }
+        if (this->m_timed && playouts % MCTS_TIME_PLAYOUTS == 0 && std::chrono::steady_clock::now() >= this->m_deadline) {
+            this->m_stopped = true;
+        }
+    }
+}
+
+void Mcts::reuse(const POSITION& position) {
+    mctsNodeHolder* found = nullptr;
+    if (this->m_root && ::samePosition(position, this->m_position.colour, this->m_position.grid)) {
+        found = this->m_root;
+    }
+    PIECE child[GRID_SIZE * GRID_SIZE], grandchild[GRID_SIZE * GRID_SIZE];
+    FLAG enemy = ::enemyOf(this->m_position.colour);
+    for (int i = 0; this->m_root && !found && i < this->m_root->childCount; i++) {
+        mctsNodeHolder* node = &this->m_root->children[i];
+        std::memcpy(child, this->m_position.grid, sizeof(child));
+        Position::play(node->move, child);
+        if (::samePosition(position, enemy, child)) {
+            found = node;
+        }
+        for (int j = 0; !found && j < node->childCount; j++) {
+            std::memcpy(grandchild, child, sizeof(grandchild));
+            Position::play(node->children[j].move, grandchild);
+            if (::samePosition(position, this->m_position.colour, grandchild)) {
+                found = &node->children[j];
+            }
+        }
+    }
+    this->m_position = position;
+    if (found == this->m_root && found) {
+        return;
+    }
+
+    // The kept subtree moves to the other generation so the nodes above and beside it can be dropped
+    int next = 1 - this->m_generation;
+    for (mctsPoolHolder& pool : this->m_pools[next]) {
+        pool.reset();
+    }
+    long long nodes = 1;
+    mctsNodeHolder* root = this->m_pools[next][0].allocate(1);
+    if (found) {
+        ::copyTree(*found, *root, this->m_pools[next][0], nodes);
+    }
+    for (mctsPoolHolder& pool : this->m_pools[this->m_generation]) {
+        pool.reset();
+    }
+    this->m_generation = next;
+    this->m_root = root;
+    this->m_nodes = nodes;
+}
+
+SEARCH_RESULT Mcts::search(const POSITION& position, const SEARCH_LIMITS& limits) {
+    SEARCH_RESULT result = { Move(), 0, 0, 0 };
+    this->reuse(position);
+    this->expand(this->m_root, position.colour, position.grid, this->m_pools[this->m_generation][0]);
+    if (this->m_root->childCount == 0) {
+        result.score = (MoveGen::inCheck(position.colour, position.grid) ? -SEARCH_MATE : 0);
+        return result;
+    }
+
+    this->m_playoutCount = 0;
+    this->m_depth = 0;
+    this->m_stopped = false;
+    this->m_playoutLimit = limits.nodes;
+    this->m_timed = (limits.milliseconds > 0);
+    this->m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.milliseconds);
+    if (!this->m_playoutLimit && !this->m_timed) {
+        this->m_playoutLimit = MCTS_PLAYOUTS;
+    }
+    Threads::parallelFor(this->m_threads, this->m_threads, [&](size_t, int thread) { this->work(thread); });
+
+    // Most visited is the move the tree trusts most
+    mctsNodeHolder* best = &this->m_root->children[0];
+    for (int i = 1; i < this->m_root->childCount; i++) {
+        if (this->m_root->children[i].visits > best->visits) {
+            best = &this->m_root->children[i];
+        }
+    }
+    result.move = best->move;
+    result.score = ::toScore((double)best->value / ((double)MCTS_VALUE_SCALE * std::max(best->visits.load(), 1)));
+    result.depth = this->m_depth;
+    result.nodes = this->m_playoutCount;
+    return result;
+}
+
+void Mcts::clear() {
+    for (std::vector<mctsPoolHolder>& pools : this->m_pools) {
+        for (mctsPoolHolder& pool : pools) {
+            pool.reset();
+        }
+    }
+    this->m_root = nullptr;
+    this->m_nodes = 0;
+}
+
+// ----- Destruction -----
+
+Mcts::~Mcts() {}
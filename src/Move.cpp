@@ -2,8 +2,8 @@
 
 #include "Piece.h"
 
-Move::Move(INDEX start, INDEX target, FLAG flags) {
-    this->m_moveData = (start) | (target << 6) | (flags);
+Move::Move(INDEX start, INDEX target, FLAG kind) {
+    this->m_moveData = (start) | (target << 6) | (kind);
 }
 
 Move::~Move() {
@@ -20,19 +20,62 @@ INDEX Move::Target() {
     return ((this->m_moveData & MASK_MOVE_TARGET) >> 6);
 }
 
-FLAG Move::Flags() {
-    return (this->m_moveData & MASK_MOVE_FLAGS);
+FLAG Move::Kind() {
+    return (this->m_moveData & MASK_MOVE_KIND);
 }
 
-FLAG Move::Flags(FLAG flag) {
-    return (this->m_moveData & flag);
+void Move::setKind(FLAG kind) {
+    this->m_moveData = (this->m_moveData & ~MASK_MOVE_KIND) | kind;
 }
 
-void Move::addFlags(FLAG flags) {
-    this->m_moveData |= flags;
+bool Move::isCapture() {
+    return (this->Kind() & MOVE_CAPTURE);
+}
+
+bool Move::isPromotion() {
+    return (this->Kind() & MOVE_PROMOTION);
+}
+
+FLAG Move::Promotion() {
+    if (!this->isPromotion()) {
+        return PIECE_INVALID;
+    }
+    // Promotion bits count up from the knight
+    return PIECE_KNIGHT + ((this->m_moveData & MASK_MOVE_PROMOTION) >> 12);
+}
+
+void Move::setPromotion(FLAG type) {
+    FLAG capture = (this->Kind() & MOVE_CAPTURE);
+    this->setKind(MOVE_PROMOTION | capture | ((type - PIECE_KNIGHT) << 12));
 }
 
 bool Move::isMove() {
     return (this->m_moveData != -1 ? true : false);
 }
 
+std::string Move::toString() {
+    std::string name;
+    name += (char)('a' + this->Start() % GRID_SIZE);
+    name += (char)('1' + this->Start() / GRID_SIZE);
+    name += (char)('a' + this->Target() % GRID_SIZE);
+    name += (char)('1' + this->Target() / GRID_SIZE);
+
+    // Promotion piece is added to the end
+    switch (this->Promotion()) {
+    case PIECE_KNIGHT:
+        name += 'n';
+        break;
+    case PIECE_BISHOP:
+        name += 'b';
+        break;
+    case PIECE_ROOK:
+        name += 'r';
+        break;
+    case PIECE_QUEEN:
+        name += 'q';
+        break;
+    default:
+        break;
+    }
+    return name;
+}
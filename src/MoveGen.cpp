@@ -1,401 +1,325 @@
 #include "MoveGen.h"
 
+#include "Attacks.h"
+#include "Position.h"
 #include "Piece.h"
-#include "Library.h"
 
-std::vector<Move> MoveGen::s_validMoves;
-std::vector<Move> MoveGen::s_legalMoves;
+thread_local std::vector<Move> MoveGen::s_moves;
+thread_local const PIECE* MoveGen::s_grid = nullptr;
+thread_local FLAG MoveGen::s_colour = PIECE_WHITE;
+thread_local FLAG MoveGen::s_enemy = PIECE_BLACK;
+thread_local INDEX MoveGen::s_king = CODE_INVALID;
+thread_local int MoveGen::s_mode = GENERATE_LEGAL;
+thread_local bool MoveGen::s_found = false;
+thread_local int MoveGen::s_count = 0;
+thread_local int* MoveGen::s_pieceCounts = nullptr;
+thread_local BITBOARD MoveGen::s_filter = BITBOARD_EMPTY;
+thread_local INDEX MoveGen::s_enemyKing = CODE_INVALID;
 
 std::vector<Move> MoveGen::generate(FLAG colour, const PIECE* grid, bool calculateLegal) {
     // Clears old moves
-    s_validMoves.clear();
+    s_moves.clear();
 
-    bool capturedKing = false;
-    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        // Determine if piece colour matches to generate moves
-        if (Piece::getFlag(grid[i], MASK_COLOUR) != colour) {
-            continue;
+    MoveGen::setup(colour, grid, (calculateLegal ? GENERATE_LEGAL : GENERATE_VALID));
+    MoveGen::calculateMoves();
+
+    return s_moves;
+}
+
+std::vector<Move> MoveGen::generateChecks(FLAG colour, const PIECE* grid) {
+    s_moves.clear();
+
+    MoveGen::setup(colour, grid, GENERATE_CHECKS);
+    MoveGen::setupChecks();
+    MoveGen::calculateMoves();
+
+    return s_moves;
+}
+
+std::vector<Move> MoveGen::generateEvasions(FLAG colour, const PIECE* grid) {
+    s_moves.clear();
+
+    MoveGen::setup(colour, grid, GENERATE_EVASIONS);
+    MoveGen::setupEvasions();
+    MoveGen::calculateMoves();
+
+    return s_moves;
+}
+
+bool MoveGen::hasLegalMove(FLAG colour, const PIECE* grid) {
+    // Moves are checked as they are added, generation stops at the first legal one
+    MoveGen::setup(colour, grid, GENERATE_ANY);
+    MoveGen::calculateMoves();
+
+    return s_found;
+}
+
+int MoveGen::count(FLAG colour, const PIECE* grid) {
+    return MoveGen::count(colour, grid, nullptr);
+}
+
+int MoveGen::count(FLAG colour, const PIECE* grid, int* pieceCounts) {
+    if (pieceCounts) {
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            pieceCounts[i] = 0;
         }
+    }
+
+    // Moves are counted as they are added, nothing is stored
+    MoveGen::setup(colour, grid, GENERATE_COUNT);
+    s_pieceCounts = pieceCounts;
+    MoveGen::calculateMoves();
+    s_pieceCounts = nullptr;
+
+    return s_count;
+}
+
+bool MoveGen::inCheck(FLAG colour, const PIECE* grid) {
+    INDEX king = Position::findKing(colour, grid);
+    if (king == CODE_INVALID) {
+        return false;
+    }
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    return Attacks::isSquareAttacked(king, enemy, grid);
+}
 
-        // Add start square
-        if (calculateLegal) {
-            MoveGen::add(i, i, 0, grid);
+bool MoveGen::isLegal(Move move, FLAG colour, const PIECE* grid) {
+    MoveGen::setup(colour, grid, GENERATE_LEGAL);
+    return MoveGen::isLegal(move);
+}
+
+void MoveGen::setup(FLAG colour, const PIECE* grid, int mode) {
+    s_mode = mode;
+    s_found = false;
+    s_count = 0;
+    s_grid = grid;
+    s_colour = colour;
+    s_enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    s_king = Position::findKing(colour, grid);
+}
+
+void MoveGen::setupChecks() {
+    s_enemyKing = Position::findKing(s_enemy, s_grid);
+    s_filter = BITBOARD_EMPTY;
+    if (s_enemyKing == CODE_INVALID) {
+        return;
+    }
+    for (int ray = 0; ray < ATTACKS_RAYS; ray++) {
+        INDEX target = s_enemyKing;
+        for (INDEX i = 0; i < Attacks::rays.length[s_enemyKing][ray]; i++) {
+            target += Attacks::rayOffsets[ray];
+            s_filter |= BITBOARD_INDEX(target);
         }
+    }
+    // Pawns of the colour checking the king stand where the king would attack them as an enemy pawn
+    s_filter |= Attacks::knight.squares[s_enemyKing] | Attacks::pawn(s_enemy, s_enemyKing);
+}
 
-        capturedKing |= calculateCardinalMoves(i, grid);
-        capturedKing |= calculateDiagonalMoves(i, grid);
-        capturedKing |= calculateKnightMoves(i, grid);
-        if (calculateLegal) {
-            capturedKing |= calculatePawnMoves(i, grid);
+void MoveGen::setupEvasions() {
+    s_filter = ~BITBOARD_EMPTY;
+    if (s_king == CODE_INVALID) {
+        return;
+    }
+    BITBOARD checkers = Attacks::attackersTo(s_king, s_enemy, s_grid);
+    if (!checkers) {
+        return;
+    }
+    s_filter = BITBOARD_EMPTY;
+    if (checkers & (checkers - 1)) {
+        return;
+    }
+
+    // Squares between a sliding checker and the king can be blocked
+    INDEX checker = Attacks::popLowest(checkers);
+    s_filter = BITBOARD_INDEX(checker);
+    for (int ray = 0; ray < ATTACKS_RAYS; ray++) {
+        BITBOARD between = BITBOARD_EMPTY;
+        INDEX target = s_king;
+        for (INDEX i = 0; i < Attacks::rays.length[s_king][ray]; i++) {
+            target += Attacks::rayOffsets[ray];
+            if (target == checker) {
+                s_filter |= between;
+                return;
+            }
+            between |= BITBOARD_INDEX(target);
         }
-        else {
-            capturedKing |= calculatePawnAttackMoves(i, grid);
+    }
+}
+
+void MoveGen::calculateMoves() {
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        // Determine if piece colour matches to generate moves
+        if (Piece::getFlag(s_grid[i], MASK_COLOUR) != s_colour) {
+            continue;
         }
-        capturedKing |= calculateKingMoves(i, grid);
-        
-        // If calculating legal moves and king is captured, return a single move with a check
-        if (!calculateLegal && capturedKing) {
-            Move move(0, 0, MOVE_CHECK);
-            std::vector<Move> temp;
-            temp.push_back(move);
-            return temp;
+
+        calculateCardinalMoves(i, s_grid);
+        calculateDiagonalMoves(i, s_grid);
+        calculateKnightMoves(i, s_grid);
+        calculatePawnMoves(i, s_grid);
+        calculateKingMoves(i, s_grid);
+
+        // Legal move already found, no need to look further
+        if (s_found) {
+            return;
         }
     }
+}
 
-    // Returns legal moves only for the original move generation call
-    if (calculateLegal) {
-        MoveGen::calculateLegalMoves(colour, grid);
-        auto moves = s_legalMoves;
-        s_legalMoves.clear();
-        return moves;
+bool MoveGen::isLegal(Move move) {
+    // Play move on a copy of the board
+    PIECE editGrid[GRID_SIZE * GRID_SIZE];
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        editGrid[i] = s_grid[i];
     }
+    Position::play(move, editGrid);
 
-    return s_validMoves;
+    // Move is legal if the king is not attacked afterwards
+    INDEX kingIndex = (move.Start() == s_king ? move.Target() : s_king);
+    return (s_king == CODE_INVALID || !Attacks::isSquareAttacked(kingIndex, s_enemy, editGrid));
 }
 
-void MoveGen::calculateLegalMoves(FLAG colour, const PIECE* grid) {
-    auto moves = s_validMoves;
-
-    // Copy over grid
+bool MoveGen::givesCheck(Move move) {
     PIECE editGrid[GRID_SIZE * GRID_SIZE];
     for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        editGrid[i] = grid[i];
+        editGrid[i] = s_grid[i];
     }
+    Position::play(move, editGrid);
 
-    // Loop through each move and play it on the board
-    for (Move& move : moves) {
-        // Play move to determine legality
-        editGrid[move.Target()] = grid[move.Start()];
-        editGrid[move.Start()] = 0;
-
-        // Loop through each grid index
-        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-            // Checks colours aren't the same
-            FLAG targetColour = Piece::getFlag(editGrid[i], MASK_COLOUR);
-            if (colour != targetColour && targetColour) {
-                auto returned = MoveGen::generate(targetColour, editGrid, false);
-                // Checks if returned object was the check
-                if (!(returned.size() == 1 && returned[0].Flags(MOVE_CHECK))) {
-                    addLegal(move);
-                }
-            }
-        }
-
-        // Place whatever was here back
-        editGrid[move.Target()] = grid[move.Target()];
-        editGrid[move.Start()] = grid[move.Start()];
+    INDEX kingIndex = (move.Start() == s_king ? move.Target() : s_king);
+    if (s_king != CODE_INVALID && Attacks::isSquareAttacked(kingIndex, s_enemy, editGrid)) {
+        return false;
     }
+    return (s_enemyKing != CODE_INVALID && Attacks::isSquareAttacked(s_enemyKing, s_colour, editGrid));
 }
 
-bool MoveGen::calculateKingMoves(INDEX startIndex, const PIECE* grid) {
+void MoveGen::calculateKingMoves(INDEX startIndex, const PIECE* grid) {
     // Type must be king
     FLAG type = Piece::getFlag(grid[startIndex], MASK_TYPE);
     if (type != PIECE_KING) {
-        return MOVE_KING_NOT_CAPTURED;
+        return;
     }
 
-    // Top left to bottom right search
-    bool capturedKing = MOVE_KING_NOT_CAPTURED;
-    for (int y = 1; y >= -1; y--) {
-        // Top side check
-        if ((startIndex / GRID_SIZE == GRID_SIZE - 1) && (y == 1)) {
-            // Increase y to remove out of out of bounds error
-            continue;
-        }
-        // Bottom side check
-        if ((startIndex / GRID_SIZE == 0) && (y == -1)) {
-            // All points have been checked, break
-            break;
-        }
-        for (int x = -1; x <= 1; x++) {
-            INDEX target = (startIndex) + (y * GRID_SIZE) + x;
-
-            // Skip center square
-            if (x == y && x == 0) {
-                continue;
-            }
-            // Right Side check
-            if ((startIndex % GRID_SIZE == GRID_SIZE - 1) && (x == 1)) {
-                continue;
-            }
-            // Left side check
-            if ((startIndex % GRID_SIZE == 0) && (x == -1)) {
-                continue;
-            }
-            if (MoveGen::add(startIndex, target, 0, grid) == MOVE_CAPTURE_KING) {
-                capturedKing = MOVE_KING_CAPTURED;
-            }
-        }
+    // Loop through each neighbouring square on the board
+    BITBOARD targets = Attacks::king.squares[startIndex];
+    while (targets) {
+        MoveGen::add(startIndex, Attacks::popLowest(targets), MOVE_QUIET, grid);
     }
 
-    // Prevent castling moves from being calculated in check
-    if (Piece::getFlag(grid[startIndex], MOVE_CHECK) != MOVE_CHECK) {
-        calculateKingCastling(startIndex, grid);
+    calculateKingCastling(startIndex, grid);
+}
+
+void MoveGen::calculateKingCastling(INDEX startIndex, const PIECE* grid) {
+    PIECE piece = grid[startIndex];
+    FLAG colour = Piece::getFlag(piece, MASK_COLOUR);
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+
+    // King must still be on its start square with castling rights
+    if (!Piece::getFlag(piece, FLAG_KING_CASTLING) || startIndex % GRID_SIZE != GRID_SIZE / 2) {
+        return;
+    }
+    // Cannot castle out of check
+    if (Attacks::isSquareAttacked(startIndex, enemy, grid)) {
+        return;
     }
 
-    return capturedKing;
-}
+    // Rook must be in its corner and never have moved
+    PIECE rookFlags = PIECE_ROOK | colour | FLAG_ROOK_CAN_CASTLE;
 
-void MoveGen::calculateKingCastling(INDEX startIndex, const PIECE* grid) { 
     // Check castling kingside
-    PIECE piece = grid[startIndex];
-    
-    bool canCastle = true;
-    if (Piece::getFlag(piece, MOVE_KING_CASTLE_KING)) {
-        for (INDEX i = startIndex + 1; i % GRID_SIZE < GRID_SIZE; i++) {
-            // Checks if piece at index is a rook
-            if (Piece::getFlag(grid[i], MASK_TYPE) == PIECE_ROOK) {
-                // Check if rook has castling ability flag
-                if (Piece::getFlag(grid[i], MOVE_ROOK_CAN_CASTLE)) {
-                    break;
-                }
-            }
-            // If piece detected, cannot castle
-            if (grid[i]) {
-                canCastle = false;
-                break;
-            }
-        }
-        // Add castling move to valid moves
-        if (canCastle) {
-            add(startIndex, startIndex + 2, MOVE_KING_CASTLE_KING, grid);
-        }
+    // Landing square is checked with the rest of the legal moves
+    if (Piece::getFlag(piece, FLAG_KING_CASTLE_KING) &&
+        !grid[startIndex + 1] && !grid[startIndex + 2] &&
+        Piece::getFlag(grid[startIndex + 3], rookFlags | MASK_TYPE) == rookFlags &&
+        !Attacks::isSquareAttacked(startIndex + 1, enemy, grid)) {
+        add(startIndex, startIndex + 2, MOVE_CASTLE_KING, grid);
     }
-    // Check castling queensize
-    canCastle = true;
-    if (Piece::getFlag(piece, MOVE_KING_CASTLE_QUEEN)) {
-        for (INDEX i = startIndex - 1; i % GRID_SIZE >= 0; i--) {
-            // Checks if piece at index is a rook
-            if (Piece::getFlag(grid[i], MASK_TYPE) == PIECE_ROOK) {
-                // Check if rook has castling ability flag
-                if (Piece::getFlag(grid[i], MOVE_ROOK_CAN_CASTLE)) {
-                    break;
-                }
-            }
-            // If piece detected, cannot castle
-            if (grid[i]) {
-                canCastle = false;
-                break;
-            }
-        }
-        // Add castling move to valid moves
-        if (canCastle) {
-            add(startIndex, startIndex - 2, MOVE_KING_CASTLE_QUEEN, grid);
-        }
+
+    // Check castling queenside
+    if (Piece::getFlag(piece, FLAG_KING_CASTLE_QUEEN) &&
+        !grid[startIndex - 1] && !grid[startIndex - 2] && !grid[startIndex - 3] &&
+        Piece::getFlag(grid[startIndex - 4], rookFlags | MASK_TYPE) == rookFlags &&
+        !Attacks::isSquareAttacked(startIndex - 1, enemy, grid)) {
+        add(startIndex, startIndex - 2, MOVE_CASTLE_QUEEN, grid);
     }
 }
 
-bool MoveGen::calculateCardinalMoves(INDEX startIndex, const PIECE* grid) {
+void MoveGen::calculateCardinalMoves(INDEX startIndex, const PIECE* grid) {
     // Type must be rook or queen
     FLAG type = Piece::getFlag(grid[startIndex], MASK_TYPE);
     if (type != PIECE_ROOK && type != PIECE_QUEEN) {
-        return MOVE_KING_NOT_CAPTURED;
+        return;
     }
 
-    INDEX movement[] = { GRID_SIZE, 1, (-GRID_SIZE), -1 };
-
-    // Loops through each potential movement direction
-    bool capturedKing = MOVE_KING_NOT_CAPTURED;
-    for (int i = 0; i < 4; i++) {
-        for (INDEX target = startIndex + movement[i]; 0 <= target && target < GRID_SIZE * GRID_SIZE; target += movement[i]) {
-            FLAG flag = MOVE_END;
-            // Specific compares for each direction
-            if ((i == 0 && target < GRID_SIZE * GRID_SIZE) ||
-                (i == 1 && target % GRID_SIZE != 0) ||
-                (i == 2 && target >= 0) ||
-                (i == 3 && target % GRID_SIZE != GRID_SIZE - 1)) {
-                flag = add(startIndex, target, 0, grid);
-            }
-            // Can continue searching in this direction
-            if (flag == MOVE_CONTINUE) {
-                continue;
-            }
-            // End of column/row hit
-            else if (flag == MOVE_END) {
-                break;
-            }
-            // King was captured
-            else if (flag == MOVE_CAPTURE_KING) {
-                capturedKing = MOVE_KING_CAPTURED;
-                break;
-            }
-        }
-    }
-    return capturedKing;
+    calculateSlidingMoves(startIndex, ATTACKS_CARDINAL_FIRST, grid);
 }
 
-bool MoveGen::calculateDiagonalMoves(INDEX startIndex, const PIECE* grid) {
+void MoveGen::calculateDiagonalMoves(INDEX startIndex, const PIECE* grid) {
     // Type must be bishop or queen
     FLAG type = Piece::getFlag(grid[startIndex], MASK_TYPE);
     if (type != PIECE_BISHOP && type != PIECE_QUEEN) {
-        return MOVE_KING_NOT_CAPTURED;
+        return;
     }
 
-    // Stores movement change for pieces
-    INDEX movement[] = { (GRID_SIZE - 1), (GRID_SIZE + 1), (-GRID_SIZE - 1), (-GRID_SIZE + 1) };
+    calculateSlidingMoves(startIndex, ATTACKS_DIAGONAL_FIRST, grid);
+}
 
+void MoveGen::calculateSlidingMoves(INDEX startIndex, int firstRay, const PIECE* grid) {
     // Loops through each potential movement direction
-    bool capturedKing = MOVE_KING_NOT_CAPTURED;
-    for (int i = 0; i < 4; i++) {
-        for (INDEX target = startIndex + movement[i]; 0 <= target && target < GRID_SIZE * GRID_SIZE; target += movement[i]) {
-            FLAG flag = MOVE_END;
-            if (0 <= target && target < GRID_SIZE * GRID_SIZE) {
-                // Specific compares for each direction
-                if (((i == 0 || i == 2) && (target % GRID_SIZE != GRID_SIZE - 1)) ||
-                    ((i == 1 || i == 3) && (target % GRID_SIZE != 0))) {
-                    flag = add(startIndex, target, 0, grid);
-                }
-            }
-            // Can continue searching in this direction
-            if (flag == MOVE_CONTINUE) {
-                continue;
-            }
-            // End of column/row hit
-            else if (flag == MOVE_END) {
-                break;
-            }
-            // King was captured
-            else if (flag == MOVE_CAPTURE_KING) {
-                capturedKing = MOVE_KING_CAPTURED;
+    for (int ray = firstRay; ray < firstRay + 4; ray++) {
+        INDEX target = startIndex;
+        for (INDEX i = 0; i < Attacks::rays.length[startIndex][ray]; i++) {
+            target += Attacks::rayOffsets[ray];
+            // Stops once a piece is hit
+            if (add(startIndex, target, MOVE_QUIET, grid) != MOVE_CONTINUE) {
                 break;
             }
         }
     }
-    return capturedKing;
 }
 
-bool MoveGen::calculateKnightMoves(INDEX startIndex, const PIECE* grid) {
+void MoveGen::calculateKnightMoves(INDEX startIndex, const PIECE* grid) {
     // Type must be knight
     FLAG type = Piece::getFlag(grid[startIndex], MASK_TYPE);
     if (type != PIECE_KNIGHT) {
-        return MOVE_KING_NOT_CAPTURED;
-    }
-
-    INDEX movement[] = {
-        (INDEX)(startIndex + (2 * GRID_SIZE) - 1),
-        (INDEX)(startIndex + (2 * GRID_SIZE) + 1),
-        (INDEX)(startIndex + (2) + GRID_SIZE),
-        (INDEX)(startIndex + (2) - GRID_SIZE),
-        (INDEX)(startIndex - (2 * GRID_SIZE) + 1),
-        (INDEX)(startIndex - (2 * GRID_SIZE) - 1),
-        (INDEX)(startIndex - (2) - GRID_SIZE),
-        (INDEX)(startIndex - (2) + GRID_SIZE)
-    };
-
-    bool preChecks[] = {
-        startIndex % GRID_SIZE != 0,
-        startIndex % GRID_SIZE != GRID_SIZE - 1,
-        startIndex % GRID_SIZE < GRID_SIZE - 2,
-        startIndex % GRID_SIZE < GRID_SIZE - 2,
-        startIndex % GRID_SIZE != GRID_SIZE - 1,
-        startIndex % GRID_SIZE != 0,
-        startIndex % GRID_SIZE > 1,
-        startIndex % GRID_SIZE > 1
-    };
-
-    // Loop though all of the different moves and conditions
-    bool capturedKing = MOVE_KING_NOT_CAPTURED;
-    for (int i = 0; i < 8; i++) {
-        if(preChecks[i]) {
-            int addResult = add(startIndex, movement[i], 0, grid);
-            if (addResult == MOVE_CAPTURE_KING) {
-                capturedKing = MOVE_KING_CAPTURED;
-            }
-        }
+        return;
     }
 
-    return capturedKing;
+    // Loop though all of the squares a knight can hop to
+    BITBOARD targets = Attacks::knight.squares[startIndex];
+    while (targets) {
+        add(startIndex, Attacks::popLowest(targets), MOVE_QUIET, grid);
+    }
 }
 
-bool MoveGen::calculatePawnMoves(INDEX startIndex, const PIECE* grid) {
+void MoveGen::calculatePawnMoves(INDEX startIndex, const PIECE* grid) {
     // Type must be pawn
     FLAG type = Piece::getFlag(grid[startIndex], MASK_TYPE);
     if (type != PIECE_PAWN) {
-        return MOVE_KING_NOT_CAPTURED;
+        return;
     }
 
-    bool capturedKing = MOVE_KING_NOT_CAPTURED;
-    
     FLAG colour = Piece::getFlag(grid[startIndex], MASK_COLOUR);
     INDEX indexCheck = (colour == PIECE_WHITE ? GRID_SIZE : (-GRID_SIZE));
     // Single move check
-    int addResult = add(startIndex, startIndex + indexCheck, 0, grid);
+    int addResult = addPawn(startIndex, startIndex + indexCheck, MOVE_QUIET, grid);
     if (addResult != MOVE_END) {
         // Move was not blocked, check double move
-        if (Piece::hasFlag(grid[startIndex], MOVE_PAWN_FIRST_MOVE)) {
-            add(startIndex, startIndex + (2 * indexCheck), MOVE_PAWN_MOVE_TWO, grid);
+        if (Piece::hasFlag(grid[startIndex], FLAG_PAWN_FIRST_MOVE)) {
+            addPawn(startIndex, startIndex + (2 * indexCheck), MOVE_PAWN_MOVE_TWO, grid);
         }
     }
 
-    // Left attack check
-    addResult = add(startIndex, startIndex + indexCheck - 1, MOVE_PAWN_ATTACK, grid);
-    if (addResult == MOVE_CAPTURE_KING) {
-        capturedKing = MOVE_KING_CAPTURED;
+    // Loop through both diagonal attacks
+    BITBOARD targets = Attacks::pawn(colour, startIndex);
+    while (targets) {
+        addPawn(startIndex, Attacks::popLowest(targets), MOVE_CAPTURE, grid);
     }
-
-    // Right attack check
-    addResult = add(startIndex, startIndex + indexCheck + 1, MOVE_PAWN_ATTACK, grid);
-    if (addResult == MOVE_CAPTURE_KING) {
-        capturedKing = MOVE_KING_CAPTURED;
-    }
-
-    return capturedKing;
-}
-
-bool MoveGen::calculatePawnAttackMoves(INDEX start, const PIECE* grid) {
-    // Type must be pawn
-    FLAG type = Piece::getFlag(grid[start], MASK_TYPE);
-    if (type != PIECE_PAWN) {
-        return MOVE_KING_NOT_CAPTURED;
-    }
-
-    FLAG colour = Piece::getFlag(grid[start], MASK_COLOUR);
-    INDEX indexCheck = (colour == PIECE_WHITE ? GRID_SIZE : (-GRID_SIZE));
-
-    // Left attack check
-    bool capturedKing = MOVE_KING_NOT_CAPTURED;
-    Move moveleft(start, start + indexCheck - 1, MOVE_PAWN_ATTACK);
-    s_validMoves.push_back(moveleft);
-    if (Piece::getFlag(grid[moveleft.Target()], MASK_TYPE) == PIECE_KING) {
-        capturedKing = MOVE_KING_CAPTURED;
-    }
-
-    // Right attack check
-    Move moveright(start, start + indexCheck + 1, MOVE_PAWN_ATTACK);
-    s_validMoves.push_back(moveright);
-    if (Piece::getFlag(grid[moveright.Target()], MASK_TYPE) == PIECE_KING) {
-        capturedKing = MOVE_KING_CAPTURED;
-    }
-
-    return capturedKing;
 }
 
 // ----- Move ----- List ----- Functions -----
 
 FLAG MoveGen::add(INDEX start, INDEX target, FLAG flags, const PIECE* grid) {
-    // Ensure index is valid
-    if (0 > start || start >= GRID_SIZE * GRID_SIZE) {
-        return MOVE_END;
-    }
-    if (0 > target || target >= GRID_SIZE * GRID_SIZE) {
-        return MOVE_END;
-    }
-
-    // Always add start index as legal move
-    if (start == target) {
-        Move move(start, target, flags);
-        addLegal(move);
-        return MOVE_CONTINUE;
-    }
-
-    FLAG thisType = Piece::getFlag(grid[start], MASK_TYPE);
-    FLAG targetType = Piece::getFlag(grid[target], MASK_TYPE);
-    
-    // Pawns are special with their capturing
-    if (thisType == PIECE_PAWN) {
-        return addPawn(start, target, flags, grid);
-    }
-
     // No piece, add move
     if (grid[target] == 0 || grid[target] == PIECE_PHANTOM) {
         addValid(Move(start, target, flags));
@@ -406,57 +330,93 @@ FLAG MoveGen::add(INDEX start, INDEX target, FLAG flags, const PIECE* grid) {
     FLAG thisColour = Piece::getFlag(grid[start], MASK_COLOUR);
     FLAG targetColour = Piece::getFlag(grid[target], MASK_COLOUR);
     if (thisColour != targetColour) {
-        // Check if move is attacking a king
-        if (targetType == PIECE_KING) {
-            // Attacking king, add flag
-            addValid(Move(start, target, flags | MOVE_CHECK));
-            return MOVE_CAPTURE_KING;
-        }
         // Pieces are not the same colour, add move
-        addValid(Move(start, target, flags));
+        addValid(Move(start, target, flags | MOVE_CAPTURE));
     }
     return MOVE_END;
 }
 
-FLAG MoveGen::addPawn(INDEX start, INDEX target, FLAG flags, const PIECE* grid) {
+FLAG MoveGen::addPawn(INDEX start, INDEX target, FLAG kind, const PIECE* grid) {
+    // Ensure index is valid
+    if (0 > target || target >= GRID_SIZE * GRID_SIZE) {
+        return MOVE_END;
+    }
+
     FLAG thisColour = Piece::getFlag(grid[start], MASK_COLOUR);
     FLAG targetColour = Piece::getFlag(grid[target], MASK_COLOUR);
 
-    // Checks for pawn attack flag
-    if ((flags & MOVE_PAWN_ATTACK)) {
+    // Checks for pawn attack
+    if (kind == MOVE_CAPTURE) {
+        // Phantoms can only be captured en passant
+        if (grid[target] == PIECE_PHANTOM) {
+            addValid(Move(start, target, MOVE_EN_PASSANT));
+            return MOVE_END;
+        }
         // Check colours are not equal and that the target has a piece
-        // Alternatively, checks if the piece is a phantom
-        if ((thisColour != targetColour && targetColour) || (grid[target] == PIECE_PHANTOM)) {
-            addValid(Move(start, target, flags));
+        if (thisColour == targetColour || !targetColour) {
+            return MOVE_END;
         }
-        // Colours not equal, or no piece
-        return MOVE_END;
     }
     // Checks theres no piece
-    if (grid[target] == 0) {
-        addValid(Move(start, target, flags));
-        return MOVE_CONTINUE;
+    else if (grid[target] != 0) {
+        return MOVE_END;
     }
-    return MOVE_END;
-}
 
-void MoveGen::addValid(Move move) {
-    for (Move& valid : s_validMoves) {
-        if (move == valid) {
-            return;
-        }
+    // Reaching the last rank adds one move per promotion piece
+    INDEX rank = target / GRID_SIZE;
+    if (rank == 0 || rank == GRID_SIZE - 1) {
+        FLAG capture = (kind & MOVE_CAPTURE);
+        addValid(Move(start, target, MOVE_PROMOTION_QUEEN | capture));
+        addValid(Move(start, target, MOVE_PROMOTION_ROOK | capture));
+        addValid(Move(start, target, MOVE_PROMOTION_BISHOP | capture));
+        addValid(Move(start, target, MOVE_PROMOTION_KNIGHT | capture));
+        return MOVE_END;
     }
-    s_validMoves.push_back(move);
+
+    addValid(Move(start, target, kind));
+    return MOVE_CONTINUE;
 }
 
-void MoveGen::addLegal(Move& move) {
-    for (Move& legal : s_legalMoves) {
-        if (move == legal) {
-            return;
+void MoveGen::addValid(Move move) {
+    switch (s_mode) {
+    case GENERATE_VALID:
+        s_moves.push_back(move);
+        break;
+    case GENERATE_LEGAL:
+        if (MoveGen::isLegal(move)) {
+            s_moves.push_back(move);
         }
+        break;
+    // Only one legal move is needed
+    case GENERATE_ANY:
+        if (!s_found && MoveGen::isLegal(move)) {
+            s_found = true;
+        }
+        break;
+    case GENERATE_COUNT:
+        if (MoveGen::isLegal(move)) {
+            s_count++;
+            if (s_pieceCounts) {
+                s_pieceCounts[move.Start()]++;
+            }
+        }
+        break;
+    // Castling, en passant and promotions change more than the two squares, so are always tested
+    case GENERATE_CHECKS:
+        if ((move.Kind() != MOVE_QUIET && move.Kind() != MOVE_CAPTURE && move.Kind() != MOVE_PAWN_MOVE_TWO) ||
+            (s_filter & (BITBOARD_INDEX(move.Start()) | BITBOARD_INDEX(move.Target())))) {
+            if (MoveGen::givesCheck(move)) {
+                s_moves.push_back(move);
+            }
+        }
+        break;
+    // En passant can take a checking pawn without landing on it
+    case GENERATE_EVASIONS:
+        if ((move.Start() == s_king || move.Kind() == MOVE_EN_PASSANT || (s_filter & BITBOARD_INDEX(move.Target()))) && MoveGen::isLegal(move)) {
+            s_moves.push_back(move);
+        }
+        break;
+    default:
+        break;
     }
-    s_legalMoves.push_back(move);
 }
-
-
-
@@ -7,25 +7,28 @@
 // ----- Creation -----
 
 MoveManager::MoveManager() {
-    // Nothing todo
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        this->m_targets[i] = BITBOARD_EMPTY;
+    }
 }
 
 // ----- Read -----
 
 bool MoveManager::isLegal(Move& move) {
-    for(Move& legal : this->m_moves) {
-        // Checks positions are the same
-        if(move.Start() != legal.Start()) {
-            continue;
-        }
-        if (move.Target() != legal.Target()) {
-            continue;
-        }
-        // Adds flags from other moves
-        move.addFlags(legal.Flags());
+    Move legal = this->m_lookup[move.Start()][move.Target()];
+    if (!legal.isMove()) {
+        return false;
+    }
+    // Promotions share their squares, so keep the requested piece if there is one
+    if (legal.isPromotion() && move.isPromotion()) {
+        FLAG type = move.Promotion();
+        move.setKind(legal.Kind());
+        move.setPromotion(type);
         return true;
     }
-    return false;
+    // Adds kind from the legal move
+    move.setKind(legal.Kind());
+    return true;
 }
 
 std::vector<Move> MoveManager::getMoves(INDEX start) {
@@ -43,16 +46,41 @@ std::vector<Move> MoveManager::getMoves() {
     return this->m_moves;
 }
 
+BITBOARD MoveManager::getTargets(INDEX start) {
+    return this->m_targets[start];
+}
+
 // ----- Update -----
 
 void MoveManager::calculateMoves(FLAG colour, const PIECE* grid, bool calculateEnemyMoves) {
+    this->clearLookup();
     this->m_moves = MoveGen::generate(colour, grid, calculateEnemyMoves);
+
+    // Index moves so legality and flags are a single lookup
+    // Promotions share an entry, the first generated (queen) is stored
+    for (Move& move : this->m_moves) {
+        if (!this->m_lookup[move.Start()][move.Target()].isMove()) {
+            this->m_lookup[move.Start()][move.Target()] = move;
+        }
+        this->m_targets[move.Start()] |= BITBOARD_INDEX(move.Target());
+    }
 }
 
 void MoveManager::clear() {
+    this->clearLookup();
     this->m_moves.clear();
 }
 
+// ----- Update ----- Hidden -----
+
+void MoveManager::clearLookup() {
+    // Only the entries of the current moves were set
+    for (Move& move : this->m_moves) {
+        this->m_lookup[move.Start()][move.Target()] = Move();
+        this->m_targets[move.Start()] = BITBOARD_EMPTY;
+    }
+}
+
 // ----- Destruction -----
 
 MoveManager::~MoveManager() {
@@ -0,0 +1,614 @@
+#include "Nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "Piece.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NNUE_X86
+#include <immintrin.h>
+#endif
+
+struct nnueNetworkHolder {
+    alignas(32) short featureWeights[NNUE_FEATURES][NNUE_ACCUMULATOR_SIZE];
+    alignas(32) short featureBias[NNUE_ACCUMULATOR_SIZE];
+    // Both accumulators in, side to move first
+    alignas(32) short hiddenWeights[NNUE_HIDDEN_SIZE][2 * NNUE_ACCUMULATOR_SIZE];
+    alignas(32) int hiddenBias[NNUE_HIDDEN_SIZE];
+    alignas(32) short secondWeights[NNUE_HIDDEN_SIZE][NNUE_HIDDEN_SIZE];
+    alignas(32) int secondBias[NNUE_HIDDEN_SIZE];
+    alignas(32) short outputWeights[NNUE_HIDDEN_SIZE];
+    int outputBias;
+};
+
+namespace {
+
+    // Most rows one move adds or removes, castling adds two and removes two
+    constexpr int maxChanges = 3;
+    // Most rows summed in one pass when a batch fills its accumulators
+    constexpr int maxRows = 32;
+
+    // ----- Kernels -----
+
+    // Every kernel works on counts that are multiples of 16
+    // Batched inputs pack two activations in each int, first one in the low 16 bits, stored as in[pair * positions + position]
+    typedef struct nnueKernelsHolder {
+        const char* name;
+        // out = in + every added row - every removed row, out can be in
+        void (*update)(short* out, const short* in, const short* const* added, int addCount, const short* const* removed, int removeCount);
+        // Clamps to 0 to NNUE_ACTIVATION_MAX
+        void (*clip)(short* out, const short* in, int count);
+        // out[i] = bias[i] + in . weights row i, for rows in groups of 4
+        void (*affine)(const short* in, int count, const short* weights, const int* bias, int outputs, int* out);
+        // affine for every position at once, out[row * positions + position], positions is a multiple of 16
+        void (*affineBatch)(const int* in, int count, int positions, const short* weights, const int* bias, int outputs, int* out);
+    } NNUE_KERNELS;
+
+    void updateScalar(short* out, const short* in, const short* const* added, int addCount, const short* const* removed, int removeCount) {
+        for (int i = 0; i < NNUE_ACCUMULATOR_SIZE; i++) {
+            int value = in[i];
+            for (int j = 0; j < addCount; j++) {
+                value += added[j][i];
+            }
+            for (int j = 0; j < removeCount; j++) {
+                value -= removed[j][i];
+            }
+            out[i] = (short)value;
+        }
+    }
+
+    void clipScalar(short* out, const short* in, int count) {
+        for (int i = 0; i < count; i++) {
+            out[i] = std::clamp<short>(in[i], 0, NNUE_ACTIVATION_MAX);
+        }
+    }
+
+    void affineScalar(const short* in, int count, const short* weights, const int* bias, int outputs, int* out) {
+        for (int row = 0; row < outputs; row++) {
+            int sum = bias[row];
+            for (int i = 0; i < count; i++) {
+                sum += in[i] * weights[row * count + i];
+            }
+            out[row] = sum;
+        }
+    }
+
+    void affineBatchScalar(const int* in, int count, int positions, const short* weights, const int* bias, int outputs, int* out) {
+        for (int row = 0; row < outputs; row++) {
+            const short* w = weights + row * count;
+            for (int position = 0; position < positions; position++) {
+                int sum = bias[row];
+                for (int i = 0; i < count / 2; i++) {
+                    unsigned int pair = (unsigned int)in[i * positions + position];
+                    sum += (short)(pair & 0xFFFF) * w[2 * i] + (short)(pair >> 16) * w[2 * i + 1];
+                }
+                out[row * positions + position] = sum;
+            }
+        }
+    }
+
+    constexpr NNUE_KERNELS scalarKernels = { "scalar", updateScalar, clipScalar, affineScalar, affineBatchScalar };
+
+#ifdef NNUE_X86
+
+    __attribute__((target("sse2")))
+    void updateSSE2(short* out, const short* in, const short* const* added, int addCount, const short* const* removed, int removeCount) {
+        for (int i = 0; i < NNUE_ACCUMULATOR_SIZE; i += 8) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(in + i));
+            for (int j = 0; j < addCount; j++) {
+                value = _mm_add_epi16(value, _mm_loadu_si128((const __m128i*)(added[j] + i)));
+            }
+            for (int j = 0; j < removeCount; j++) {
+                value = _mm_sub_epi16(value, _mm_loadu_si128((const __m128i*)(removed[j] + i)));
+            }
+            _mm_storeu_si128((__m128i*)(out + i), value);
+        }
+    }
+
+    __attribute__((target("sse2")))
+    void clipSSE2(short* out, const short* in, int count) {
+        const __m128i low = _mm_setzero_si128();
+        const __m128i high = _mm_set1_epi16(NNUE_ACTIVATION_MAX);
+        for (int i = 0; i < count; i += 8) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(in + i));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_min_epi16(_mm_max_epi16(value, low), high));
+        }
+    }
+
+    // Four rows share each load of the input, their sums are added across lanes together at the end
+    __attribute__((target("sse2")))
+    void affineSSE2(const short* in, int count, const short* weights, const int* bias, int outputs, int* out) {
+        for (int row = 0; row < outputs; row += 4) {
+            const short* w = weights + row * count;
+            __m128i sum0 = _mm_setzero_si128(), sum1 = _mm_setzero_si128(), sum2 = _mm_setzero_si128(), sum3 = _mm_setzero_si128();
+            for (int i = 0; i < count; i += 8) {
+                __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+                sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(x, _mm_loadu_si128((const __m128i*)(w + i))));
+                sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(x, _mm_loadu_si128((const __m128i*)(w + count + i))));
+                sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(x, _mm_loadu_si128((const __m128i*)(w + 2 * count + i))));
+                sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(x, _mm_loadu_si128((const __m128i*)(w + 3 * count + i))));
+            }
+            // Transposes so each lane holds one row's partial sums
+            __m128i low01 = _mm_unpacklo_epi32(sum0, sum1), high01 = _mm_unpackhi_epi32(sum0, sum1);
+            __m128i low23 = _mm_unpacklo_epi32(sum2, sum3), high23 = _mm_unpackhi_epi32(sum2, sum3);
+            __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi64(low01, low23), _mm_unpackhi_epi64(low01, low23)),
+                _mm_add_epi32(_mm_unpacklo_epi64(high01, high23), _mm_unpackhi_epi64(high01, high23)));
+            sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i*)(bias + row)));
+            _mm_storeu_si128((__m128i*)(out + row), sum);
+        }
+    }
+
+    // Two weights next to each other in a row, laid out the same as a packed pair of activations
+    int weightPair(const short* weights) {
+        int pair;
+        std::memcpy(&pair, weights, sizeof(pair));
+        return pair;
+    }
+
+    // Four rows and eight positions at a time, each weight pair is broadcast to every position in a lane
+    __attribute__((target("sse2")))
+    void affineBatchSSE2(const int* in, int count, int positions, const short* weights, const int* bias, int outputs, int* out) {
+        for (int row = 0; row < outputs; row += 4) {
+            const short* w = weights + row * count;
+            for (int position = 0; position < positions; position += 8) {
+                __m128i sum00 = _mm_setzero_si128(), sum01 = _mm_setzero_si128(), sum10 = _mm_setzero_si128(), sum11 = _mm_setzero_si128();
+                __m128i sum20 = _mm_setzero_si128(), sum21 = _mm_setzero_si128(), sum30 = _mm_setzero_si128(), sum31 = _mm_setzero_si128();
+                for (int i = 0; i < count / 2; i++) {
+                    const int* x = in + i * positions + position;
+                    __m128i x0 = _mm_loadu_si128((const __m128i*)x);
+                    __m128i x1 = _mm_loadu_si128((const __m128i*)(x + 4));
+                    __m128i w0 = _mm_set1_epi32(::weightPair(w + 2 * i));
+                    __m128i w1 = _mm_set1_epi32(::weightPair(w + count + 2 * i));
+                    __m128i w2 = _mm_set1_epi32(::weightPair(w + 2 * count + 2 * i));
+                    __m128i w3 = _mm_set1_epi32(::weightPair(w + 3 * count + 2 * i));
+                    sum00 = _mm_add_epi32(sum00, _mm_madd_epi16(x0, w0));
+                    sum01 = _mm_add_epi32(sum01, _mm_madd_epi16(x1, w0));
+                    sum10 = _mm_add_epi32(sum10, _mm_madd_epi16(x0, w1));
+                    sum11 = _mm_add_epi32(sum11, _mm_madd_epi16(x1, w1));
+                    sum20 = _mm_add_epi32(sum20, _mm_madd_epi16(x0, w2));
+                    sum21 = _mm_add_epi32(sum21, _mm_madd_epi16(x1, w2));
+                    sum30 = _mm_add_epi32(sum30, _mm_madd_epi16(x0, w3));
+                    sum31 = _mm_add_epi32(sum31, _mm_madd_epi16(x1, w3));
+                }
+                __m128i sums[4][2] = { { sum00, sum01 }, { sum10, sum11 }, { sum20, sum21 }, { sum30, sum31 } };
+                for (int j = 0; j < 4; j++) {
+                    __m128i b = _mm_set1_epi32(bias[row + j]);
+                    int* o = out + (row + j) * positions + position;
+                    _mm_storeu_si128((__m128i*)o, _mm_add_epi32(sums[j][0], b));
+                    _mm_storeu_si128((__m128i*)(o + 4), _mm_add_epi32(sums[j][1], b));
+                }
+            }
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void updateAVX2(short* out, const short* in, const short* const* added, int addCount, const short* const* removed, int removeCount) {
+        for (int i = 0; i < NNUE_ACCUMULATOR_SIZE; i += 16) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(in + i));
+            for (int j = 0; j < addCount; j++) {
+                value = _mm256_add_epi16(value, _mm256_loadu_si256((const __m256i*)(added[j] + i)));
+            }
+            for (int j = 0; j < removeCount; j++) {
+                value = _mm256_sub_epi16(value, _mm256_loadu_si256((const __m256i*)(removed[j] + i)));
+            }
+            _mm256_storeu_si256((__m256i*)(out + i), value);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void clipAVX2(short* out, const short* in, int count) {
+        const __m256i low = _mm256_setzero_si256();
+        const __m256i high = _mm256_set1_epi16(NNUE_ACTIVATION_MAX);
+        for (int i = 0; i < count; i += 16) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(in + i));
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_min_epi16(_mm256_max_epi16(value, low), high));
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void affineAVX2(const short* in, int count, const short* weights, const int* bias, int outputs, int* out) {
+        for (int row = 0; row < outputs; row += 4) {
+            const short* w = weights + row * count;
+            __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256(), sum2 = _mm256_setzero_si256(), sum3 = _mm256_setzero_si256();
+            for (int i = 0; i < count; i += 16) {
+                __m256i x = _mm256_loadu_si256((const __m256i*)(in + i));
+                sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(x, _mm256_loadu_si256((const __m256i*)(w + i))));
+                sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(x, _mm256_loadu_si256((const __m256i*)(w + count + i))));
+                sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(x, _mm256_loadu_si256((const __m256i*)(w + 2 * count + i))));
+                sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(x, _mm256_loadu_si256((const __m256i*)(w + 3 * count + i))));
+            }
+            // Pairwise adds leave rows 0 to 3 in order in each half
+            __m256i sum = _mm256_hadd_epi32(_mm256_hadd_epi32(sum0, sum1), _mm256_hadd_epi32(sum2, sum3));
+            __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            total = _mm_add_epi32(total, _mm_loadu_si128((const __m128i*)(bias + row)));
+            _mm_storeu_si128((__m128i*)(out + row), total);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void affineBatchAVX2(const int* in, int count, int positions, const short* weights, const int* bias, int outputs, int* out) {
+        for (int row = 0; row < outputs; row += 4) {
+            const short* w = weights + row * count;
+            for (int position = 0; position < positions; position += 16) {
+                __m256i sum00 = _mm256_setzero_si256(), sum01 = _mm256_setzero_si256(), sum10 = _mm256_setzero_si256(), sum11 = _mm256_setzero_si256();
+                __m256i sum20 = _mm256_setzero_si256(), sum21 = _mm256_setzero_si256(), sum30 = _mm256_setzero_si256(), sum31 = _mm256_setzero_si256();
+                for (int i = 0; i < count / 2; i++) {
+                    const int* x = in + i * positions + position;
+                    __m256i x0 = _mm256_loadu_si256((const __m256i*)x);
+                    __m256i x1 = _mm256_loadu_si256((const __m256i*)(x + 8));
+                    __m256i w0 = _mm256_set1_epi32(::weightPair(w + 2 * i));
+                    __m256i w1 = _mm256_set1_epi32(::weightPair(w + count + 2 * i));
+                    __m256i w2 = _mm256_set1_epi32(::weightPair(w + 2 * count + 2 * i));
+                    __m256i w3 = _mm256_set1_epi32(::weightPair(w + 3 * count + 2 * i));
+                    sum00 = _mm256_add_epi32(sum00, _mm256_madd_epi16(x0, w0));
+                    sum01 = _mm256_add_epi32(sum01, _mm256_madd_epi16(x1, w0));
+                    sum10 = _mm256_add_epi32(sum10, _mm256_madd_epi16(x0, w1));
+                    sum11 = _mm256_add_epi32(sum11, _mm256_madd_epi16(x1, w1));
+                    sum20 = _mm256_add_epi32(sum20, _mm256_madd_epi16(x0, w2));
+                    sum21 = _mm256_add_epi32(sum21, _mm256_madd_epi16(x1, w2));
+                    sum30 = _mm256_add_epi32(sum30, _mm256_madd_epi16(x0, w3));
+                    sum31 = _mm256_add_epi32(sum31, _mm256_madd_epi16(x1, w3));
+                }
+                __m256i sums[4][2] = { { sum00, sum01 }, { sum10, sum11 }, { sum20, sum21 }, { sum30, sum31 } };
+                for (int j = 0; j < 4; j++) {
+                    __m256i b = _mm256_set1_epi32(bias[row + j]);
+                    int* o = out + (row + j) * positions + position;
+                    _mm256_storeu_si256((__m256i*)o, _mm256_add_epi32(sums[j][0], b));
+                    _mm256_storeu_si256((__m256i*)(o + 8), _mm256_add_epi32(sums[j][1], b));
+                }
+            }
+        }
+    }
+
+    constexpr NNUE_KERNELS sse2Kernels = { "sse2", updateSSE2, clipSSE2, affineSSE2, affineBatchSSE2 };
+    constexpr NNUE_KERNELS avx2Kernels = { "avx2", updateAVX2, clipAVX2, affineAVX2, affineBatchAVX2 };
+
+#endif
+
+    // Fastest kernels the machine runs
+    const NNUE_KERNELS* bestKernels() {
+#ifdef NNUE_X86
+        // Runs before main, so the CPU has to be read first
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return &avx2Kernels;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return &sse2Kernels;
+        }
+#endif
+        return &scalarKernels;
+    }
+
+    const NNUE_KERNELS* s_kernels = ::bestKernels();
+
+    // ----- Features -----
+
+    // Row for a piece seen from one side, which sees its own pieces first and its back rank as rank 1
+    int feature(int side, PIECE piece, INDEX index) {
+        FLAG colour = Piece::getFlag(piece, MASK_COLOUR);
+        FLAG type = Piece::getFlag(piece, MASK_TYPE);
+        bool own = ((colour == PIECE_WHITE) == (side == 0));
+        INDEX square = (side == 0 ? index : index ^ (GRID_SIZE * (GRID_SIZE - 1)));
+        return ((own ? 0 : 6) + type - PIECE_PAWN) * GRID_SIZE * GRID_SIZE + square;
+    }
+
+    bool isFeature(PIECE piece) {
+        FLAG type = Piece::getFlag(piece, MASK_TYPE);
+        return (type != PIECE_INVALID && type != PIECE_PHANTOM);
+    }
+
+    // ----- Layers -----
+
+    int activation(int sum) {
+        return std::clamp(sum >> NNUE_WEIGHT_SHIFT, 0, NNUE_ACTIVATION_MAX);
+    }
+
+    int score(int output) {
+        return (int)((long long)output * NNUE_OUTPUT_SCALE / (NNUE_ACTIVATION_MAX << NNUE_WEIGHT_SHIFT));
+    }
+
+    // Runs a dense layer and clips its outputs to activations
+    void dense(const short* in, int count, const short* weights, const int* bias, short* out) {
+        alignas(32) int sums[NNUE_HIDDEN_SIZE];
+        s_kernels->affine(in, count, weights, bias, NNUE_HIDDEN_SIZE, sums);
+        for (int i = 0; i < NNUE_HIDDEN_SIZE; i++) {
+            out[i] = (short)::activation(sums[i]);
+        }
+    }
+
+    int pack(int low, int high) {
+        return (int)((unsigned int)low | ((unsigned int)high << 16));
+    }
+
+    // Sums the bias and every feature row, up to maxRows of them in each pass over the accumulator
+    void accumulate(const nnueNetworkHolder& network, const unsigned short* features, size_t count, short* out) {
+        const short* rows[maxRows];
+        const short* in = network.featureBias;
+        size_t i = 0;
+        do {
+            int rowCount = 0;
+            for (; i < count && rowCount < maxRows; i++) {
+                rows[rowCount++] = network.featureWeights[features[i]];
+            }
+            s_kernels->update(out, in, rows, rowCount, nullptr, 0);
+            in = out;
+        } while (i < count);
+    }
+
+    // Clips a block's dense layer sums to activations packed in pairs for the next layer
+    void packActivations(const int* sums, int* pairs) {
+        for (int i = 0; i < NNUE_HIDDEN_SIZE / 2; i++) {
+            const int* low = sums + 2 * i * NNUE_BATCH_BLOCK;
+            const int* high = low + NNUE_BATCH_BLOCK;
+            for (int position = 0; position < NNUE_BATCH_BLOCK; position++) {
+                pairs[i * NNUE_BATCH_BLOCK + position] = ::pack(::activation(low[position]), ::activation(high[position]));
+            }
+        }
+    }
+
+    // ----- Files -----
+
+    // Numbers are stored least significant byte first
+    long long readNumber(const unsigned char*& data, int bytes) {
+        unsigned long long value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= (unsigned long long)data[i] << (8 * i);
+        }
+        data += bytes;
+        // Sign extends from the top bit read
+        int shift = 64 - 8 * bytes;
+        return (long long)(value << shift) >> shift;
+    }
+
+    template <typename T>
+    void readNumbers(const unsigned char*& data, T* values, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            values[i] = (T)::readNumber(data, sizeof(T));
+        }
+    }
+
+}
+
+// ----- Creation -----
+
+Nnue::Nnue() {}
+
+bool Nnue::load(const std::string& path) {
+    this->m_network.reset();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Every weight is 16 bits and every bias 32 bits, except the feature biases
+    const size_t size = NNUE_HEADER_SIZE
+        + 2 * (NNUE_FEATURES * NNUE_ACCUMULATOR_SIZE + NNUE_ACCUMULATOR_SIZE)
+        + 2 * NNUE_HIDDEN_SIZE * 2 * NNUE_ACCUMULATOR_SIZE + 4 * NNUE_HIDDEN_SIZE
+        + 2 * NNUE_HIDDEN_SIZE * NNUE_HIDDEN_SIZE + 4 * NNUE_HIDDEN_SIZE
+        + 2 * NNUE_HIDDEN_SIZE + 4;
+    const unsigned char* read = data.data();
+    if (data.size() != size || std::memcmp(read, NNUE_MAGIC, 4) != 0) {
+        std::cout << "Not a network file: " << path << std::endl;
+        return false;
+    }
+    read += 4;
+    long long version = ::readNumber(read, 4);
+    long long accumulatorSize = ::readNumber(read, 4);
+    long long hiddenSize = ::readNumber(read, 4);
+    if (version != NNUE_VERSION || accumulatorSize != NNUE_ACCUMULATOR_SIZE || hiddenSize != NNUE_HIDDEN_SIZE) {
+        std::cout << "Network has the wrong layer sizes: " << path << std::endl;
+        return false;
+    }
+
+    std::unique_ptr<nnueNetworkHolder> network(new nnueNetworkHolder());
+    ::readNumbers(read, &network->featureWeights[0][0], NNUE_FEATURES * NNUE_ACCUMULATOR_SIZE);
+    ::readNumbers(read, network->featureBias, NNUE_ACCUMULATOR_SIZE);
+    ::readNumbers(read, &network->hiddenWeights[0][0], NNUE_HIDDEN_SIZE * 2 * NNUE_ACCUMULATOR_SIZE);
+    ::readNumbers(read, network->hiddenBias, NNUE_HIDDEN_SIZE);
+    ::readNumbers(read, &network->secondWeights[0][0], NNUE_HIDDEN_SIZE * NNUE_HIDDEN_SIZE);
+    ::readNumbers(read, network->secondBias, NNUE_HIDDEN_SIZE);
+    ::readNumbers(read, network->outputWeights, NNUE_HIDDEN_SIZE);
+    ::readNumbers(read, &network->outputBias, 1);
+    this->m_network = std::move(network);
+    return true;
+}
+
+// ----- Read -----
+
+bool Nnue::isLoaded() const {
+    return (this->m_network != nullptr);
+}
+
+std::string Nnue::Kernel() {
+    return s_kernels->name;
+}
+
+void Nnue::refresh(const PIECE* grid, NNUE_ACCUMULATOR& accumulator) const {
+    const nnueNetworkHolder& network = *this->m_network;
+    for (int side = 0; side < 2; side++) {
+        std::memcpy(accumulator.values[side], network.featureBias, sizeof(network.featureBias));
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            if (::isFeature(grid[i])) {
+                const short* row = network.featureWeights[::feature(side, grid[i], i)];
+                s_kernels->update(accumulator.values[side], accumulator.values[side], &row, 1, nullptr, 0);
+            }
+        }
+    }
+}
+
+void Nnue::update(Move move, const PIECE* grid, const NNUE_ACCUMULATOR& accumulator, NNUE_ACCUMULATOR& next) const {
+    INDEX start = move.Start();
+    INDEX target = move.Target();
+    PIECE piece = grid[start];
+    FLAG colour = Piece::getFlag(piece, MASK_COLOUR);
+    INDEX forward = (colour == PIECE_WHITE ? GRID_SIZE : (-GRID_SIZE));
+
+    // Pieces taken off and put on squares, same as Position::play
+    PIECE removedPieces[maxChanges], addedPieces[maxChanges];
+    INDEX removedIndices[maxChanges], addedIndices[maxChanges];
+    int removeCount = 0, addCount = 0;
+    auto remove = [&](PIECE removedPiece, INDEX index) {
+        removedPieces[removeCount] = removedPiece;
+        removedIndices[removeCount++] = index;
+    };
+    auto add = [&](PIECE addedPiece, INDEX index) {
+        addedPieces[addCount] = addedPiece;
+        addedIndices[addCount++] = index;
+    };
+
+    remove(piece, start);
+    add(move.isPromotion() ? (PIECE)(move.Promotion() | colour) : piece, target);
+    if (::isFeature(grid[target])) {
+        remove(grid[target], target);
+    }
+    switch (move.Kind()) {
+    case MOVE_EN_PASSANT:
+        remove(grid[target - forward], target - forward);
+        break;
+    case MOVE_CASTLE_KING:
+        remove(grid[start + 3], start + 3);
+        add(grid[start + 3], start + 1);
+        break;
+    case MOVE_CASTLE_QUEEN:
+        remove(grid[start - 4], start - 4);
+        add(grid[start - 4], start - 1);
+        break;
+    default:
+        break;
+    }
+
+    const nnueNetworkHolder& network = *this->m_network;
+    for (int side = 0; side < 2; side++) {
+        const short* added[maxChanges];
+        const short* removed[maxChanges];
+        for (int i = 0; i < addCount; i++) {
+            added[i] = network.featureWeights[::feature(side, addedPieces[i], addedIndices[i])];
+        }
+        for (int i = 0; i < removeCount; i++) {
+            removed[i] = network.featureWeights[::feature(side, removedPieces[i], removedIndices[i])];
+        }
+        s_kernels->update(next.values[side], accumulator.values[side], added, addCount, removed, removeCount);
+    }
+}
+
+int Nnue::evaluate(const NNUE_ACCUMULATOR& accumulator, FLAG colour) const {
+    const nnueNetworkHolder& network = *this->m_network;
+    int us = (colour == PIECE_WHITE ? 0 : 1);
+    alignas(32) short input[2 * NNUE_ACCUMULATOR_SIZE];
+    s_kernels->clip(input, accumulator.values[us], NNUE_ACCUMULATOR_SIZE);
+    s_kernels->clip(input + NNUE_ACCUMULATOR_SIZE, accumulator.values[1 - us], NNUE_ACCUMULATOR_SIZE);
+
+    alignas(32) short hidden[NNUE_HIDDEN_SIZE];
+    alignas(32) short second[NNUE_HIDDEN_SIZE];
+    ::dense(input, 2 * NNUE_ACCUMULATOR_SIZE, &network.hiddenWeights[0][0], network.hiddenBias, hidden);
+    ::dense(hidden, NNUE_HIDDEN_SIZE, &network.secondWeights[0][0], network.secondBias, second);
+
+    int output = network.outputBias;
+    for (int i = 0; i < NNUE_HIDDEN_SIZE; i++) {
+        output += second[i] * network.outputWeights[i];
+    }
+    return ::score(output);
+}
+
+int Nnue::evaluate(FLAG colour, const PIECE* grid) const {
+    NNUE_ACCUMULATOR accumulator;
+    this->refresh(grid, accumulator);
+    return this->evaluate(accumulator, colour);
+}
+
+void Nnue::toBatch(const POSITION* positions, size_t count, NNUE_BATCH& batch) {
+    batch.count = count;
+    batch.sides.resize(count);
+    batch.offsets.assign(1, 0);
+    batch.offsets.reserve(count + 1);
+    // Room for a full set of pieces in every position
+    for (int side = 0; side < 2; side++) {
+        batch.features[side].clear();
+        batch.features[side].reserve(count * maxRows);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const PIECE* grid = positions[i].grid;
+        batch.sides[i] = (positions[i].colour == PIECE_WHITE ? 0 : 1);
+        for (INDEX j = 0; j < GRID_SIZE * GRID_SIZE; j++) {
+            if (::isFeature(grid[j])) {
+                batch.features[0].push_back((unsigned short)::feature(0, grid[j], j));
+                batch.features[1].push_back((unsigned short)::feature(1, grid[j], j));
+            }
+        }
+        batch.offsets.push_back((unsigned int)batch.features[0].size());
+    }
+}
+
+void Nnue::evaluate(const NNUE_BATCH& batch, int* scores) const {
+    const nnueNetworkHolder& network = *this->m_network;
+    // Activations of every position in a block, the last block is padded with the ones before it
+    std::vector<int> input(NNUE_ACCUMULATOR_SIZE * NNUE_BATCH_BLOCK);
+    std::vector<int> sums(NNUE_HIDDEN_SIZE * NNUE_BATCH_BLOCK);
+    std::vector<int> hidden(NNUE_HIDDEN_SIZE / 2 * NNUE_BATCH_BLOCK);
+    alignas(32) short accumulator[NNUE_ACCUMULATOR_SIZE];
+    alignas(32) short clipped[NNUE_ACCUMULATOR_SIZE];
+
+    for (size_t first = 0; first < batch.count; first += NNUE_BATCH_BLOCK) {
+        size_t count = std::min<size_t>(batch.count - first, NNUE_BATCH_BLOCK);
+        for (size_t position = 0; position < count; position++) {
+            size_t index = first + position;
+            int us = batch.sides[index];
+            size_t offset = batch.offsets[index];
+            size_t features = batch.offsets[index + 1] - offset;
+            // Side to move's accumulator first, same as a single evaluation
+            for (int half = 0; half < 2; half++) {
+                int side = (half == 0 ? us : 1 - us);
+                ::accumulate(network, batch.features[side].data() + offset, features, accumulator);
+                s_kernels->clip(clipped, accumulator, NNUE_ACCUMULATOR_SIZE);
+                int* pairs = input.data() + half * (NNUE_ACCUMULATOR_SIZE / 2) * NNUE_BATCH_BLOCK + position;
+                for (int i = 0; i < NNUE_ACCUMULATOR_SIZE / 2; i++) {
+                    pairs[i * NNUE_BATCH_BLOCK] = ::pack(clipped[2 * i], clipped[2 * i + 1]);
+                }
+            }
+        }
+
+        s_kernels->affineBatch(input.data(), 2 * NNUE_ACCUMULATOR_SIZE, NNUE_BATCH_BLOCK, &network.hiddenWeights[0][0], network.hiddenBias, NNUE_HIDDEN_SIZE, sums.data());
+        ::packActivations(sums.data(), hidden.data());
+        s_kernels->affineBatch(hidden.data(), NNUE_HIDDEN_SIZE, NNUE_BATCH_BLOCK, &network.secondWeights[0][0], network.secondBias, NNUE_HIDDEN_SIZE, sums.data());
+        for (size_t position = 0; position < count; position++) {
+            int output = network.outputBias;
+            for (int i = 0; i < NNUE_HIDDEN_SIZE; i++) {
+                output += ::activation(sums[i * NNUE_BATCH_BLOCK + position]) * network.outputWeights[i];
+            }
+            scores[first + position] = ::score(output);
+        }
+    }
+}
+
+// ----- Update -----
+
+bool Nnue::useKernel(const std::string& name) {
+    const NNUE_KERNELS* kernels = nullptr;
+    if (name == "scalar") {
+        kernels = &scalarKernels;
+    }
+#ifdef NNUE_X86
+    else if (name == "sse2" && __builtin_cpu_supports("sse2")) {
+        kernels = &sse2Kernels;
+    }
+    else if (name == "avx2" && __builtin_cpu_supports("avx2")) {
+        kernels = &avx2Kernels;
+    }
+#endif
+    if (!kernels) {
+        return false;
+    }
+    s_kernels = kernels;
+    return true;
+}
+
+// ----- Destruction -----
+
+Nnue::~Nnue() {}
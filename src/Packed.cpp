@@ -0,0 +1,151 @@
+#include "Packed.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "Attacks.h"
+#include "MappedFile.h"
+#include "Piece.h"
+#include "Threads.h"
+
+bool Packed::pack(const POSITION& position, PACKED_POSITION& packed) {
+    for (int i = 0; i < PACKED_SIZE; i++) {
+        packed.data[i] = 0;
+    }
+
+    // Phantoms are stored as the en passant square instead
+    BITBOARD occupancy = BITBOARD_EMPTY;
+    int pieces = 0;
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        FLAG type = Piece::getFlag(position.grid[i], MASK_TYPE);
+        if (type == PIECE_INVALID || type == PIECE_PHANTOM) {
+            continue;
+        }
+        if (pieces == PACKED_MAX_PIECES) {
+            return false;
+        }
+
+        // Black sets the top bit of the code
+        int code = type | (Piece::getFlag(position.grid[i], MASK_COLOUR) == PIECE_BLACK ? 0x8 : 0);
+        packed.data[PACKED_PIECES + pieces / 2] |= (code << (4 * (pieces % 2)));
+        occupancy |= BITBOARD_INDEX(i);
+        pieces++;
+    }
+    for (int i = 0; i < 8; i++) {
+        packed.data[PACKED_OCCUPANCY + i] = (unsigned char)(occupancy >> (8 * i));
+    }
+
+    packed.data[PACKED_STATE] = Position::castlingRights(position.grid) | (position.colour == PIECE_WHITE ? 0x10 : 0);
+
+    INDEX phantom = Position::findPhantom(position.colour, position.grid);
+    packed.data[PACKED_EN_PASSANT] = (phantom == CODE_INVALID ? PACKED_NO_EN_PASSANT : phantom);
+
+    int halfmoves = std::min(std::max(position.halfmoves, 0), 0xFF);
+    int fullmoves = std::min(std::max(position.fullmoves, 0), 0xFFFF);
+    packed.data[PACKED_HALFMOVES] = halfmoves;
+    packed.data[PACKED_FULLMOVES] = fullmoves & 0xFF;
+    packed.data[PACKED_FULLMOVES + 1] = fullmoves >> 8;
+    return true;
+}
+
+bool Packed::unpack(const PACKED_POSITION& packed, POSITION& position) {
+    BITBOARD occupancy = BITBOARD_EMPTY;
+    for (int i = 0; i < 8; i++) {
+        occupancy |= (BITBOARD)packed.data[PACKED_OCCUPANCY + i] << (8 * i);
+    }
+
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        position.grid[i] = PIECE_INVALID;
+    }
+
+    int pieces = 0;
+    while (occupancy) {
+        if (pieces == PACKED_MAX_PIECES) {
+            return false;
+        }
+        int code = (packed.data[PACKED_PIECES + pieces / 2] >> (4 * (pieces % 2))) & 0xF;
+        FLAG type = code & MASK_TYPE;
+        if (type == PIECE_INVALID || type == PIECE_PHANTOM) {
+            return false;
+        }
+        position.grid[Attacks::popLowest(occupancy)] = type | (code & 0x8 ? PIECE_BLACK : PIECE_WHITE);
+        pieces++;
+    }
+
+    FLAG state = packed.data[PACKED_STATE];
+    position.colour = (state & 0x10 ? PIECE_WHITE : PIECE_BLACK);
+    position.halfmoves = packed.data[PACKED_HALFMOVES];
+    position.fullmoves = packed.data[PACKED_FULLMOVES] | (packed.data[PACKED_FULLMOVES + 1] << 8);
+
+    INDEX phantom = packed.data[PACKED_EN_PASSANT];
+    if (phantom != PACKED_NO_EN_PASSANT) {
+        if (phantom >= GRID_SIZE * GRID_SIZE || position.grid[phantom]) {
+            return false;
+        }
+        position.grid[phantom] = PIECE_PHANTOM;
+    }
+
+    Position::setFlags(state & 0xF, position.grid);
+    return true;
+}
+
+bool Packed::write(const std::string& path, const std::vector<POSITION>& positions) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "Could not open file: " << path << std::endl;
+        return false;
+    }
+
+    // Positions are packed in blocks to keep writes large
+    std::vector<PACKED_POSITION> block;
+    block.reserve(4096);
+    for (size_t i = 0; i < positions.size(); i++) {
+        PACKED_POSITION packed;
+        if (!Packed::pack(positions[i], packed)) {
+            std::cout << "Position " << i << " has too many pieces to pack" << std::endl;
+            return false;
+        }
+        block.push_back(packed);
+        if (block.size() == block.capacity() || i + 1 == positions.size()) {
+            file.write((const char*)block.data(), block.size() * sizeof(PACKED_POSITION));
+            block.clear();
+        }
+    }
+    return (bool)file;
+}
+
+bool Packed::read(const std::string& path, std::vector<POSITION>& positions, int threads) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cout << "Could not open file: " << path << std::endl;
+        return false;
+    }
+    if (file.Size() % PACKED_SIZE) {
+        std::cout << "File is not a whole number of packed positions: " << path << std::endl;
+        return false;
+    }
+
+    // Each position unpacks straight into its final place, threads take blocks of them
+    size_t first = positions.size();
+    size_t count = file.Size() / PACKED_SIZE;
+    size_t blockSize = 4096;
+    positions.resize(first + count);
+    const PACKED_POSITION* packed = (const PACKED_POSITION*)file.Data();
+    std::vector<char> valid(count, true);
+    Threads::parallelFor((count + blockSize - 1) / blockSize, threads, [&](size_t block, int) {
+        size_t end = std::min(count, (block + 1) * blockSize);
+        for (size_t i = block * blockSize; i < end; i++) {
+            valid[i] = Packed::unpack(packed[i], positions[first + i]);
+        }
+    });
+
+    for (size_t i = 0; i < count; i++) {
+        if (!valid[i]) {
+            std::cout << "Position " << i << " in " << path << " is not valid" << std::endl;
+            positions.resize(first);
+            return false;
+        }
+    }
+    return true;
+}
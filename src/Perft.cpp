@@ -0,0 +1,183 @@
+#include "Perft.h"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+
+#include "MoveGen.h"
+#include "Threads.h"
+#include "Zobrist.h"
+
+namespace {
+
+    // Check is the hash xored with the data, so torn writes from another thread fail the probe
+    typedef struct perftEntry {
+        std::atomic<HASH> check;
+        std::atomic<unsigned long long> data;
+    } PERFT_ENTRY;
+
+    typedef struct perftTable {
+        std::unique_ptr<PERFT_ENTRY[]> entries;
+        size_t mask;
+    } PERFT_TABLE;
+
+    // A position waiting to be counted by a thread
+    typedef struct perftTask {
+        PIECE grid[GRID_SIZE * GRID_SIZE];
+        FLAG colour;
+    } PERFT_TASK;
+
+    // Allocates the largest power of two entries that fits in the size
+    bool allocate(PERFT_TABLE& table, int megabytes) {
+        size_t entries = ((size_t)megabytes << 20) / sizeof(PERFT_ENTRY);
+        if (entries == 0) {
+            return false;
+        }
+        size_t size = 1;
+        while (size * 2 <= entries) {
+            size *= 2;
+        }
+        table.entries.reset(new PERFT_ENTRY[size]());
+        table.mask = size - 1;
+        return true;
+    }
+
+    // Data stores the node count above the depth
+    bool probe(PERFT_TABLE& table, HASH hash, int depth, unsigned long long& nodes) {
+        PERFT_ENTRY& entry = table.entries[(hash + depth) & table.mask];
+        unsigned long long data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ data) != hash || (int)(data & 0xFF) != depth) {
+            return false;
+        }
+        nodes = data >> 8;
+        return true;
+    }
+
+    void store(PERFT_TABLE& table, HASH hash, int depth, unsigned long long nodes) {
+        PERFT_ENTRY& entry = table.entries[(hash + depth) & table.mask];
+        unsigned long long data = (nodes << 8) | (unsigned long long)depth;
+        entry.check.store(hash ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+    unsigned long long hashedPerft(FLAG colour, const PIECE* grid, int depth, PERFT_TABLE* table) {
+        // Bulk counted plies are cheaper than a table lookup
+        if (!table || depth <= 1) {
+            return Perft::perft(colour, grid, depth);
+        }
+
+        HASH hash = Zobrist::hash(colour, grid);
+        unsigned long long nodes = 0;
+        if (::probe(*table, hash, depth, nodes)) {
+            return nodes;
+        }
+
+        FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+        std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+        PIECE editGrid[GRID_SIZE * GRID_SIZE];
+        for (Move& move : moves) {
+            for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+                editGrid[i] = grid[i];
+            }
+            Position::play(move, editGrid);
+            nodes += ::hashedPerft(enemy, editGrid, depth - 1, table);
+        }
+
+        ::store(*table, hash, depth, nodes);
+        return nodes;
+    }
+
+    // Replaces each task with the positions after each of its legal moves
+    std::vector<PERFT_TASK> expand(const std::vector<PERFT_TASK>& tasks) {
+        std::vector<PERFT_TASK> children;
+        for (const PERFT_TASK& task : tasks) {
+            FLAG enemy = (task.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+            std::vector<Move> moves = MoveGen::generate(task.colour, task.grid, true);
+            for (Move& move : moves) {
+                PERFT_TASK child = task;
+                child.colour = enemy;
+                Position::play(move, child.grid);
+                children.push_back(child);
+            }
+        }
+        return children;
+    }
+
+}
+
+unsigned long long Perft::perft(FLAG colour, const PIECE* grid, int depth) {
+    if (depth <= 0) {
+        return 1;
+    }
+    // Bulk counting, no need to play the last ply
+    if (depth == 1) {
+        return MoveGen::count(colour, grid);
+    }
+
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+
+    // Play each move on a copy of the grid and count below it
+    unsigned long long nodes = 0;
+    PIECE editGrid[GRID_SIZE * GRID_SIZE];
+    for (Move& move : moves) {
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            editGrid[i] = grid[i];
+        }
+        Position::play(move, editGrid);
+        nodes += Perft::perft(enemy, editGrid, depth - 1);
+    }
+    return nodes;
+}
+
+unsigned long long Perft::perft(FLAG colour, const PIECE* grid, int depth, int threads, int hashMegabytes) {
+    if (depth <= 1) {
+        return Perft::perft(colour, grid, depth);
+    }
+
+    PERFT_TABLE table;
+    PERFT_TABLE* tablePointer = (::allocate(table, hashMegabytes) ? &table : nullptr);
+
+    // Split deeper than the root until every thread has plenty of work
+    // Leaves at least two plies below the split so the table has something to store
+    std::vector<PERFT_TASK> tasks(1);
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        tasks[0].grid[i] = grid[i];
+    }
+    tasks[0].colour = colour;
+    int splitDepth = 0;
+    do {
+        tasks = ::expand(tasks);
+        splitDepth++;
+    } while (tasks.size() < (size_t)threads * 16 && depth - splitDepth > 2);
+
+    std::vector<unsigned long long> counts(tasks.size(), 0);
+    Threads::parallelFor(tasks.size(), threads, [&](size_t index, int) {
+        counts[index] = ::hashedPerft(tasks[index].colour, tasks[index].grid, depth - splitDepth, tablePointer);
+    });
+
+    unsigned long long nodes = 0;
+    for (unsigned long long count : counts) {
+        nodes += count;
+    }
+    return nodes;
+}
+
+unsigned long long Perft::divide(FLAG colour, const PIECE* grid, int depth) {
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+
+    unsigned long long total = 0;
+    PIECE editGrid[GRID_SIZE * GRID_SIZE];
+    for (Move& move : moves) {
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            editGrid[i] = grid[i];
+        }
+        Position::play(move, editGrid);
+        unsigned long long nodes = Perft::perft(enemy, editGrid, depth - 1);
+        std::cout << move.toString() << ": " << nodes << std::endl;
+        total += nodes;
+    }
+    std::cout << std::endl << "Nodes: " << total << std::endl;
+    return total;
+}
@@ -0,0 +1,350 @@
+#include "Pgn.h"
+
+#include <fstream>
+#include <iostream>
+
+#include "Fen.h"
+#include "San.h"
+#include "Threads.h"
+
+namespace {
+
+    bool isSpace(char c) {
+        return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+    }
+
+    // Reads a tag pair such as [Event "Name"], escaped quotes and backslashes are allowed in the value
+    bool readTag(std::string_view line, GAME& game, std::string& error) {
+        size_t nameEnd = line.find_first_of(" \t", 1);
+        size_t quote = line.find('"');
+        if (nameEnd == std::string_view::npos || quote == std::string_view::npos || quote < nameEnd) {
+            error = "Invalid tag '" + std::string(line) + "'";
+            return false;
+        }
+
+        std::string value;
+        size_t i = quote + 1;
+        for (; i < line.size() && line[i] != '"'; i++) {
+            if (line[i] == '\\' && i + 1 < line.size()) {
+                i++;
+            }
+            value += line[i];
+        }
+        if (i >= line.size()) {
+            error = "Tag '" + std::string(line) + "' has no closing quote";
+            return false;
+        }
+
+        game.tags.emplace_back(std::string(line.substr(1, nameEnd - 1)), value);
+        return true;
+    }
+
+    // Skips past the end of a variation, which can have its own variations and comments
+    size_t skipVariation(std::string_view text, size_t i) {
+        int depth = 0;
+        for (; i < text.size(); i++) {
+            if (text[i] == '{') {
+                size_t end = text.find('}', i);
+                i = (end == std::string_view::npos ? text.size() : end);
+            }
+            else if (text[i] == '(') {
+                depth++;
+            }
+            else if (text[i] == ')' && --depth == 0) {
+                return i + 1;
+            }
+        }
+        return text.size();
+    }
+
+    bool isResult(std::string_view token) {
+        return (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*");
+    }
+
+    // Returns the start of each game in the text
+    // A game starts at a tag line that comes after movetext
+    std::vector<size_t> findGames(std::string_view text) {
+        std::vector<size_t> starts;
+        bool inMoves = true;
+        size_t i = 0;
+        while (i < text.size()) {
+            size_t end = text.find('\n', i);
+            end = (end == std::string_view::npos ? text.size() : end);
+
+            // Leading spaces do not change what the line is
+            size_t first = i;
+            while (first < end && (text[first] == ' ' || text[first] == '\t')) {
+                first++;
+            }
+            if (first < end && text[first] != '\r') {
+                if (text[first] == '[') {
+                    if (inMoves) {
+                        starts.push_back(i);
+                    }
+                    inMoves = false;
+                }
+                else {
+                    inMoves = true;
+                }
+            }
+            i = end + 1;
+        }
+        return starts;
+    }
+
+    // Writes the value with quotes and backslashes escaped
+    std::string escape(const std::string& value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+}
+
+bool Pgn::parse(std::string_view text, GAME& game, std::string& error) {
+    game.tags.clear();
+    game.moves.clear();
+    game.result.clear();
+
+    // Tags come first, one per line
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && ::isSpace(text[i])) {
+            i++;
+        }
+        if (i >= text.size() || text[i] != '[') {
+            break;
+        }
+        size_t end = text.find('\n', i);
+        end = (end == std::string_view::npos ? text.size() : end);
+        std::string_view line = text.substr(i, end - i);
+        while (!line.empty() && ::isSpace(line.back())) {
+            line.remove_suffix(1);
+        }
+        if (!::readTag(line, game, error)) {
+            return false;
+        }
+        i = end;
+    }
+
+    POSITION position;
+    if (!Pgn::startPosition(game, position)) {
+        error = "Invalid FEN tag '" + Pgn::getTag(game, "FEN") + "'";
+        return false;
+    }
+
+    // Movetext, each token is read and played on the position
+    while (i < text.size()) {
+        char c = text[i];
+        if (::isSpace(c)) {
+            i++;
+            continue;
+        }
+        // Comments and variations are not kept
+        if (c == '{') {
+            size_t end = text.find('}', i);
+            i = (end == std::string_view::npos ? text.size() : end + 1);
+            continue;
+        }
+        // Escaped lines start with %
+        if (c == ';' || (c == '%' && (i == 0 || text[i - 1] == '\n'))) {
+            size_t end = text.find('\n', i);
+            i = (end == std::string_view::npos ? text.size() : end + 1);
+            continue;
+        }
+        if (c == '(') {
+            i = ::skipVariation(text, i);
+            continue;
+        }
+
+        size_t end = i;
+        while (end < text.size() && !::isSpace(text[end]) && text[end] != '{' && text[end] != '(' && text[end] != ';') {
+            end++;
+        }
+        std::string_view token = text.substr(i, end - i);
+        i = end;
+
+        if (::isResult(token)) {
+            game.result = std::string(token);
+            break;
+        }
+        // Annotation glyphs
+        if (token[0] == '$') {
+            continue;
+        }
+        // Move numbers can be joined to the move, such as 1.e4 or 12...Nf6
+        // Castling written with zeros is not a number
+        if (isdigit(token[0]) && token.substr(0, 3) != "0-0") {
+            size_t dots = token.find_first_not_of("0123456789");
+            if (dots == std::string_view::npos || token[dots] != '.') {
+                error = "Invalid token '" + std::string(token) + "'";
+                return false;
+            }
+            size_t moveStart = token.find_first_not_of('.', dots);
+            if (moveStart == std::string_view::npos) {
+                continue;
+            }
+            token.remove_prefix(moveStart);
+        }
+
+        Move move = San::fromSAN(token, position.colour, position.grid);
+        if (!move.isMove()) {
+            error = "Illegal move '" + std::string(token) + "' at ply " + std::to_string(game.moves.size() + 1);
+            return false;
+        }
+        Position::play(move, position.grid);
+        position.colour = (position.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+        game.moves.push_back(move);
+    }
+
+    // Result tag covers movetext with no result at the end
+    if (game.result.empty()) {
+        std::string result = Pgn::getTag(game, "Result");
+        game.result = (::isResult(result) ? result : "*");
+    }
+    return true;
+}
+
+std::string Pgn::getTag(const GAME& game, const std::string& name) {
+    for (const std::pair<std::string, std::string>& tag : game.tags) {
+        if (tag.first == name) {
+            return tag.second;
+        }
+    }
+    return "";
+}
+
+void Pgn::setTag(GAME& game, const std::string& name, const std::string& value) {
+    for (std::pair<std::string, std::string>& tag : game.tags) {
+        if (tag.first == name) {
+            tag.second = value;
+            return;
+        }
+    }
+    game.tags.emplace_back(name, value);
+}
+
+bool Pgn::startPosition(const GAME& game, POSITION& position) {
+    std::string fen = Pgn::getTag(game, "FEN");
+    std::string error;
+    return Fen::parse(fen.empty() ? startFEN : fen, position, error);
+}
+
+std::string Pgn::toPGN(const GAME& game) {
+    std::string pgn;
+    for (const std::pair<std::string, std::string>& tag : game.tags) {
+        pgn += "[" + tag.first + " \"" + ::escape(tag.second) + "\"]\n";
+    }
+    pgn += '\n';
+
+    POSITION position;
+    Pgn::startPosition(game, position);
+
+    // Tokens are added to the line until it is full
+    std::string line;
+    auto addToken = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() >= PGN_LINE_LENGTH) {
+            pgn += line + '\n';
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + token;
+    };
+
+    int fullmoves = position.fullmoves;
+    for (size_t i = 0; i < game.moves.size(); i++) {
+        Move move = game.moves[i];
+        if (position.colour == PIECE_WHITE) {
+            addToken(std::to_string(fullmoves) + ".");
+        }
+        // Black moving first needs its own move number
+        else if (i == 0) {
+            addToken(std::to_string(fullmoves) + "...");
+        }
+        addToken(San::toSAN(move, position.colour, position.grid));
+
+        Position::play(move, position.grid);
+        if (position.colour == PIECE_BLACK) {
+            fullmoves++;
+        }
+        position.colour = (position.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+    addToken(game.result.empty() ? "*" : game.result);
+
+    pgn += line + "\n\n";
+    return pgn;
+}
+
+bool Pgn::read(const std::string& path, int threads, const std::function<bool(GAME&)>& onGame) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "Could not open PGN file: " << path << std::endl;
+        return false;
+    }
+
+    // Only the current block and the unfinished game from the last one are kept in memory
+    std::string buffer;
+    std::vector<char> block(PGN_BLOCK_SIZE);
+    size_t gameNumber = 0;
+    bool done = false;
+    while (!done) {
+        file.read(block.data(), block.size());
+        buffer.append(block.data(), file.gcount());
+        done = (file.gcount() == 0 || !file);
+
+        // Last game might carry on into the next block
+        std::string_view text(buffer);
+        std::vector<size_t> starts = ::findGames(text);
+        if (starts.empty() || starts[0] != 0) {
+            starts.insert(starts.begin(), 0);
+        }
+        size_t complete = (done ? starts.size() : starts.size() - 1);
+
+        std::vector<GAME> games(complete);
+        std::vector<std::string> errors(complete);
+        std::vector<char> valid(complete, false);
+        Threads::parallelFor(complete, threads, [&](size_t index, int) {
+            size_t end = (index + 1 < starts.size() ? starts[index + 1] : text.size());
+            std::string_view gameText = text.substr(starts[index], end - starts[index]);
+            // Files can end in blank lines
+            if (gameText.find_first_not_of(" \t\r\n") == std::string_view::npos) {
+                return;
+            }
+            valid[index] = Pgn::parse(gameText, games[index], errors[index]);
+        });
+
+        for (size_t i = 0; i < complete; i++) {
+            // Blank text between games
+            if (!valid[i] && errors[i].empty()) {
+                continue;
+            }
+            gameNumber++;
+            if (!valid[i]) {
+                std::cout << path << ": game " << gameNumber << ": " << errors[i] << std::endl;
+                continue;
+            }
+            if (!onGame(games[i])) {
+                return true;
+            }
+        }
+
+        buffer.erase(0, (done ? buffer.size() : starts.back()));
+    }
+    return true;
+}
+
+bool Pgn::write(const std::string& path, const std::vector<GAME>& games, bool append) {
+    std::ofstream file(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!file) {
+        std::cout << "Could not open PGN file: " << path << std::endl;
+        return false;
+    }
+    for (const GAME& game : games) {
+        file << Pgn::toPGN(game);
+    }
+    return (bool)file;
+}
@@ -1,72 +1,6 @@
 #include "Piece.h"
 
-#include "BoardManager.h"
-#include "EventManager.h"
-    
-namespace {
-
-    void removePawnFlags(INDEX index, PIECE* grid) {
-        // Removes first move mask
-        Piece::removeFlag(&grid[index], MOVE_PAWN_FIRST_MOVE);
-        // Remove en passent
-        Piece::removeFlag(&grid[index], MOVE_PAWN_MOVE_TWO);
-
-        // Check if pawn has reached the edge of the board
-            // White Pawn                             // Black Pawn
-        if (((index / GRID_SIZE) == GRID_SIZE - 1) || ((index / GRID_SIZE) == 0)) {
-            // Adds promotion event
-            EventManager::eventPromotion(index);
-        }
-    }
-
-    void removeKnightFlags(INDEX index, PIECE* grid){ 
-
-    }
-
-    void removeBishopFlags(INDEX index, PIECE* grid) {
-
-    }
-
-    void removeRookFlags(INDEX index, PIECE* grid) {
-        Piece::removeFlag(&grid[index], MOVE_ROOK_CAN_CASTLE);
-    }
-
-    void removeQueenFlags(INDEX index, PIECE* grid) {
-
-    }
-
-    void removeKingFlags(INDEX index, PIECE* grid) {
-    // Check if king can castle
-    if(!Piece::getFlag(grid[index], MOVE_KING_CASTLING)) {
-        // No castling, return
-        return;
-    }
-
-    // King starts on the right, halfway across the board
-    INDEX kingStartX = GRID_SIZE / 2;
-    int movedSquares = kingStartX - (index % GRID_SIZE);
-    // Detecs if king moved more that 1 square
-    if (abs(movedSquares) > 1) {
-        // Negative (King side rook), king has castling rights on this side
-        if (movedSquares < 0 && Piece::getFlag(grid[index], MOVE_KING_CASTLE_KING)) {
-            INDEX rookIndex = (index + movedSquares) + ((GRID_SIZE - 1) / 2);
-            grid[index - 1] = grid[rookIndex];
-            grid[rookIndex] = 0;
-        }
-        // Positive (Queen side rook), king has castling rights on this side
-        else if (movedSquares > 0 && Piece::getFlag(grid[index], MOVE_KING_CASTLE_QUEEN)) {
-            INDEX rookIndex = (index + movedSquares) - (GRID_SIZE / 2);
-            grid[index + 1] = grid[rookIndex];
-            grid[rookIndex] = 0;
-        }
-    }
-
-    // Finally, remove all castling rights always
-    Piece::removeFlag(&grid[index], MOVE_KING_CASTLE_KING);
-    Piece::removeFlag(&grid[index], MOVE_KING_CASTLE_QUEEN);
-}
-
-}
+#include <iostream>
 
 void Piece::addFlag(PIECE* piece, FLAG flag) {
     *piece |= flag;
@@ -85,31 +19,6 @@ FLAG Piece::getFlag(PIECE piece, FLAG flag) {
     return (piece & flag);
 }
 
-void Piece::removeFlags(INDEX index, PIECE* grid) {
-    // Piece information
-    FLAG type = Piece::getFlag(grid[index], MASK_TYPE);
-    switch (type) {
-    case PIECE_PAWN:
-        ::removePawnFlags(index, grid);
-        break;
-    case PIECE_KNIGHT:
-        ::removeKnightFlags(index, grid);
-        break;
-    case PIECE_BISHOP:
-        ::removeBishopFlags(index, grid);
-        break;
-    case PIECE_ROOK:
-        ::removeRookFlags(index, grid);
-        break;
-    case PIECE_QUEEN:
-        ::removeQueenFlags(index, grid);
-        break;
-    case PIECE_KING:
-        ::removeKingFlags(index, grid);
-        break;
-    }
-}
-
 void Piece::Debug(PIECE piece) {
     // Piece type
     FLAG type = Piece::getFlag(piece, MASK_TYPE);
@@ -20,3 +20,6 @@ FLAG Player::Colour() {
 
 // ----- Update -----
 
+void Player::setType(FLAG type) {
+    this->m_playerData = this->Colour() | type;
+}
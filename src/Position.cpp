@@ -0,0 +1,166 @@
+#include "Position.h"
+
+#include "Piece.h"
+
+void Position::play(Move move, PIECE* grid) {
+    INDEX start = move.Start();
+    INDEX target = move.Target();
+    FLAG kind = move.Kind();
+
+    PIECE piece = grid[start];
+    FLAG colour = Piece::getFlag(piece, MASK_COLOUR);
+    INDEX forward = (colour == PIECE_WHITE ? GRID_SIZE : (-GRID_SIZE));
+
+    // Enemy phantoms only last one move, they sit on the rank behind their pawns
+    INDEX phantomRank = (colour == PIECE_WHITE ? GRID_SIZE - 3 : 2) * GRID_SIZE;
+    for (INDEX i = phantomRank; i < phantomRank + GRID_SIZE; i++) {
+        if (grid[i] == PIECE_PHANTOM) {
+            grid[i] = PIECE_INVALID;
+        }
+    }
+
+    switch (kind) {
+    // Pawn being captured is behind the target square
+    case MOVE_EN_PASSANT:
+        grid[target - forward] = PIECE_INVALID;
+        break;
+    // Rook jumps to the other side of the king
+    case MOVE_CASTLE_KING:
+        grid[start + 1] = grid[start + 3];
+        grid[start + 3] = PIECE_INVALID;
+        Piece::removeFlag(&grid[start + 1], FLAG_ROOK_CAN_CASTLE);
+        break;
+    case MOVE_CASTLE_QUEEN:
+        grid[start - 1] = grid[start - 4];
+        grid[start - 4] = PIECE_INVALID;
+        Piece::removeFlag(&grid[start - 1], FLAG_ROOK_CAN_CASTLE);
+        break;
+    // Leaves a phantom behind for en passant
+    case MOVE_PAWN_MOVE_TWO:
+        grid[start + forward] = PIECE_PHANTOM;
+        break;
+    default:
+        break;
+    }
+
+    // Moving loses first move and castling flags, whichever piece type has them
+    Piece::removeFlag(&piece, FLAG_PAWN_FIRST_MOVE | FLAG_KING_CASTLING | FLAG_ROOK_CAN_CASTLE);
+    if (move.isPromotion()) {
+        piece = move.Promotion() | colour;
+    }
+
+    grid[target] = piece;
+    grid[start] = PIECE_INVALID;
+}
+
+Move Position::createMove(INDEX start, INDEX target, FLAG promotion, const PIECE* grid) {
+    PIECE piece = grid[start];
+    FLAG type = Piece::getFlag(piece, MASK_TYPE);
+    FLAG targetColour = Piece::getFlag(grid[target], MASK_COLOUR);
+    FLAG kind = (targetColour && targetColour != Piece::getFlag(piece, MASK_COLOUR) ? MOVE_CAPTURE : MOVE_QUIET);
+
+    // King moving two squares is castling
+    if (type == PIECE_KING && target - start == 2) {
+        return Move(start, target, MOVE_CASTLE_KING);
+    }
+    if (type == PIECE_KING && start - target == 2) {
+        return Move(start, target, MOVE_CASTLE_QUEEN);
+    }
+    if (type != PIECE_PAWN) {
+        return Move(start, target, kind);
+    }
+
+    if (grid[target] == PIECE_PHANTOM && (target - start) % GRID_SIZE) {
+        return Move(start, target, MOVE_EN_PASSANT);
+    }
+    if (target - start == 2 * GRID_SIZE || start - target == 2 * GRID_SIZE) {
+        return Move(start, target, MOVE_PAWN_MOVE_TWO);
+    }
+    INDEX rank = target / GRID_SIZE;
+    if (rank == 0 || rank == GRID_SIZE - 1) {
+        Move move(start, target, MOVE_PROMOTION | kind);
+        move.setPromotion(promotion == PIECE_INVALID ? PIECE_QUEEN : promotion);
+        return move;
+    }
+    return Move(start, target, kind);
+}
+
+INDEX Position::findKing(FLAG colour, const PIECE* grid) {
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        if (Piece::getFlag(grid[i], MASK_TYPE) == PIECE_KING && Piece::getFlag(grid[i], MASK_COLOUR) == colour) {
+            return i;
+        }
+    }
+    return CODE_INVALID;
+}
+
+INDEX Position::findPhantom(FLAG colour, const PIECE* grid) {
+    // Phantom is on the rank behind the enemy pawn
+    INDEX phantomRank = (colour == PIECE_WHITE ? GRID_SIZE - 3 : 2) * GRID_SIZE;
+    for (INDEX i = phantomRank; i < phantomRank + GRID_SIZE; i++) {
+        if (grid[i] == PIECE_PHANTOM) {
+            return i;
+        }
+    }
+    return CODE_INVALID;
+}
+
+FLAG Position::castlingRights(const PIECE* grid) {
+    FLAG rights = 0;
+    const INDEX kings[2] = { (GRID_SIZE * (GRID_SIZE - 1)) + GRID_SIZE / 2, GRID_SIZE / 2 };
+    const FLAG colours[2] = { PIECE_BLACK, PIECE_WHITE };
+
+    // Black rights come first, same as the BOARD_CASTLING order
+    for (int side = 0; side < 2; side++) {
+        INDEX king = kings[side];
+        FLAG rookFlags = PIECE_ROOK | colours[side] | FLAG_ROOK_CAN_CASTLE;
+        if (Piece::getFlag(grid[king], MASK_TYPE | MASK_COLOUR) != (PIECE_KING | colours[side])) {
+            continue;
+        }
+        if (Piece::hasFlag(grid[king], FLAG_KING_CASTLE_KING) &&
+            Piece::getFlag(grid[king + 3], rookFlags | MASK_TYPE) == rookFlags) {
+            rights |= (1 << (2 * side));
+        }
+        if (Piece::hasFlag(grid[king], FLAG_KING_CASTLE_QUEEN) &&
+            Piece::getFlag(grid[king - 4], rookFlags | MASK_TYPE) == rookFlags) {
+            rights |= (1 << (2 * side + 1));
+        }
+    }
+    return rights;
+}
+
+void Position::setFlags(FLAG rights, PIECE* grid) {
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        FLAG type = Piece::getFlag(grid[i], MASK_TYPE);
+        FLAG colour = Piece::getFlag(grid[i], MASK_COLOUR);
+        INDEX y = i / GRID_SIZE;
+
+        // Pawns on their start rank can still move two
+        if (type == PIECE_PAWN && ((y == 1 && colour == PIECE_WHITE) || (y == GRID_SIZE - 2 && colour == PIECE_BLACK))) {
+            Piece::addFlag(&grid[i], FLAG_PAWN_FIRST_MOVE);
+        }
+    }
+
+    const INDEX kings[2] = { (GRID_SIZE * (GRID_SIZE - 1)) + GRID_SIZE / 2, GRID_SIZE / 2 };
+    const FLAG colours[2] = { PIECE_BLACK, PIECE_WHITE };
+    for (int side = 0; side < 2; side++) {
+        INDEX king = kings[side];
+        if (Piece::getFlag(grid[king], MASK_TYPE | MASK_COLOUR) != (PIECE_KING | colours[side])) {
+            continue;
+        }
+
+        // Both the king and the rook in the corner need the right
+        const FLAG kingFlags[2] = { FLAG_KING_CASTLE_KING, FLAG_KING_CASTLE_QUEEN };
+        const INDEX rooks[2] = { (INDEX)(king + 3), (INDEX)(king - 4) };
+        for (int j = 0; j < 2; j++) {
+            if (!(rights & (1 << (2 * side + j)))) {
+                continue;
+            }
+            if (Piece::getFlag(grid[rooks[j]], MASK_TYPE | MASK_COLOUR) != (PIECE_ROOK | colours[side])) {
+                continue;
+            }
+            Piece::addFlag(&grid[king], kingFlags[j]);
+            Piece::addFlag(&grid[rooks[j]], FLAG_ROOK_CAN_CASTLE);
+        }
+    }
+}
@@ -0,0 +1,224 @@
+#include "PositionIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "Archive.h"
+#include "MoveGen.h"
+#include "Pgn.h"
+#include "San.h"
+#include "Threads.h"
+#include "Zobrist.h"
+
+namespace {
+
+    static_assert(sizeof(POSITION_ENTRY) == 16, "Index entries must be 16 bytes");
+
+    bool entryLess(const POSITION_ENTRY& a, const POSITION_ENTRY& b) {
+        if (a.hash != b.hash) {
+            return a.hash < b.hash;
+        }
+        return (a.game != b.game ? a.game < b.game : a.ply < b.ply);
+    }
+
+    // Adds an entry for each position of the game, up to maxPly
+    void addGame(const GAME& game, unsigned int id, int maxPly, std::vector<POSITION_ENTRY>& entries) {
+        POSITION position;
+        if (!Pgn::startPosition(game, position)) {
+            return;
+        }
+        unsigned char result = (unsigned char)Archive::resultCode(game.result);
+
+        for (size_t ply = 0; ply <= game.moves.size(); ply++) {
+            if (maxPly > 0 && (int)ply > maxPly) {
+                break;
+            }
+
+            POSITION_ENTRY entry = { Zobrist::hash(position.colour, position.grid), id, (unsigned short)ply, result, POSITION_INDEX_NO_MOVE };
+            if (ply < game.moves.size()) {
+                Move move = game.moves[ply];
+                std::vector<Move> moves = MoveGen::generate(position.colour, position.grid, true);
+                for (size_t i = 0; i < moves.size(); i++) {
+                    if (moves[i].Start() == move.Start() && moves[i].Target() == move.Target() && moves[i].Kind() == move.Kind()) {
+                        entry.move = (unsigned char)i;
+                        break;
+                    }
+                }
+                Position::play(move, position.grid);
+                position.colour = (position.colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+            }
+            entries.push_back(entry);
+        }
+    }
+
+}
+
+// ----- Creation -----
+
+PositionIndex::PositionIndex() {
+    this->m_entries = nullptr;
+    this->m_count = 0;
+}
+
+bool PositionIndex::open(const std::string& path) {
+    this->m_entries = nullptr;
+    this->m_count = 0;
+    if (!this->m_file.open(path)) {
+        return false;
+    }
+
+    const char* data = this->m_file.Data();
+    size_t size = this->m_file.Size();
+    unsigned int version = 0;
+    unsigned long long count = 0;
+    if (size >= POSITION_INDEX_HEADER_SIZE) {
+        std::memcpy(&version, data + 4, 4);
+        std::memcpy(&count, data + 8, 8);
+    }
+    if (size < POSITION_INDEX_HEADER_SIZE || std::memcmp(data, POSITION_INDEX_MAGIC, 4) != 0 || version != POSITION_INDEX_VERSION ||
+        (size - POSITION_INDEX_HEADER_SIZE) / sizeof(POSITION_ENTRY) != count) {
+        std::cout << "Not a position index: " << path << std::endl;
+        this->m_file.close();
+        return false;
+    }
+
+    this->m_entries = (const POSITION_ENTRY*)(data + POSITION_INDEX_HEADER_SIZE);
+    this->m_count = count;
+    return true;
+}
+
+bool PositionIndex::build(const std::string& input, const std::string& output, int threads, int maxPly) {
+    threads = std::max(threads, 1);
+
+    // Each thread fills its own list, so nothing is shared while games are read
+    std::vector<std::vector<POSITION_ENTRY>> lists(threads);
+
+    // Move after the last indexed ply is still needed
+    bool read = Archive::forEachGame(input, threads, (maxPly > 0 ? maxPly + 1 : 0), [&](const GAME& game, size_t index, int thread) {
+        ::addGame(game, (unsigned int)index, maxPly, lists[thread]);
+    });
+    if (!read) {
+        return false;
+    }
+
+    // Lists are sorted on their own threads, then merged in pairs until one is left
+    Threads::parallelFor(lists.size(), threads, [&](size_t index, int) {
+        std::sort(lists[index].begin(), lists[index].end(), ::entryLess);
+    });
+    while (lists.size() > 1) {
+        std::vector<std::vector<POSITION_ENTRY>> merged((lists.size() + 1) / 2);
+        Threads::parallelFor(merged.size(), threads, [&](size_t index, int) {
+            if (2 * index + 1 == lists.size()) {
+                merged[index] = std::move(lists[2 * index]);
+                return;
+            }
+            std::vector<POSITION_ENTRY>& a = lists[2 * index];
+            std::vector<POSITION_ENTRY>& b = lists[2 * index + 1];
+            merged[index].resize(a.size() + b.size());
+            std::merge(a.begin(), a.end(), b.begin(), b.end(), merged[index].begin(), ::entryLess);
+            std::vector<POSITION_ENTRY>().swap(a);
+            std::vector<POSITION_ENTRY>().swap(b);
+        });
+        lists = std::move(merged);
+    }
+
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Could not open file: " << output << std::endl;
+        return false;
+    }
+    unsigned int version = POSITION_INDEX_VERSION;
+    unsigned long long count = lists[0].size();
+    file.write(POSITION_INDEX_MAGIC, 4);
+    file.write((const char*)&version, 4);
+    file.write((const char*)&count, 8);
+    file.write((const char*)lists[0].data(), count * sizeof(POSITION_ENTRY));
+    return (bool)file;
+}
+
+// ----- Read -----
+
+bool PositionIndex::isOpen() const {
+    return (this->m_entries != nullptr);
+}
+
+size_t PositionIndex::Count() const {
+    return this->m_count;
+}
+
+const POSITION_ENTRY* PositionIndex::find(HASH hash, size_t& count) const {
+    count = 0;
+    if (!this->m_entries) {
+        return nullptr;
+    }
+
+    // Binary search straight over the mapped entries
+    const POSITION_ENTRY* end = this->m_entries + this->m_count;
+    const POSITION_ENTRY* first = std::lower_bound(this->m_entries, end, hash, [](const POSITION_ENTRY& entry, HASH value) {
+        return entry.hash < value;
+    });
+    const POSITION_ENTRY* last = first;
+    while (last != end && last->hash == hash) {
+        last++;
+    }
+    count = last - first;
+    return first;
+}
+
+std::vector<MOVE_STATS> PositionIndex::getStats(FLAG colour, const PIECE* grid) const {
+    std::vector<MOVE_STATS> stats;
+    size_t count = 0;
+    const POSITION_ENTRY* entries = this->find(Zobrist::hash(colour, grid), count);
+    if (!count) {
+        return stats;
+    }
+
+    // Entries store the legal move index, so the moves are needed to turn them back into moves
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+    std::vector<MOVE_STATS> byIndex(moves.size());
+    for (size_t i = 0; i < moves.size(); i++) {
+        byIndex[i] = { moves[i], 0, 0, 0, 0 };
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].move >= moves.size()) {
+            continue;
+        }
+        MOVE_STATS& move = byIndex[entries[i].move];
+        move.games++;
+        move.white += (entries[i].result == ARCHIVE_RESULT_WHITE);
+        move.draws += (entries[i].result == ARCHIVE_RESULT_DRAW);
+        move.black += (entries[i].result == ARCHIVE_RESULT_BLACK);
+    }
+
+    for (MOVE_STATS& move : byIndex) {
+        if (move.games) {
+            stats.push_back(move);
+        }
+    }
+    std::stable_sort(stats.begin(), stats.end(), [](const MOVE_STATS& a, const MOVE_STATS& b) {
+        return a.games > b.games;
+    });
+    return stats;
+}
+
+void PositionIndex::showStats(FLAG colour, const PIECE* grid) const {
+    size_t count = 0;
+    const POSITION_ENTRY* entries = this->find(Zobrist::hash(colour, grid), count);
+    std::cout << "Reached " << count << " times" << std::endl;
+
+    // Only the first few games are listed
+    for (size_t i = 0; i < count && i < 10; i++) {
+        std::cout << "Game " << entries[i].game << ", ply " << entries[i].ply << ", " << Archive::resultString(entries[i].result) << std::endl;
+    }
+    if (count > 10) {
+        std::cout << "..." << std::endl;
+    }
+
+    // Scores are from white's point of view
+    for (MOVE_STATS& stats : this->getStats(colour, grid)) {
+        std::cout << San::toSAN(stats.move, colour, grid) << ": " << stats.games << " games, +" << stats.white << " =" << stats.draws << " -" << stats.black << std::endl;
+    }
+    std::cout << std::endl;
+}
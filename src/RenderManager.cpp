@@ -1,5 +1,8 @@
 #include "RenderManager.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "BindManager.h"
 #include "WindowManager.h"
 #include "BoardManager.h"
@@ -170,6 +173,71 @@ void RenderManager::rect(COLOUR& colour, int x, int y, int width, int height) {
     BindManager::UnbindAll();
 }
 
+void RenderManager::arrow(COLOUR& colour, int x1, int y1, int x2, int y2, int width) {
+    // Return if the renderer was not properly made
+    if (!this->m_created) {
+        std::cout << "Cannot render arrow: renderer not properly initialized..." << std::endl;
+        return;
+    }
+
+    // Direction and side of the arrow in pixel-space, so it keeps its shape in any window
+    GLfloat dx = (GLfloat)(x2 - x1);
+    GLfloat dy = (GLfloat)(y2 - y1);
+    GLfloat length = std::sqrt(dx * dx + dy * dy);
+    if (length == 0) {
+        return;
+    }
+    dx /= length;
+    dy /= length;
+    GLfloat head = std::min((GLfloat)(2 * width), length);
+    GLfloat shaft = width / 2.f;
+    GLfloat side = width * 1.5f;
+
+    // Shaft ends where the head starts
+    GLfloat bx = x2 - dx * head;
+    GLfloat by = y2 - dy * head;
+    GLfloat points[][2] = {
+        { x1 - dy * shaft, y1 + dx * shaft },
+        { x1 + dy * shaft, y1 - dx * shaft },
+        { bx - dy * shaft, by + dx * shaft },
+        { bx + dy * shaft, by - dx * shaft },
+        { bx - dy * side,  by + dx * side },
+        { bx + dy * side,  by - dx * side },
+        { (GLfloat)x2,     (GLfloat)y2 }
+    };
+
+    // Calculating where the points are in vector-space instead of pixel-space
+    POINT winSize = WindowManager::winSize();
+    GLfloat vertices[7 * 5];
+    for (int i = 0; i < 7; i++) {
+        vertices[i * 5] = Library::map(points[i][0], 0, winSize.x, -1, 1);
+        vertices[i * 5 + 1] = Library::map(points[i][1], 0, winSize.y, -1, 1);
+        vertices[i * 5 + 2] = colour.r;
+        vertices[i * 5 + 3] = colour.g;
+        vertices[i * 5 + 4] = colour.b;
+    }
+
+    GLuint indices[] = {0, 1, 2, 1, 2, 3, 4, 5, 6};
+
+    // Binding
+    BindManager::BindVAO(this->m_vao);
+    BindManager::BindVBO(this->m_vbo, vertices, sizeof(vertices));
+    BindManager::BindEBO(this->m_ebo, indices, sizeof(indices));
+
+    // Editing
+    BindManager::LinkAttrib(0, 2, GL_FLOAT, 5 * sizeof(GLfloat), (void*)0);
+    BindManager::LinkAttrib(1, 3, GL_FLOAT, 5 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
+
+    // Unbind
+    BindManager::UnbindAll();
+
+    // Rendering
+    BindManager::Activate(this->m_shaderColID);
+    BindManager::BindVAO(this->m_vao);
+    glDrawElements(GL_TRIANGLES, 9, GL_UNSIGNED_INT, 0);
+    BindManager::UnbindAll();
+}
+
 void RenderManager::render(PIECE piece, int x, int y) {
     // Check to not try to render phantom pieces
     if (piece == PIECE_PHANTOM) {
@@ -0,0 +1,242 @@
+#include "San.h"
+
+#include "Attacks.h"
+#include "MoveGen.h"
+#include "Piece.h"
+#include "Position.h"
+
+namespace {
+
+    const char pieceChars[] = " PNBRQK";
+
+    FLAG pieceType(char c) {
+        switch (c) {
+        case 'N':
+            return PIECE_KNIGHT;
+        case 'B':
+            return PIECE_BISHOP;
+        case 'R':
+            return PIECE_ROOK;
+        case 'Q':
+            return PIECE_QUEEN;
+        case 'K':
+            return PIECE_KING;
+        default:
+            return PIECE_INVALID;
+        }
+    }
+
+    // Returns the pieces of the type and colour that can legally move to target
+    // Pawns are only found when they capture onto target
+    BITBOARD findStarts(INDEX target, FLAG type, FLAG colour, FLAG promotion, const PIECE* grid) {
+        BITBOARD attackers = Attacks::attackersTo(target, colour, grid);
+        BITBOARD starts = BITBOARD_EMPTY;
+        while (attackers) {
+            INDEX start = Attacks::popLowest(attackers);
+            if (Piece::getFlag(grid[start], MASK_TYPE) != type) {
+                continue;
+            }
+            Move move = Position::createMove(start, target, promotion, grid);
+            if (MoveGen::isLegal(move, colour, grid)) {
+                starts |= BITBOARD_INDEX(start);
+            }
+        }
+        return starts;
+    }
+
+}
+
+std::string San::toSAN(Move move, FLAG colour, const PIECE* grid) {
+    INDEX start = move.Start();
+    INDEX target = move.Target();
+    FLAG type = Piece::getFlag(grid[start], MASK_TYPE);
+    std::string san;
+
+    if (move.Kind() == MOVE_CASTLE_KING) {
+        san = "O-O";
+    }
+    else if (move.Kind() == MOVE_CASTLE_QUEEN) {
+        san = "O-O-O";
+    }
+    else {
+        if (type == PIECE_PAWN) {
+            // Pawn captures start with the file they came from
+            if (move.isCapture()) {
+                san += (char)('a' + start % GRID_SIZE);
+            }
+        }
+        else {
+            san += ::pieceChars[type];
+
+            // Other pieces of the same type that could also reach the target
+            BITBOARD others = ::findStarts(target, type, colour, PIECE_INVALID, grid) & ~BITBOARD_INDEX(start);
+            if (others) {
+                bool sameFile = false, sameRank = false;
+                while (others) {
+                    INDEX other = Attacks::popLowest(others);
+                    sameFile |= (other % GRID_SIZE == start % GRID_SIZE);
+                    sameRank |= (other / GRID_SIZE == start / GRID_SIZE);
+                }
+                // File is used first, rank if the file is shared, both if both are
+                if (!sameFile || sameRank) {
+                    san += (char)('a' + start % GRID_SIZE);
+                }
+                if (sameFile) {
+                    san += (char)('1' + start / GRID_SIZE);
+                }
+            }
+        }
+
+        if (move.isCapture()) {
+            san += 'x';
+        }
+        san += (char)('a' + target % GRID_SIZE);
+        san += (char)('1' + target / GRID_SIZE);
+
+        if (move.isPromotion()) {
+            san += '=';
+            san += ::pieceChars[move.Promotion()];
+        }
+    }
+
+    // Check and mate come from the position after the move
+    PIECE editGrid[GRID_SIZE * GRID_SIZE];
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        editGrid[i] = grid[i];
+    }
+    Position::play(move, editGrid);
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    if (MoveGen::inCheck(enemy, editGrid)) {
+        san += (MoveGen::hasLegalMove(enemy, editGrid) ? '+' : '#');
+    }
+    return san;
+}
+
+Move San::fromSAN(std::string_view san, FLAG colour, const PIECE* grid) {
+    // Annotations and check marks are not needed to find the move
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+        san.remove_suffix(1);
+    }
+
+    INDEX king = Position::findKing(colour, grid);
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        if (king == CODE_INVALID) {
+            return Move();
+        }
+        // Castling is only legal if the generator would make it
+        Move castle(king, king + (san.size() == 3 ? 2 : -2), (san.size() == 3 ? MOVE_CASTLE_KING : MOVE_CASTLE_QUEEN));
+        for (Move& move : MoveGen::generate(colour, grid, true)) {
+            if (move.Start() == castle.Start() && move.Target() == castle.Target() && move.Kind() == castle.Kind()) {
+                return move;
+            }
+        }
+        return Move();
+    }
+
+    // Promotion piece is at the end
+    FLAG promotion = PIECE_INVALID;
+    size_t equals = san.find('=');
+    if (equals != std::string_view::npos) {
+        if (equals + 2 != san.size()) {
+            return Move();
+        }
+        promotion = ::pieceType(san[equals + 1]);
+        if (promotion == PIECE_INVALID || promotion == PIECE_KING) {
+            return Move();
+        }
+        san = san.substr(0, equals);
+    }
+    else if (san.size() > 2 && ::pieceType(san.back()) != PIECE_INVALID && san.back() != 'K' && 'a' <= san[0] && san[0] <= 'h') {
+        // Some files leave out the equals sign
+        promotion = ::pieceType(san.back());
+        san.remove_suffix(1);
+    }
+
+    // Target square is always the last two characters
+    if (san.size() < 2) {
+        return Move();
+    }
+    char file = san[san.size() - 2], rank = san[san.size() - 1];
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') {
+        return Move();
+    }
+    INDEX target = (rank - '1') * GRID_SIZE + (file - 'a');
+    san.remove_suffix(2);
+
+    FLAG type = PIECE_PAWN;
+    if (!san.empty() && ::pieceType(san[0]) != PIECE_INVALID) {
+        type = ::pieceType(san[0]);
+        san.remove_prefix(1);
+    }
+    bool capture = (!san.empty() && san.back() == 'x');
+    if (capture) {
+        san.remove_suffix(1);
+    }
+
+    // Whatever is left narrows down the start square
+    int fromFile = -1, fromRank = -1;
+    for (char c : san) {
+        if ('a' <= c && c <= 'h') {
+            fromFile = c - 'a';
+        }
+        else if ('1' <= c && c <= '8') {
+            fromRank = c - '1';
+        }
+        else {
+            return Move();
+        }
+    }
+
+    // Cannot land on its own piece
+    if (Piece::getFlag(grid[target], MASK_COLOUR) == colour) {
+        return Move();
+    }
+    INDEX targetRank = target / GRID_SIZE;
+    bool lastRank = (targetRank == 0 || targetRank == GRID_SIZE - 1);
+    if (type == PIECE_PAWN && lastRank == (promotion == PIECE_INVALID)) {
+        return Move();
+    }
+    if (type != PIECE_PAWN && promotion != PIECE_INVALID) {
+        return Move();
+    }
+
+    BITBOARD starts = BITBOARD_EMPTY;
+    if (type == PIECE_PAWN && !capture) {
+        // Pushes come from one or two squares behind the target
+        INDEX back = (colour == PIECE_WHITE ? -GRID_SIZE : GRID_SIZE);
+        INDEX start = target + back;
+        if (grid[target] || start < 0 || start >= GRID_SIZE * GRID_SIZE) {
+            return Move();
+        }
+        PIECE pawn = PIECE_PAWN | colour;
+        INDEX twoBack = start + back;
+        if (!grid[start] && 0 <= twoBack && twoBack < GRID_SIZE * GRID_SIZE &&
+            Piece::getFlag(grid[twoBack], MASK_TYPE | MASK_COLOUR | FLAG_PAWN_FIRST_MOVE) == (pawn | FLAG_PAWN_FIRST_MOVE)) {
+            start = twoBack;
+        }
+        if (Piece::getFlag(grid[start], MASK_TYPE | MASK_COLOUR) == pawn && MoveGen::isLegal(Position::createMove(start, target, promotion, grid), colour, grid)) {
+            starts = BITBOARD_INDEX(start);
+        }
+    }
+    else {
+        // Pawns can only capture onto enemy pieces or en passant
+        if (type == PIECE_PAWN && !Piece::getFlag(grid[target], MASK_COLOUR) && grid[target] != PIECE_PHANTOM) {
+            return Move();
+        }
+        starts = ::findStarts(target, type, colour, promotion, grid);
+    }
+
+    BITBOARD matches = BITBOARD_EMPTY;
+    while (starts) {
+        INDEX start = Attacks::popLowest(starts);
+        if ((fromFile < 0 || start % GRID_SIZE == fromFile) && (fromRank < 0 || start / GRID_SIZE == fromRank)) {
+            matches |= BITBOARD_INDEX(start);
+        }
+    }
+
+    // Exactly one piece must match
+    if (!matches || (matches & (matches - 1))) {
+        return Move();
+    }
+    return Position::createMove(Attacks::popLowest(matches), target, promotion, grid);
+}
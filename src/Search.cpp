@@ -0,0 +1,516 @@
+#include "Search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "Evaluation.h"
+#include "MoveGen.h"
+#include "Piece.h"
+#include "Zobrist.h"
+
+struct searchEntryHolder {
+    HASH key = 0;
+    Move move;
+    short score = 0;
+    signed char depth = 0;
+    unsigned char bound = SEARCH_BOUND_EXACT;
+};
+
+namespace {
+
+    // Values used to order captures and prune them in quiescence, a phantom is the pawn taken en passant
+    constexpr int orderValues[8] = { 0, 100, 320, 330, 500, 900, 2000, 100 };
+
+    // Order scores above every history score
+    constexpr int hashScore = 1 << 30;
+    constexpr int captureScore = 1 << 24;
+    constexpr int killerScore = 1 << 23;
+    constexpr int historyMax = 1 << 20;
+
+    bool sameMove(Move first, Move second) {
+        return (first.Start() == second.Start() && first.Target() == second.Target() && first.Kind() == second.Kind());
+    }
+
+    FLAG enemyOf(FLAG colour) {
+        return (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    }
+
+    // Mates are stored as plies from the entry's position instead of from the root
+    int toTable(int score, int ply) {
+        if (score >= SEARCH_MATE_BOUND) {
+            return score + ply;
+        }
+        if (score <= -SEARCH_MATE_BOUND) {
+            return score - ply;
+        }
+        return score;
+    }
+
+    int fromTable(int score, int ply) {
+        if (score >= SEARCH_MATE_BOUND) {
+            return score - ply;
+        }
+        if (score <= -SEARCH_MATE_BOUND) {
+            return score + ply;
+        }
+        return score;
+    }
+
+    // Null moves are unsafe with only pawns left, where zugzwang is common
+    bool hasPieces(FLAG colour, const PIECE* grid) {
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            FLAG type = Piece::getFlag(grid[i], MASK_TYPE);
+            if (Piece::getFlag(grid[i], MASK_COLOUR) == colour && PIECE_KNIGHT <= type && type <= PIECE_QUEEN) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
+
+// ----- Creation -----
+
+Search::Search(int hashMegabytes, const Nnue* network) {
+    size_t entries = 1;
+    while (entries * 2 * sizeof(searchEntryHolder) <= ((size_t)std::max(hashMegabytes, 1) << 20)) {
+        entries *= 2;
+    }
+    this->m_table.resize(entries);
+    this->m_network = (network && network->isLoaded() ? network : nullptr);
+    if (this->m_network) {
+        this->m_accumulators.resize(SEARCH_MAX_PLY + 1);
+    }
+    this->m_nodes = 0;
+    this->m_nodeLimit = 0;
+    this->m_timed = false;
+    this->m_stopped = false;
+    this->m_stop = nullptr;
+    this->clear();
+}
+
+// ----- Read -----
+
+long long Search::Nodes() const {
+    return this->m_nodes;
+}
+
+const SEARCH_PARAMETERS& Search::Parameters() const {
+    return this->m_parameters;
+}
+
+const std::vector<SEARCH_PARAMETER>& Search::Tunable() {
+    static const std::vector<SEARCH_PARAMETER> parameters = {
+        { "nullDepth", &SEARCH_PARAMETERS::nullDepth, 1, 8, 1.0 },
+        { "nullReduction", &SEARCH_PARAMETERS::nullReduction, 1, 5, 1.0 },
+        { "lmrDepth", &SEARCH_PARAMETERS::lmrDepth, 1, 8, 1.0 },
+        { "lmrMoves", &SEARCH_PARAMETERS::lmrMoves, 1, 16, 1.0 },
+        { "lmrReduction", &SEARCH_PARAMETERS::lmrReduction, 1, 4, 1.0 },
+        { "futilityMargin", &SEARCH_PARAMETERS::futilityMargin, 0, 600, 20.0 },
+        { "deltaMargin", &SEARCH_PARAMETERS::deltaMargin, 0, 800, 25.0 },
+    };
+    return parameters;
+}
+
+bool Search::setParameter(SEARCH_PARAMETERS& parameters, const std::string& name, int value) {
+    for (const SEARCH_PARAMETER& parameter : Search::Tunable()) {
+        if (name == parameter.name) {
+            parameters.*parameter.value = std::clamp(value, parameter.min, parameter.max);
+            return true;
+        }
+    }
+    return false;
+}
+
+int Search::evaluate(FLAG colour, const PIECE* grid, int ply) const {
+    int score = (this->m_network ? this->m_network->evaluate(this->m_accumulators[ply], colour) : Evaluation::evaluate(colour, grid));
+    return std::clamp(score, -SEARCH_MATE_BOUND + 1, SEARCH_MATE_BOUND - 1);
+}
+
+bool Search::isRepetition(HASH hash, int halfmoves) const {
+    // Same side to move every second ply
+    int size = (int)this->m_path.size();
+    for (int i = 2; i <= halfmoves && i <= size; i += 2) {
+        if (this->m_path[size - i] == hash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Search::principalVariation(const POSITION& position, Move first, std::vector<Move>& line) const {
+    PIECE grid[GRID_SIZE * GRID_SIZE];
+    std::memcpy(grid, position.grid, sizeof(grid));
+    FLAG colour = position.colour;
+    std::vector<HASH> seen;
+    line.assign(1, first);
+    Position::play(first, grid);
+    colour = ::enemyOf(colour);
+
+    while ((int)line.size() < SEARCH_MAX_DEPTH) {
+        HASH hash = Zobrist::hash(colour, grid);
+        if (std::find(seen.begin(), seen.end(), hash) != seen.end()) {
+            return;
+        }
+        seen.push_back(hash);
+        searchEntryHolder entry = this->m_table[hash & (this->m_table.size() - 1)];
+        if (entry.key != hash || !entry.move.isMove()) {
+            return;
+        }
+        std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+        auto found = std::find_if(moves.begin(), moves.end(), [&](Move move) { return ::sameMove(move, entry.move); });
+        if (found == moves.end()) {
+            return;
+        }
+        line.push_back(*found);
+        Position::play(*found, grid);
+        colour = ::enemyOf(colour);
+    }
+}
+
+void Search::order(std::vector<Move>& moves, const PIECE* grid, FLAG colour, Move hashMove, int ply) const {
+    int side = (colour == PIECE_WHITE ? 0 : 1);
+    std::vector<int> scores(moves.size());
+    for (size_t i = 0; i < moves.size(); i++) {
+        Move move = moves[i];
+        if (hashMove.isMove() && ::sameMove(move, hashMove)) {
+            scores[i] = hashScore;
+        }
+        else if (move.isCapture() || move.isPromotion()) {
+            FLAG victim = Piece::getFlag(grid[move.Target()], MASK_TYPE);
+            FLAG attacker = Piece::getFlag(grid[move.Start()], MASK_TYPE);
+            scores[i] = captureScore + orderValues[victim] * 16 - attacker + (move.isPromotion() ? orderValues[move.Promotion()] * 16 : 0);
+        }
+        else if (::sameMove(move, this->m_killers[ply][0])) {
+            scores[i] = killerScore;
+        }
+        else if (::sameMove(move, this->m_killers[ply][1])) {
+            scores[i] = killerScore - 1;
+        }
+        else {
+            scores[i] = this->m_history[side][move.Start()][move.Target()];
+        }
+    }
+
+    std::vector<size_t> indices(moves.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::stable_sort(indices.begin(), indices.end(), [&](size_t a, size_t b) { return scores[a] > scores[b]; });
+    std::vector<Move> sorted;
+    sorted.reserve(moves.size());
+    for (size_t index : indices) {
+        sorted.push_back(moves[index]);
+    }
+    moves.swap(sorted);
+}
+
+// ----- Update -----
+
+void Search::countNode() {
+    this->m_nodes++;
+    if (this->m_nodeLimit && this->m_nodes >= this->m_nodeLimit) {
+        this->m_stopped = true;
+    }
+    if (this->m_timed && this->m_nodes % SEARCH_TIME_NODES == 0 && std::chrono::steady_clock::now() >= this->m_deadline) {
+        this->m_stopped = true;
+    }
+    if (this->m_stop && this->m_stop->load(std::memory_order_relaxed)) {
+        this->m_stopped = true;
+    }
+}
+
+void Search::start(const POSITION& position, const std::vector<HASH>& history) {
+    this->m_nodes = 0;
+    this->m_stopped = false;
+    this->m_rootMove = Move();
+    this->m_path = history;
+    if (this->m_network) {
+        this->m_network->refresh(position.grid, this->m_accumulators[0]);
+    }
+}
+
+void Search::play(Move move, const PIECE* grid, PIECE* next, int ply) {
+    if (this->m_network) {
+        this->m_network->update(move, grid, this->m_accumulators[ply], this->m_accumulators[ply + 1]);
+    }
+    std::memcpy(next, grid, sizeof(PIECE) * GRID_SIZE * GRID_SIZE);
+    Position::play(move, next);
+}
+
+int Search::negamax(FLAG colour, const PIECE* grid, int halfmoves, int depth, int ply, int alpha, int beta, bool nullMove) {
+    HASH hash = Zobrist::hash(colour, grid);
+    if (ply > 0 && (halfmoves >= 100 || this->isRepetition(hash, halfmoves))) {
+        return 0;
+    }
+    if (ply >= SEARCH_MAX_PLY - 1) {
+        return this->evaluate(colour, grid, ply);
+    }
+
+    // Checks are searched a ply deeper so quiescence never starts in check
+    bool check = MoveGen::inCheck(colour, grid);
+    if (check) {
+        depth++;
+    }
+    if (depth <= 0) {
+        return this->quiescence(colour, grid, ply, alpha, beta);
+    }
+    this->countNode();
+    if (this->m_stopped) {
+        return 0;
+    }
+
+    searchEntryHolder& entry = this->m_table[hash & (this->m_table.size() - 1)];
+    Move hashMove;
+    if (entry.key == hash) {
+        hashMove = entry.move;
+        int score = ::fromTable(entry.score, ply);
+        if (ply > 0 && entry.depth >= depth && (entry.bound == SEARCH_BOUND_EXACT ||
+            (entry.bound == SEARCH_BOUND_LOWER && score >= beta) || (entry.bound == SEARCH_BOUND_UPPER && score <= alpha))) {
+            return score;
+        }
+    }
+
+    bool pv = (beta - alpha > 1);
+    int staticEval = (check ? -SEARCH_INFINITE : this->evaluate(colour, grid, ply));
+    FLAG enemy = ::enemyOf(colour);
+
+    // Passing the move still failing high means a real move almost certainly does too
+    const SEARCH_PARAMETERS& parameters = this->m_parameters;
+    if (!pv && !check && !nullMove && depth >= parameters.nullDepth && staticEval >= beta && ::hasPieces(colour, grid)) {
+        PIECE next[GRID_SIZE * GRID_SIZE];
+        std::memcpy(next, grid, sizeof(next));
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            if (next[i] == PIECE_PHANTOM) {
+                next[i] = PIECE_INVALID;
+            }
+        }
+        if (this->m_network) {
+            this->m_accumulators[ply + 1] = this->m_accumulators[ply];
+        }
+        this->m_path.push_back(hash);
+        int score = -this->negamax(enemy, next, halfmoves + 1, depth - 1 - parameters.nullReduction, ply + 1, -beta, -beta + 1, true);
+        this->m_path.pop_back();
+        if (this->m_stopped) {
+            return 0;
+        }
+        if (score >= beta) {
+            return (score >= SEARCH_MATE_BOUND ? beta : score);
+        }
+    }
+
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+    if (moves.empty()) {
+        return (check ? -SEARCH_MATE + ply : 0);
+    }
+    this->order(moves, grid, colour, hashMove, ply);
+
+    int side = (colour == PIECE_WHITE ? 0 : 1);
+    int best = -SEARCH_INFINITE;
+    Move bestMove;
+    FLAG bound = SEARCH_BOUND_UPPER;
+    int searched = 0;
+    this->m_path.push_back(hash);
+    for (Move move : moves) {
+        if (ply == 0 && std::any_of(this->m_excluded.begin(), this->m_excluded.end(), [&](Move excluded) { return ::sameMove(move, excluded); })) {
+            continue;
+        }
+        bool quiet = (!move.isCapture() && !move.isPromotion());
+        if (quiet && !pv && !check && depth == 1 && searched > 0 && staticEval + parameters.futilityMargin <= alpha) {
+            continue;
+        }
+
+        PIECE next[GRID_SIZE * GRID_SIZE];
+        bool pawnMove = (Piece::getFlag(grid[move.Start()], MASK_TYPE) == PIECE_PAWN);
+        int nextHalfmoves = (pawnMove || move.isCapture() ? 0 : halfmoves + 1);
+        this->play(move, grid, next, ply);
+
+        // First move gets the full window, the rest are searched to prove they are no better
+        int score;
+        if (searched == 0) {
+            score = -this->negamax(enemy, next, nextHalfmoves, depth - 1, ply + 1, -beta, -alpha, false);
+        }
+        else {
+            int reduction = (quiet && !check && depth >= parameters.lmrDepth && searched >= parameters.lmrMoves ? parameters.lmrReduction : 0);
+            reduction = std::min(reduction, depth - 1);
+            score = -this->negamax(enemy, next, nextHalfmoves, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, false);
+            if (score > alpha && (reduction || score < beta)) {
+                score = -this->negamax(enemy, next, nextHalfmoves, depth - 1, ply + 1, -beta, -alpha, false);
+            }
+        }
+        searched++;
+        if (this->m_stopped) {
+            this->m_path.pop_back();
+            return 0;
+        }
+
+        if (score > best) {
+            best = score;
+            bestMove = move;
+            if (ply == 0) {
+                this->m_rootMove = move;
+            }
+        }
+        if (score > alpha) {
+            alpha = score;
+            bound = SEARCH_BOUND_EXACT;
+        }
+        if (alpha >= beta) {
+            bound = SEARCH_BOUND_LOWER;
+            if (quiet) {
+                if (!::sameMove(move, this->m_killers[ply][0])) {
+                    this->m_killers[ply][1] = this->m_killers[ply][0];
+                    this->m_killers[ply][0] = move;
+                }
+                int& history = this->m_history[side][move.Start()][move.Target()];
+                history += depth * depth;
+                if (history > historyMax) {
+                    for (auto& starts : this->m_history) {
+                        for (auto& targets : starts) {
+                            for (int& value : targets) {
+                                value /= 2;
+                            }
+                        }
+                    }
+                }
+            }
+            break;
+        }
+    }
+    this->m_path.pop_back();
+
+    // Root searched without some of its moves keeps the entry of the full search, so the best line is still ordered first
+    if (ply > 0 || this->m_excluded.empty()) {
+        entry.key = hash;
+        entry.move = bestMove;
+        entry.score = (short)::toTable(best, ply);
+        entry.depth = (signed char)depth;
+        entry.bound = (unsigned char)bound;
+    }
+    return best;
+}
+
+int Search::quiescence(FLAG colour, const PIECE* grid, int ply, int alpha, int beta) {
+    this->countNode();
+    if (this->m_stopped) {
+        return 0;
+    }
+
+    // Side to move can stand on the evaluation instead of capturing
+    int standPat = this->evaluate(colour, grid, ply);
+    if (ply >= SEARCH_MAX_PLY - 1 || standPat >= beta) {
+        return standPat;
+    }
+    alpha = std::max(alpha, standPat);
+
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+    moves.erase(std::remove_if(moves.begin(), moves.end(), [](Move move) { return !move.isCapture() && !move.isPromotion(); }), moves.end());
+    this->order(moves, grid, colour, Move(), ply);
+
+    FLAG enemy = ::enemyOf(colour);
+    for (Move move : moves) {
+        FLAG victim = Piece::getFlag(grid[move.Target()], MASK_TYPE);
+        if (!move.isPromotion() && standPat + orderValues[victim] + this->m_parameters.deltaMargin <= alpha) {
+            continue;
+        }
+
+        PIECE next[GRID_SIZE * GRID_SIZE];
+        this->play(move, grid, next, ply);
+        int score = -this->quiescence(enemy, next, ply + 1, -beta, -alpha);
+        if (this->m_stopped) {
+            return 0;
+        }
+        if (score >= beta) {
+            return score;
+        }
+        alpha = std::max(alpha, score);
+    }
+    return alpha;
+}
+
+SEARCH_RESULT Search::search(const POSITION& position, const std::vector<HASH>& history, const SEARCH_LIMITS& limits) {
+    SEARCH_RESULT result = { Move(), 0, 0, 0 };
+    this->m_nodeLimit = limits.nodes;
+    this->m_timed = (limits.milliseconds > 0);
+    this->m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.milliseconds);
+    this->m_stop = nullptr;
+    this->start(position, history);
+
+    std::vector<Move> moves = MoveGen::generate(position.colour, position.grid, true);
+    if (moves.empty()) {
+        result.score = (MoveGen::inCheck(position.colour, position.grid) ? -SEARCH_MATE : 0);
+        return result;
+    }
+
+    // Iterations stopped part way through are thrown away
+    int maxDepth = (limits.depth > 0 ? std::min(limits.depth, SEARCH_MAX_DEPTH) : SEARCH_MAX_DEPTH);
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int score = this->negamax(position.colour, position.grid, position.halfmoves, depth, 0, -SEARCH_INFINITE, SEARCH_INFINITE, false);
+        if (this->m_stopped) {
+            break;
+        }
+        result.move = this->m_rootMove;
+        result.score = score;
+        result.depth = depth;
+
+        // Nothing deeper can find a faster mate
+        if (std::abs(score) >= SEARCH_MATE_BOUND && SEARCH_MATE - std::abs(score) <= depth) {
+            break;
+        }
+    }
+
+    // Stopped before the first iteration finished
+    if (!result.move.isMove()) {
+        result.move = (this->m_rootMove.isMove() ? this->m_rootMove : moves[0]);
+    }
+    result.nodes = this->m_nodes;
+    return result;
+}
+
+void Search::analyse(const POSITION& position, const std::vector<HASH>& history, int lines, const std::atomic<bool>& stop, const SEARCH_REPORT& report) {
+    this->m_nodeLimit = 0;
+    this->m_timed = false;
+    this->m_stop = &stop;
+    this->start(position, history);
+    std::vector<Move> moves = MoveGen::generate(position.colour, position.grid, true);
+    lines = std::min(lines, (int)moves.size());
+
+    for (int depth = 1; depth <= SEARCH_MAX_DEPTH && lines > 0; depth++) {
+        std::vector<SEARCH_LINE> found;
+        for (int i = 0; i < lines; i++) {
+            this->m_rootMove = Move();
+            int score = this->negamax(position.colour, position.grid, position.halfmoves, depth, 0, -SEARCH_INFINITE, SEARCH_INFINITE, false);
+            if (this->m_stopped || !this->m_rootMove.isMove()) {
+                break;
+            }
+            SEARCH_LINE line;
+            line.score = score;
+            this->principalVariation(position, this->m_rootMove, line.moves);
+            found.push_back(line);
+            this->m_excluded.push_back(this->m_rootMove);
+        }
+        this->m_excluded.clear();
+        if (this->m_stopped) {
+            break;
+        }
+        std::stable_sort(found.begin(), found.end(), [](const SEARCH_LINE& a, const SEARCH_LINE& b) { return a.score > b.score; });
+        report(found, depth);
+    }
+    this->m_stop = nullptr;
+}
+
+void Search::setParameters(const SEARCH_PARAMETERS& parameters) {
+    this->m_parameters = parameters;
+}
+
+void Search::clear() {
+    std::fill(this->m_table.begin(), this->m_table.end(), searchEntryHolder());
+    for (auto& killers : this->m_killers) {
+        killers[0] = Move();
+        killers[1] = Move();
+    }
+    std::memset(this->m_history, 0, sizeof(this->m_history));
+}
+
+// ----- Destruction -----
+
+Search::~Search() {}
@@ -0,0 +1,185 @@
+#include "Spsa.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "Datagen.h"
+#include "Threads.h"
+
+namespace {
+
+    // Values of the tunable parameters in Search::Tunable() order, kept unrounded between iterations
+    typedef std::vector<double> THETA;
+
+    // Reads "iteration" and "name value" lines, names not in the checkpoint keep their value
+    bool readCheckpoint(const std::string& path, THETA& theta, int& iteration) {
+        std::ifstream file(path);
+        if (!file) {
+            return false;
+        }
+        const std::vector<SEARCH_PARAMETER>& parameters = Search::Tunable();
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream stream(line);
+            std::string name;
+            double value;
+            if (!(stream >> name >> value)) {
+                continue;
+            }
+            if (name == "iteration") {
+                iteration = (int)value;
+                continue;
+            }
+            auto found = std::find_if(parameters.begin(), parameters.end(), [&](const SEARCH_PARAMETER& parameter) { return name == parameter.name; });
+            if (found == parameters.end()) {
+                std::cout << "Unknown parameter in checkpoint: " << name << std::endl;
+                return false;
+            }
+            theta[found - parameters.begin()] = std::clamp(value, (double)found->min, (double)found->max);
+        }
+        return true;
+    }
+
+    // Writes to a temporary file first so an interrupted write never loses the last checkpoint
+    bool writeCheckpoint(const std::string& path, const THETA& theta, int iteration) {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary);
+            if (!file) {
+                return false;
+            }
+            file << "iteration " << iteration << "\n";
+            const std::vector<SEARCH_PARAMETER>& parameters = Search::Tunable();
+            for (size_t i = 0; i < parameters.size(); i++) {
+                file << parameters[i].name << " " << theta[i] << "\n";
+            }
+            if (!file) {
+                return false;
+            }
+        }
+        // Replaces the last checkpoint, which std::rename does not do on Windows
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+
+    THETA defaults() {
+        SEARCH_PARAMETERS parameters;
+        THETA theta;
+        for (const SEARCH_PARAMETER& parameter : Search::Tunable()) {
+            theta.push_back(parameters.*parameter.value);
+        }
+        return theta;
+    }
+
+    SEARCH_PARAMETERS toParameters(const THETA& theta) {
+        SEARCH_PARAMETERS parameters;
+        const std::vector<SEARCH_PARAMETER>& tunable = Search::Tunable();
+        for (size_t i = 0; i < tunable.size(); i++) {
+            parameters.*tunable[i].value = std::clamp((int)std::lround(theta[i]), tunable[i].min, tunable[i].max);
+        }
+        return parameters;
+    }
+
+    // One search for each side on every worker, so no hash table is shared between threads or between the sides
+    typedef struct spsaWorkerHolder {
+        std::unique_ptr<Search> plus, minus;
+    } SPSA_WORKER;
+
+}
+
+bool Spsa::load(const std::string& checkpoint, SEARCH_PARAMETERS& parameters) {
+    THETA theta = ::defaults();
+    int iteration = 0;
+    if (!::readCheckpoint(checkpoint, theta, iteration)) {
+        std::cout << "Could not read checkpoint: " << checkpoint << std::endl;
+        return false;
+    }
+    parameters = ::toParameters(theta);
+    return true;
+}
+
+bool Spsa::run(const std::string& checkpoint, const SPSA_SETTINGS& settings, const Nnue* network, const Tablebase* tablebase, const DtmTablebase* dtm) {
+    const std::vector<SEARCH_PARAMETER>& tunable = Search::Tunable();
+    THETA theta = ::defaults();
+    int iteration = 0;
+    if (std::ifstream(checkpoint) && !::readCheckpoint(checkpoint, theta, iteration)) {
+        std::cout << "Could not read checkpoint: " << checkpoint << std::endl;
+        return false;
+    }
+    if (iteration > 0) {
+        std::cout << "Resuming from iteration " << iteration << std::endl;
+    }
+
+    int threads = std::max(settings.threads, 1);
+    std::vector<SPSA_WORKER> workers(threads);
+    for (SPSA_WORKER& worker : workers) {
+        worker.plus.reset(new Search(SEARCH_HASH_MEGABYTES, network));
+        worker.minus.reset(new Search(SEARCH_HASH_MEGABYTES, network));
+    }
+    int pairs = std::max(settings.pairs, 1);
+    // Steps stay large for the first tenth of the run, the usual choice for the stability constant
+    double stability = std::max(settings.iterations, 1) * 0.1;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int k = iteration + 1; k <= settings.iterations; k++) {
+        // Perturbations shrink slowly so late iterations still tell the sides apart
+        std::mt19937_64 random(settings.seed + (unsigned long long)k * pairs);
+        std::vector<double> signs(tunable.size()), perturbations(tunable.size());
+        THETA plus = theta, minus = theta;
+        for (size_t i = 0; i < tunable.size(); i++) {
+            signs[i] = (random() & 1 ? 1.0 : -1.0);
+            perturbations[i] = tunable[i].delta / std::pow(k, SPSA_GAMMA);
+            plus[i] = theta[i] + perturbations[i] * signs[i];
+            minus[i] = theta[i] - perturbations[i] * signs[i];
+        }
+        SEARCH_PARAMETERS plusParameters = ::toParameters(plus), minusParameters = ::toParameters(minus);
+
+        // Game 2i has the plus side as white and game 2i + 1 as black, both from the opening of pair i
+        std::vector<int> scores((size_t)pairs * 2);
+        Threads::parallelFor(scores.size(), threads, [&](size_t index, int thread) {
+            SPSA_WORKER& worker = workers[thread];
+            worker.plus->setParameters(plusParameters);
+            worker.minus->setParameters(minusParameters);
+            worker.plus->clear();
+            worker.minus->clear();
+
+            POSITION position;
+            std::vector<HASH> history;
+            Datagen::playOpening(settings.seed + (unsigned long long)k * pairs + index / 2, settings.randomPlies, position, history);
+            bool plusWhite = (index % 2 == 0);
+            Search& white = (plusWhite ? *worker.plus : *worker.minus);
+            Search& black = (plusWhite ? *worker.minus : *worker.plus);
+            FLAG result = Datagen::playGame(white, black, position, history, settings.limits, tablebase, dtm);
+            int score = (result == ARCHIVE_RESULT_WHITE ? 1 : (result == ARCHIVE_RESULT_BLACK ? -1 : 0));
+            scores[index] = (plusWhite ? score : -score);
+        });
+
+        int wins = (int)std::count(scores.begin(), scores.end(), 1);
+        int losses = (int)std::count(scores.begin(), scores.end(), -1);
+        int draws = (int)scores.size() - wins - losses;
+        double step = settings.rate / std::pow(k + stability, SPSA_ALPHA) * (wins - losses) / scores.size();
+        for (size_t i = 0; i < tunable.size(); i++) {
+            theta[i] = std::clamp(theta[i] + step * perturbations[i] * signs[i], (double)tunable[i].min, (double)tunable[i].max);
+        }
+
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        std::cout << "Iteration " << k << ": plus +" << wins << " -" << losses << " =" << draws << ", " << (int)time.count() << " seconds" << std::endl;
+        for (size_t i = 0; i < tunable.size(); i++) {
+            std::cout << "  " << tunable[i].name << " " << theta[i] << std::endl;
+        }
+        if (!::writeCheckpoint(checkpoint, theta, k)) {
+            std::cout << "Could not write checkpoint: " << checkpoint << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
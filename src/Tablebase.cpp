@@ -0,0 +1,1002 @@
+#include "Tablebase.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+#include "Attacks.h"
+#include "MappedFile.h"
+#include "MoveGen.h"
+#include "Piece.h"
+#include "Position.h"
+
+namespace {
+
+    // ----- Encoding ----- Generation -----
+
+    // Tables used to turn the squares of a position into its index in a table
+    typedef struct encodingHolder {
+        // Squares a2 to h7, edge files first, lowest ranks first within a file pair
+        int mapPawns[GRID_SIZE * GRID_SIZE];
+        // Squares below the a1-h8 diagonal
+        int mapB1H1H7[GRID_SIZE * GRID_SIZE];
+        // Squares in the a1-d1-d4 triangle, diagonal squares last
+        int mapA1D1D4[GRID_SIZE * GRID_SIZE];
+        // The 462 ways to place two kings with the first in the a1-d1-d4 triangle
+        int mapKK[10][GRID_SIZE * GRID_SIZE];
+        // Ways to choose k squares out of n
+        unsigned long long binomial[6][GRID_SIZE * GRID_SIZE];
+        int leadPawnIdx[6][GRID_SIZE * GRID_SIZE];
+        int leadPawnsSize[6][4];
+    } ENCODING;
+
+    // Positive above the a1-h8 diagonal, negative below it
+    constexpr int offA1H8(int square) {
+        return (square / GRID_SIZE) - (square % GRID_SIZE);
+    }
+
+    constexpr ENCODING generateEncoding() {
+        ENCODING encoding = {};
+
+        int code = 0;
+        for (int square = 0; square < GRID_SIZE * GRID_SIZE; square++) {
+            if (offA1H8(square) < 0) {
+                encoding.mapB1H1H7[square] = code++;
+            }
+        }
+
+        // Up to d4, only a-d files are in the triangle
+        int diagonal[4] = {};
+        int diagonals = 0;
+        code = 0;
+        for (int square = 0; square <= 3 * GRID_SIZE + 3; square++) {
+            if (offA1H8(square) < 0 && square % GRID_SIZE <= 3) {
+                encoding.mapA1D1D4[square] = code++;
+            }
+            else if (offA1H8(square) == 0 && square % GRID_SIZE <= 3) {
+                diagonal[diagonals++] = square;
+            }
+        }
+        for (int i = 0; i < diagonals; i++) {
+            encoding.mapA1D1D4[diagonal[i]] = code++;
+        }
+
+        // Kings cannot touch, and with the first on the diagonal the second cannot be above it
+        // Both kings on the diagonal come last
+        int bothIndex[GRID_SIZE * GRID_SIZE] = {};
+        int bothSquare[GRID_SIZE * GRID_SIZE] = {};
+        int both = 0;
+        code = 0;
+        for (int index = 0; index < 10; index++) {
+            for (int first = 0; first <= 3 * GRID_SIZE + 3; first++) {
+                // b1 is the only square mapped to 0
+                if (encoding.mapA1D1D4[first] != index || (index == 0 && first != 1)) {
+                    continue;
+                }
+                for (int second = 0; second < GRID_SIZE * GRID_SIZE; second++) {
+                    if (first == second || (Attacks::king.squares[first] & BITBOARD_INDEX(second))) {
+                        continue;
+                    }
+                    if (offA1H8(first) == 0 && offA1H8(second) > 0) {
+                        continue;
+                    }
+                    if (offA1H8(first) == 0 && offA1H8(second) == 0) {
+                        bothIndex[both] = index;
+                        bothSquare[both++] = second;
+                    }
+                    else {
+                        encoding.mapKK[index][second] = code++;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < both; i++) {
+            encoding.mapKK[bothIndex[i]][bothSquare[i]] = code++;
+        }
+
+        encoding.binomial[0][0] = 1;
+        for (int n = 1; n < GRID_SIZE * GRID_SIZE; n++) {
+            for (int k = 0; k < 6 && k <= n; k++) {
+                encoding.binomial[k][n] = (k > 0 ? encoding.binomial[k - 1][n - 1] : 0) + (k < n ? encoding.binomial[k][n - 1] : 0);
+            }
+        }
+
+        // Leading pawns are counted per file, since tables are split by the file of the leading pawn
+        int available = 47;
+        for (int count = 1; count <= 5; count++) {
+            for (int file = 0; file < 4; file++) {
+                int index = 0;
+                for (int rank = 1; rank < GRID_SIZE - 1; rank++) {
+                    int square = rank * GRID_SIZE + file;
+                    if (count == 1) {
+                        encoding.mapPawns[square] = available--;
+                        encoding.mapPawns[square ^ 7] = available--;
+                    }
+                    encoding.leadPawnIdx[count][square] = index;
+                    index += (int)encoding.binomial[count - 1][encoding.mapPawns[square]];
+                }
+                encoding.leadPawnsSize[count][file] = index;
+            }
+        }
+        return encoding;
+    }
+
+    constexpr ENCODING encoding = generateEncoding();
+
+    // ----- File ----- Data -----
+
+    // Decoding data for one side to move and leading pawn file of a table
+    typedef struct pairsDataHolder {
+        int flags;
+        int maxSymLen, minSymLen;
+        unsigned int numBlocks;
+        size_t blockSize;
+        // There is a sparse index entry about every span values
+        size_t span;
+        // Lowest symbol of each length, 16 bits each
+        const unsigned char* lowestSym;
+        // Left and right symbols each symbol expands to, 12 bits each
+        const unsigned char* btree;
+        // Number of values in each block minus one, 16 bits each
+        const unsigned char* blockLength;
+        size_t blockLengthSize;
+        // Block and offset in the block every span values, 6 bytes each
+        const unsigned char* sparseIndex;
+        size_t sparseIndexSize;
+        const unsigned char* data;
+        // Lowest symbol of each length padded to 64 bits
+        std::vector<unsigned long long> base64;
+        // Number of values each symbol stands for minus one
+        std::vector<unsigned char> symlen;
+        // Pieces in the order they are encoded, the order sets the groups
+        int pieces[TABLEBASE_MAX_PIECES];
+        unsigned long long groupIdx[TABLEBASE_MAX_PIECES + 1];
+        int groupLen[TABLEBASE_MAX_PIECES + 1];
+        // Where the DTZ values of wins, losses, cursed wins and blessed losses are mapped
+        int mapIdx[4];
+    } PAIRS_DATA;
+
+    // One .rtbw or .rtbz file, mapped the first time it is probed
+    typedef struct tablebaseTableHolder {
+        std::string path;
+        bool dtz;
+        std::atomic<bool> ready;
+        bool failed;
+        std::mutex lock;
+        MappedFile file;
+        const unsigned char* map;
+        // [side to move][leading pawn file]
+        PAIRS_DATA items[2][4];
+    } TABLEBASE_TABLE;
+
+}
+
+struct tablebaseMaterialHolder {
+    // Name with the side the table was generated for first, such as KRvK
+    std::string name;
+    bool symmetric;
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;
+    // Pawns of the leading colour then the other colour
+    int pawnCount[2];
+    TABLEBASE_TABLE wdl, dtz;
+};
+
+namespace {
+
+    // ----- File ----- Read -----
+
+    unsigned int readLE16(const unsigned char* data) {
+        return data[0] | (data[1] << 8);
+    }
+
+    unsigned int readLE32(const unsigned char* data) {
+        return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+    }
+
+    unsigned int readBE32(const unsigned char* data) {
+        return ((unsigned int)data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    }
+
+    unsigned long long readBE64(const unsigned char* data) {
+        return ((unsigned long long)::readBE32(data) << 32) | ::readBE32(data + 4);
+    }
+
+    int symbolLeft(const PAIRS_DATA& d, int symbol) {
+        const unsigned char* node = d.btree + 3 * symbol;
+        return ((node[1] & 0xF) << 8) | node[0];
+    }
+
+    int symbolRight(const PAIRS_DATA& d, int symbol) {
+        const unsigned char* node = d.btree + 3 * symbol;
+        return (node[2] << 4) | (node[1] >> 4);
+    }
+
+    PAIRS_DATA& getData(const tablebaseMaterialHolder& material, TABLEBASE_TABLE& table, int stm, int file) {
+        return table.items[table.dtz ? 0 : stm % 2][material.hasPawns ? file : 0];
+    }
+
+    int sign(int value) {
+        return (value > 0) - (value < 0);
+    }
+
+    // DTZ of the move before a capture or pawn move, which tables do not store
+    int dtzBeforeZeroing(int wdl) {
+        switch (wdl) {
+        case TABLEBASE_WIN:
+            return 1;
+        case TABLEBASE_CURSED_WIN:
+            return 101;
+        case TABLEBASE_BLESSED_LOSS:
+            return -101;
+        case TABLEBASE_LOSS:
+            return -1;
+        default:
+            return 0;
+        }
+    }
+
+    // Syzygy pieces are the type, plus 8 for black
+    int pieceCode(PIECE piece) {
+        return Piece::getFlag(piece, MASK_TYPE) | (Piece::getFlag(piece, MASK_COLOUR) == PIECE_BLACK ? 8 : 0);
+    }
+
+    bool isPiece(PIECE piece) {
+        FLAG type = Piece::getFlag(piece, MASK_TYPE);
+        return (type != PIECE_INVALID && type != PIECE_PHANTOM);
+    }
+
+    // Returns the material as a table name with white's pieces first, such as KRvK
+    std::string materialName(const PIECE* grid) {
+        const char letters[] = " PNBRQK";
+        std::string sides[2];
+        for (FLAG type = PIECE_KING; type >= PIECE_PAWN; type--) {
+            for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+                if (Piece::getFlag(grid[i], MASK_TYPE) == type) {
+                    sides[Piece::getFlag(grid[i], MASK_COLOUR) == PIECE_WHITE ? 0 : 1] += letters[type];
+                }
+            }
+        }
+        return sides[0] + "v" + sides[1];
+    }
+
+    bool pawnLess(int a, int b) {
+        return encoding.mapPawns[a] < encoding.mapPawns[b];
+    }
+
+    // ----- File ----- Setup -----
+
+    // Groups pieces that are encoded together, normally pieces of the same type and colour
+    // Without pawns the first group is three unique pieces, or the two kings if there are not enough
+    void setGroups(const tablebaseMaterialHolder& material, PAIRS_DATA& d, const int order[2], int file) {
+        int n = 0;
+        int firstLen = (material.hasPawns ? 0 : (material.hasUniquePieces ? 3 : 2));
+        d.groupLen[n] = 1;
+        for (int i = 1; i < material.pieceCount; i++) {
+            if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1]) {
+                d.groupLen[n]++;
+            }
+            else {
+                d.groupLen[++n] = 1;
+            }
+        }
+        d.groupLen[++n] = 0;
+
+        // Groups are encoded in the order the file gives, the leading group at order[0]
+        // and the other side's pawns at order[1]
+        bool bothPawns = (material.hasPawns && material.pawnCount[1]);
+        int next = (bothPawns ? 2 : 1);
+        int freeSquares = GRID_SIZE * GRID_SIZE - d.groupLen[0] - (bothPawns ? d.groupLen[1] : 0);
+        unsigned long long index = 1;
+        for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+            if (k == order[0]) {
+                d.groupIdx[0] = index;
+                index *= (material.hasPawns ? encoding.leadPawnsSize[d.groupLen[0]][file] : (material.hasUniquePieces ? 31332 : 462));
+            }
+            else if (k == order[1]) {
+                d.groupIdx[1] = index;
+                index *= encoding.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+            }
+            else {
+                d.groupIdx[next] = index;
+                index *= encoding.binomial[d.groupLen[next]][freeSquares];
+                freeSquares -= d.groupLen[next++];
+            }
+        }
+        d.groupIdx[n] = index;
+    }
+
+    // Symbols are pairs of smaller symbols, down to single values
+    int setSymlen(PAIRS_DATA& d, int symbol, std::vector<bool>& visited) {
+        visited[symbol] = true;
+        int right = ::symbolRight(d, symbol);
+        if (right == 0xFFF) {
+            return 0;
+        }
+        int left = ::symbolLeft(d, symbol);
+        if (!visited[left]) {
+            d.symlen[left] = (unsigned char)::setSymlen(d, left, visited);
+        }
+        if (!visited[right]) {
+            d.symlen[right] = (unsigned char)::setSymlen(d, right, visited);
+        }
+        return d.symlen[left] + d.symlen[right] + 1;
+    }
+
+    // Reads the Huffman code lengths and symbol tree
+    const unsigned char* setSizes(PAIRS_DATA& d, const unsigned char* data) {
+        d.flags = *data++;
+
+        // Whole table is one value, stored in place of the symbol length
+        if (d.flags & TABLEBASE_FLAG_SINGLE_VALUE) {
+            d.numBlocks = 0;
+            d.blockLengthSize = 0;
+            d.span = 0;
+            d.sparseIndexSize = 0;
+            d.minSymLen = *data++;
+            return data;
+        }
+
+        int groups = 0;
+        while (d.groupLen[groups]) {
+            groups++;
+        }
+        unsigned long long size = d.groupIdx[groups];
+
+        d.blockSize = (size_t)1 << *data++;
+        d.span = (size_t)1 << *data++;
+        d.sparseIndexSize = (size_t)((size + d.span - 1) / d.span);
+        int padding = *data++;
+        d.numBlocks = ::readLE32(data);
+        data += 4;
+        d.blockLengthSize = d.numBlocks + padding;
+        d.maxSymLen = *data++;
+        d.minSymLen = *data++;
+        d.lowestSym = data;
+
+        // Canonical Huffman codes, longer codes have lower values
+        d.base64.assign(d.maxSymLen - d.minSymLen + 1, 0);
+        for (int i = (int)d.base64.size() - 2; i >= 0; i--) {
+            d.base64[i] = (d.base64[i + 1] + ::readLE16(d.lowestSym + 2 * i) - ::readLE16(d.lowestSym + 2 * (i + 1))) / 2;
+        }
+        for (size_t i = 0; i < d.base64.size(); i++) {
+            d.base64[i] <<= 64 - i - d.minSymLen;
+        }
+        data += d.base64.size() * 2;
+
+        d.symlen.assign(::readLE16(data), 0);
+        data += 2;
+        d.btree = data;
+        std::vector<bool> visited(d.symlen.size());
+        for (size_t symbol = 0; symbol < d.symlen.size(); symbol++) {
+            if (!visited[symbol]) {
+                d.symlen[symbol] = (unsigned char)::setSymlen(d, (int)symbol, visited);
+            }
+        }
+        return data + d.symlen.size() * 3 + (d.symlen.size() & 1);
+    }
+
+    // DTZ values are stored by how often they occur, the map turns them back into distances
+    const unsigned char* setDtzMap(const tablebaseMaterialHolder& material, TABLEBASE_TABLE& table, const unsigned char* data, const unsigned char* base, int maxFile) {
+        table.map = data;
+        for (int file = 0; file <= maxFile; file++) {
+            PAIRS_DATA& d = ::getData(material, table, 0, file);
+            if (!(d.flags & TABLEBASE_FLAG_MAPPED)) {
+                continue;
+            }
+            if (d.flags & TABLEBASE_FLAG_WIDE) {
+                data += (data - base) & 1;
+                for (int i = 0; i < 4; i++) {
+                    d.mapIdx[i] = (int)((data - table.map) / 2 + 1);
+                    data += 2 * ::readLE16(data) + 2;
+                }
+            }
+            else {
+                for (int i = 0; i < 4; i++) {
+                    d.mapIdx[i] = (int)(data - table.map + 1);
+                    data += *data + 1;
+                }
+            }
+        }
+        return data + ((data - base) & 1);
+    }
+
+    // Points the table's decoding data into the mapped file
+    void setupTable(const tablebaseMaterialHolder& material, TABLEBASE_TABLE& table, const unsigned char* base) {
+        // Magic is skipped, then a byte of flags
+        const unsigned char* data = base + 5;
+        int sides = (!table.dtz && !material.symmetric ? 2 : 1);
+        int maxFile = (material.hasPawns ? 3 : 0);
+        bool bothPawns = (material.hasPawns && material.pawnCount[1]);
+
+        for (int file = 0; file <= maxFile; file++) {
+            for (int i = 0; i < sides; i++) {
+                ::getData(material, table, i, file) = PAIRS_DATA();
+            }
+            int order[2][2] = {
+                { data[0] & 0xF, (bothPawns ? data[1] & 0xF : 0xF) },
+                { data[0] >> 4, (bothPawns ? data[1] >> 4 : 0xF) }
+            };
+            data += 1 + bothPawns;
+
+            for (int k = 0; k < material.pieceCount; k++, data++) {
+                for (int i = 0; i < sides; i++) {
+                    ::getData(material, table, i, file).pieces[k] = (i ? *data >> 4 : *data & 0xF);
+                }
+            }
+            for (int i = 0; i < sides; i++) {
+                ::setGroups(material, ::getData(material, table, i, file), order[i], file);
+            }
+        }
+        data += (data - base) & 1;
+
+        for (int file = 0; file <= maxFile; file++) {
+            for (int i = 0; i < sides; i++) {
+                data = ::setSizes(::getData(material, table, i, file), data);
+            }
+        }
+        if (table.dtz) {
+            data = ::setDtzMap(material, table, data, base, maxFile);
+        }
+
+        for (int file = 0; file <= maxFile; file++) {
+            for (int i = 0; i < sides; i++) {
+                PAIRS_DATA& d = ::getData(material, table, i, file);
+                d.sparseIndex = data;
+                data += d.sparseIndexSize * 6;
+            }
+        }
+        for (int file = 0; file <= maxFile; file++) {
+            for (int i = 0; i < sides; i++) {
+                PAIRS_DATA& d = ::getData(material, table, i, file);
+                d.blockLength = data;
+                data += d.blockLengthSize * 2;
+            }
+        }
+        // Compressed blocks are 64 byte aligned
+        for (int file = 0; file <= maxFile; file++) {
+            for (int i = 0; i < sides; i++) {
+                PAIRS_DATA& d = ::getData(material, table, i, file);
+                data = base + (((data - base) + 0x3F) & ~(ptrdiff_t)0x3F);
+                d.data = data;
+                data += (size_t)d.numBlocks * d.blockSize;
+            }
+        }
+    }
+
+    // Maps the file on first use, other threads wait until it is ready
+    bool mapTable(const tablebaseMaterialHolder& material, TABLEBASE_TABLE& table) {
+        if (table.ready.load(std::memory_order_acquire)) {
+            return !table.failed;
+        }
+        std::lock_guard<std::mutex> guard(table.lock);
+        if (table.ready.load(std::memory_order_relaxed)) {
+            return !table.failed;
+        }
+
+        const unsigned char magics[2][4] = { { 0x71, 0xE8, 0x23, 0x5D }, { 0xD7, 0x66, 0x0C, 0xA5 } };
+        table.failed = true;
+        if (!table.path.empty() && table.file.open(table.path)) {
+            const unsigned char* data = (const unsigned char*)table.file.Data();
+            if (table.file.Size() % 64 == 16 && std::memcmp(data, magics[table.dtz], 4) == 0) {
+                ::setupTable(material, table, data);
+                table.failed = false;
+            }
+            else {
+                std::cout << "Corrupt tablebase file: " << table.path << std::endl;
+                table.file.close();
+            }
+        }
+        table.ready.store(true, std::memory_order_release);
+        return !table.failed;
+    }
+
+    // ----- File ----- Decode -----
+
+    // Returns the value stored at index, decompressing the one block that holds it
+    int decompress(const PAIRS_DATA& d, unsigned long long index) {
+        if (d.flags & TABLEBASE_FLAG_SINGLE_VALUE) {
+            return d.minSymLen;
+        }
+
+        // Sparse index gives the block and offset of a value near index, then blocks are walked to the right one
+        size_t k = (size_t)(index / d.span);
+        unsigned int block = ::readLE32(d.sparseIndex + 6 * k);
+        long long offset = ::readLE16(d.sparseIndex + 6 * k + 4);
+        offset += (long long)(index % d.span) - (long long)(d.span / 2);
+        while (offset < 0) {
+            offset += ::readLE16(d.blockLength + 2 * --block) + 1;
+        }
+        while (offset > ::readLE16(d.blockLength + 2 * block)) {
+            offset -= ::readLE16(d.blockLength + 2 * block++) + 1;
+        }
+
+        // Symbols are read from the start of the block until the one covering offset
+        const unsigned char* data = d.data + (unsigned long long)block * d.blockSize;
+        unsigned long long buffer = ::readBE64(data);
+        data += 8;
+        int bufferSize = 64;
+        int symbol;
+        while (true) {
+            int length = 0;
+            while (buffer < d.base64[length]) {
+                length++;
+            }
+            symbol = (unsigned short)((buffer - d.base64[length]) >> (64 - length - d.minSymLen));
+            symbol = (unsigned short)(symbol + ::readLE16(d.lowestSym + 2 * length));
+            if (offset < d.symlen[symbol] + 1) {
+                break;
+            }
+
+            offset -= d.symlen[symbol] + 1;
+            length += d.minSymLen;
+            buffer <<= length;
+            bufferSize -= length;
+            if (bufferSize <= 32) {
+                bufferSize += 32;
+                buffer |= (unsigned long long)::readBE32(data) << (64 - bufferSize);
+                data += 4;
+            }
+        }
+
+        // Symbol is expanded down the tree to the single value at offset
+        while (d.symlen[symbol]) {
+            int left = ::symbolLeft(d, symbol);
+            if (offset < d.symlen[left] + 1) {
+                symbol = left;
+            }
+            else {
+                offset -= d.symlen[left] + 1;
+                symbol = ::symbolRight(d, symbol);
+            }
+        }
+        return ::symbolLeft(d, symbol);
+    }
+
+    // Turns a stored DTZ value into plies
+    int mapScore(const tablebaseMaterialHolder& material, TABLEBASE_TABLE& table, int file, int value, int wdl) {
+        const int wdlMap[] = { 1, 3, 0, 2, 0 };
+        const PAIRS_DATA& d = ::getData(material, table, 0, file);
+        if (d.flags & TABLEBASE_FLAG_MAPPED) {
+            int index = d.mapIdx[wdlMap[wdl + 2]] + value;
+            value = (d.flags & TABLEBASE_FLAG_WIDE ? ::readLE16(table.map + 2 * index) : table.map[index]);
+        }
+
+        // Some tables store moves instead of plies
+        if ((wdl == TABLEBASE_WIN && !(d.flags & TABLEBASE_FLAG_WIN_PLIES)) || (wdl == TABLEBASE_LOSS && !(d.flags & TABLEBASE_FLAG_LOSS_PLIES)) ||
+            wdl == TABLEBASE_CURSED_WIN || wdl == TABLEBASE_BLESSED_LOSS) {
+            value *= 2;
+        }
+        return value + 1;
+    }
+
+}
+
+// ----- Creation -----
+
+Tablebase::Tablebase() {
+    this->m_maxPieces = 0;
+}
+
+int Tablebase::open(const std::string& paths) {
+    this->m_materials.clear();
+    this->m_lookup.clear();
+    this->m_maxPieces = 0;
+
+#ifdef _WIN32
+    const char separator = ';';
+#else
+    const char separator = ':';
+#endif
+
+    // Files are found by name, WDL and DTZ files can be in different directories
+    std::unordered_map<std::string, std::string> wdlFiles, dtzFiles;
+    size_t start = 0;
+    while (start <= paths.size()) {
+        size_t end = paths.find(separator, start);
+        end = (end == std::string::npos ? paths.size() : end);
+        std::error_code error;
+        std::filesystem::directory_iterator directory(paths.substr(start, end - start), error);
+        if (!error) {
+            for (const std::filesystem::directory_entry& entry : directory) {
+                std::string extension = entry.path().extension().string();
+                if (extension == ".rtbw") {
+                    wdlFiles[entry.path().stem().string()] = entry.path().string();
+                }
+                else if (extension == ".rtbz") {
+                    dtzFiles[entry.path().stem().string()] = entry.path().string();
+                }
+            }
+        }
+        start = end + 1;
+    }
+
+    for (std::pair<const std::string, std::string>& file : wdlFiles) {
+        const std::string& name = file.first;
+        size_t split = name.find('v');
+        if (split == std::string::npos || name.size() - 1 > TABLEBASE_MAX_PIECES || name.find_first_not_of("KQRBNPv") != std::string::npos) {
+            continue;
+        }
+        std::string sides[2] = { name.substr(0, split), name.substr(split + 1) };
+        if (std::count(sides[0].begin(), sides[0].end(), 'K') != 1 || std::count(sides[1].begin(), sides[1].end(), 'K') != 1) {
+            continue;
+        }
+
+        std::unique_ptr<tablebaseMaterialHolder> material(new tablebaseMaterialHolder());
+        material->name = name;
+        material->symmetric = (sides[0] == sides[1]);
+        material->pieceCount = (int)name.size() - 1;
+        material->hasPawns = (name.find('P') != std::string::npos);
+        material->hasUniquePieces = false;
+        for (std::string& side : sides) {
+            for (char piece : std::string("PNBRQ")) {
+                if (std::count(side.begin(), side.end(), piece) == 1) {
+                    material->hasUniquePieces = true;
+                }
+            }
+        }
+
+        // Leading colour is the one with fewer pawns, it compresses better
+        int pawns[2] = { (int)std::count(sides[0].begin(), sides[0].end(), 'P'), (int)std::count(sides[1].begin(), sides[1].end(), 'P') };
+        bool whiteLeads = (!pawns[1] || (pawns[0] && pawns[1] >= pawns[0]));
+        material->pawnCount[0] = pawns[whiteLeads ? 0 : 1];
+        material->pawnCount[1] = pawns[whiteLeads ? 1 : 0];
+
+        material->wdl.path = file.second;
+        material->wdl.dtz = false;
+        material->wdl.ready = false;
+        material->dtz.path = (dtzFiles.count(name) ? dtzFiles[name] : "");
+        material->dtz.dtz = true;
+        material->dtz.ready = false;
+
+        this->m_lookup[name] = material.get();
+        this->m_lookup[sides[1] + "v" + sides[0]] = material.get();
+        this->m_maxPieces = std::max(this->m_maxPieces, material->pieceCount);
+        this->m_materials.push_back(std::move(material));
+    }
+    return (int)this->m_materials.size();
+}
+
+// ----- Read -----
+
+int Tablebase::MaxPieces() const {
+    return this->m_maxPieces;
+}
+
+bool Tablebase::canProbe(const PIECE* grid) const {
+    int count = 0;
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        count += ::isPiece(grid[i]);
+    }
+    return (this->m_maxPieces > 0 && count <= this->m_maxPieces && Position::castlingRights(grid) == 0);
+}
+
+bool Tablebase::probeWDL(FLAG colour, const PIECE* grid, int& wdl) const {
+    if (!this->canProbe(grid)) {
+        return false;
+    }
+    int state = TABLEBASE_PROBE_OK;
+    wdl = this->search(colour, grid, false, state);
+    return (state != TABLEBASE_PROBE_FAIL);
+}
+
+bool Tablebase::probeDTZ(FLAG colour, const PIECE* grid, int& dtz) const {
+    if (!this->canProbe(grid)) {
+        return false;
+    }
+    int state = TABLEBASE_PROBE_OK;
+    dtz = this->searchDTZ(colour, grid, state);
+    return (state != TABLEBASE_PROBE_FAIL);
+}
+
+Move Tablebase::bestMove(FLAG colour, const PIECE* grid, int halfmoves, int& wdl) const {
+    if (!this->probeWDL(colour, grid, wdl)) {
+        return Move();
+    }
+
+    // Moves are ranked by result, counting the 50 move rule, then by DTZ
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    const int maxDTZ = 1 << 18;
+    Move best;
+    int bestRank = INT_MIN, bestDTZ = 0;
+    for (Move& move : MoveGen::generate(colour, grid, true)) {
+        bool zeroing = (move.isCapture() || Piece::getFlag(grid[move.Start()], MASK_TYPE) == PIECE_PAWN);
+        PIECE next[GRID_SIZE * GRID_SIZE];
+        std::memcpy(next, grid, sizeof(next));
+        Position::play(move, next);
+
+        int dtz = 0;
+        int state = TABLEBASE_PROBE_OK;
+        if (zeroing) {
+            dtz = ::dtzBeforeZeroing(-this->search(enemy, next, false, state));
+        }
+        else {
+            dtz = -this->searchDTZ(enemy, next, state);
+            dtz += ::sign(dtz);
+        }
+        if (state == TABLEBASE_PROBE_FAIL) {
+            return Move();
+        }
+        // Mating moves always come first
+        if (dtz == 2 && MoveGen::inCheck(enemy, next) && !MoveGen::hasLegalMove(enemy, next)) {
+            dtz = 1;
+        }
+
+        int rank = 0;
+        if (dtz > 0) {
+            rank = (dtz + halfmoves <= 99 ? maxDTZ : maxDTZ - (dtz + halfmoves));
+        }
+        else if (dtz < 0) {
+            rank = (-dtz * 2 + halfmoves < 100 ? -maxDTZ : -maxDTZ + (-dtz + halfmoves));
+        }
+        if (rank > bestRank || (rank == bestRank && dtz < bestDTZ)) {
+            best = move;
+            bestRank = rank;
+            bestDTZ = dtz;
+        }
+    }
+    return best;
+}
+
+// ----- Read ----- Hidden -----
+
+int Tablebase::probeTable(FLAG colour, const PIECE* grid, bool dtz, int wdl, int& state) const {
+    int squares[TABLEBASE_MAX_PIECES];
+    int pieces[TABLEBASE_MAX_PIECES];
+    int size = 0;
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        size += ::isPiece(grid[i]);
+    }
+    // Bare kings are always drawn
+    if (size == 2) {
+        return TABLEBASE_DRAW;
+    }
+
+    std::string name = ::materialName(grid);
+    std::unordered_map<std::string, tablebaseMaterialHolder*>::const_iterator found = this->m_lookup.find(name);
+    if (size > TABLEBASE_MAX_PIECES || found == this->m_lookup.end()) {
+        state = TABLEBASE_PROBE_FAIL;
+        return 0;
+    }
+    tablebaseMaterialHolder& material = *found->second;
+    TABLEBASE_TABLE& table = (dtz ? material.dtz : material.wdl);
+    if (!::mapTable(material, table)) {
+        state = TABLEBASE_PROBE_FAIL;
+        return 0;
+    }
+
+    // Tables are stored with the stronger side as white, and symmetric tables only with white to move
+    // Otherwise colours are swapped and the board is mirrored
+    bool flip = ((colour == PIECE_BLACK && material.symmetric) || name != material.name);
+    int flipColour = (flip ? 8 : 0);
+    int flipSquares = (flip ? 56 : 0);
+    int stm = (flip ? 1 : 0) ^ (colour == PIECE_BLACK ? 1 : 0);
+
+    // Pawn tables are split by the file of the leading pawn, the one nearest the edge and lowest
+    size = 0;
+    int leadPawns = 0;
+    int file = 0;
+    BITBOARD leadSquares = BITBOARD_EMPTY;
+    if (material.hasPawns) {
+        int lead = ::getData(material, table, 0, 0).pieces[0] ^ flipColour;
+        for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            if (::isPiece(grid[i]) && ::pieceCode(grid[i]) == lead) {
+                squares[size++] = i ^ flipSquares;
+                leadSquares |= BITBOARD_INDEX(i);
+            }
+        }
+        leadPawns = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawns, ::pawnLess));
+        file = std::min(squares[0] % GRID_SIZE, GRID_SIZE - 1 - squares[0] % GRID_SIZE);
+    }
+
+    // DTZ tables only store one side to move
+    if (dtz) {
+        int flags = ::getData(material, table, stm, file).flags;
+        if ((flags & TABLEBASE_FLAG_STM) != stm && !(material.symmetric && !material.hasPawns)) {
+            state = TABLEBASE_PROBE_CHANGE_STM;
+            return 0;
+        }
+    }
+
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        if (::isPiece(grid[i]) && !(leadSquares & BITBOARD_INDEX(i))) {
+            squares[size] = i ^ flipSquares;
+            pieces[size++] = ::pieceCode(grid[i]) ^ flipColour;
+        }
+    }
+    const PAIRS_DATA& d = ::getData(material, table, stm, file);
+
+    // Pieces are put in the order the table encodes them
+    for (int i = leadPawns; i < size - 1; i++) {
+        for (int j = i + 1; j < size; j++) {
+            if (d.pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // Leading piece is mirrored onto the a-d files
+    if (squares[0] % GRID_SIZE > 3) {
+        for (int i = 0; i < size; i++) {
+            squares[i] ^= 7;
+        }
+    }
+
+    unsigned long long index = 0;
+    if (material.hasPawns) {
+        index = encoding.leadPawnIdx[leadPawns][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawns, ::pawnLess);
+        for (int i = 1; i < leadPawns; i++) {
+            index += encoding.binomial[i][encoding.mapPawns[squares[i]]];
+        }
+    }
+    else {
+        // Without pawns the leading piece is also mirrored below rank 5, then below the a1-h8 diagonal
+        if (squares[0] / GRID_SIZE > 3) {
+            for (int i = 0; i < size; i++) {
+                squares[i] ^= 56;
+            }
+        }
+        for (int i = 0; i < d.groupLen[0]; i++) {
+            if (!::offA1H8(squares[i])) {
+                continue;
+            }
+            if (::offA1H8(squares[i]) > 0) {
+                for (int j = i; j < size; j++) {
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+            break;
+        }
+
+        // Three unique pieces are encoded together, otherwise just the kings
+        if (material.hasUniquePieces) {
+            int adjust1 = (squares[1] > squares[0]);
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (::offA1H8(squares[0])) {
+                index = ((unsigned long long)encoding.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            }
+            else if (::offA1H8(squares[1])) {
+                index = (6 * 63 + (squares[0] / GRID_SIZE) * 28 + encoding.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            }
+            else if (::offA1H8(squares[2])) {
+                index = 6 * 63 * 62 + 4 * 28 * 62 + (squares[0] / GRID_SIZE) * 7 * 28 + ((squares[1] / GRID_SIZE) - adjust1) * 28 + encoding.mapB1H1H7[squares[2]];
+            }
+            else {
+                index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + (squares[0] / GRID_SIZE) * 7 * 6 + ((squares[1] / GRID_SIZE) - adjust1) * 6 + ((squares[2] / GRID_SIZE) - adjust2);
+            }
+        }
+        else {
+            index = encoding.mapKK[encoding.mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // Remaining groups are encoded in ascending square order, skipping squares taken by earlier groups
+    index *= d.groupIdx[0];
+    int* groupSquares = squares + d.groupLen[0];
+    bool remainingPawns = (material.hasPawns && material.pawnCount[1]);
+    for (int next = 1; d.groupLen[next]; next++) {
+        std::stable_sort(groupSquares, groupSquares + d.groupLen[next]);
+        unsigned long long n = 0;
+        for (int i = 0; i < d.groupLen[next]; i++) {
+            int adjust = 0;
+            for (int* square = squares; square < groupSquares; square++) {
+                adjust += (groupSquares[i] > *square);
+            }
+            n += encoding.binomial[i + 1][groupSquares[i] - adjust - 8 * remainingPawns];
+        }
+        remainingPawns = false;
+        index += n * d.groupIdx[next];
+        groupSquares += d.groupLen[next];
+    }
+
+    int value = ::decompress(d, index);
+    return (dtz ? ::mapScore(material, table, file, value, wdl) : value - 2);
+}
+
+int Tablebase::search(FLAG colour, const PIECE* grid, bool zeroing, int& state) const {
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    int best = TABLEBASE_LOSS;
+    std::vector<Move> moves = MoveGen::generate(colour, grid, true);
+    size_t searched = 0;
+    for (Move& move : moves) {
+        if (!move.isCapture() && (!zeroing || Piece::getFlag(grid[move.Start()], MASK_TYPE) != PIECE_PAWN)) {
+            continue;
+        }
+        searched++;
+
+        PIECE next[GRID_SIZE * GRID_SIZE];
+        std::memcpy(next, grid, sizeof(next));
+        Position::play(move, next);
+        int value = -this->search(enemy, next, false, state);
+        if (state == TABLEBASE_PROBE_FAIL) {
+            return TABLEBASE_DRAW;
+        }
+        if (value > best) {
+            best = value;
+            if (value >= TABLEBASE_WIN) {
+                state = TABLEBASE_PROBE_ZEROING;
+                return value;
+            }
+        }
+    }
+
+    // Table is wrong when only these moves were possible, such as en passant which tables know nothing of
+    bool allSearched = (searched && searched == moves.size());
+    int value = best;
+    if (!allSearched) {
+        value = this->probeTable(colour, grid, false, TABLEBASE_DRAW, state);
+        if (state == TABLEBASE_PROBE_FAIL) {
+            return TABLEBASE_DRAW;
+        }
+    }
+
+    if (best >= value) {
+        state = (best > TABLEBASE_DRAW || allSearched ? TABLEBASE_PROBE_ZEROING : TABLEBASE_PROBE_OK);
+        return best;
+    }
+    state = TABLEBASE_PROBE_OK;
+    return value;
+}
+
+int Tablebase::searchDTZ(FLAG colour, const PIECE* grid, int& state) const {
+    state = TABLEBASE_PROBE_OK;
+    int wdl = this->search(colour, grid, true, state);
+    // Draws are not stored
+    if (state == TABLEBASE_PROBE_FAIL || wdl == TABLEBASE_DRAW) {
+        return 0;
+    }
+    if (state == TABLEBASE_PROBE_ZEROING) {
+        return ::dtzBeforeZeroing(wdl);
+    }
+
+    int dtz = this->probeTable(colour, grid, true, wdl, state);
+    if (state == TABLEBASE_PROBE_FAIL) {
+        return 0;
+    }
+    if (state != TABLEBASE_PROBE_CHANGE_STM) {
+        bool cursed = (wdl == TABLEBASE_BLESSED_LOSS || wdl == TABLEBASE_CURSED_WIN);
+        return (dtz + (cursed ? 100 : 0)) * ::sign(wdl);
+    }
+
+    // Table only has the other side to move, so the best reply is found one ply down
+    FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+    int minDTZ = 0xFFFF;
+    for (Move& move : MoveGen::generate(colour, grid, true)) {
+        bool zeroing = (move.isCapture() || Piece::getFlag(grid[move.Start()], MASK_TYPE) == PIECE_PAWN);
+        PIECE next[GRID_SIZE * GRID_SIZE];
+        std::memcpy(next, grid, sizeof(next));
+        Position::play(move, next);
+
+        // Zeroing moves need the DTZ before they are played
+        int value = (zeroing ? -::dtzBeforeZeroing(this->search(enemy, next, false, state)) : -this->searchDTZ(enemy, next, state));
+        if (value == 1 && MoveGen::inCheck(enemy, next) && !MoveGen::hasLegalMove(enemy, next)) {
+            minDTZ = 1;
+        }
+        if (!zeroing) {
+            value += ::sign(value);
+        }
+        if (value < minDTZ && ::sign(value) == ::sign(wdl)) {
+            minDTZ = value;
+        }
+        if (state == TABLEBASE_PROBE_FAIL) {
+            return 0;
+        }
+    }
+    // No legal moves is mate
+    return (minDTZ == 0xFFFF ? -1 : minDTZ);
+}
+
+// ----- Destruction -----
+
+Tablebase::~Tablebase() {
+    // Nothing todo
+}
@@ -0,0 +1,37 @@
+#include "Threads.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+int Threads::available() {
+    int threads = (int)std::thread::hardware_concurrency();
+    return (threads > 0 ? threads : 1);
+}
+
+void Threads::parallelFor(size_t count, int threads, const std::function<void(size_t, int)>& work) {
+    if (threads < 1) {
+        threads = 1;
+    }
+    if ((size_t)threads > count) {
+        threads = (int)count;
+    }
+
+    // Each worker takes the next index until there are none left
+    std::atomic<size_t> next(0);
+    auto worker = [&](int thread) {
+        for (size_t i = next++; i < count; i = next++) {
+            work(i, thread);
+        }
+    };
+
+    // Calling thread works as well instead of waiting
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+}
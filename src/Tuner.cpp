@@ -0,0 +1,313 @@
+#include "Tuner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Datagen.h"
+#include "Evaluation.h"
+#include "EvaluationWeights.h"
+#include "MappedFile.h"
+#include "Piece.h"
+#include "Threads.h"
+
+namespace {
+
+    // Set on the pieces of black, which count against white
+    constexpr unsigned short blackPiece = 0x8000;
+    constexpr double scoreToExponent = 2.302585092994046 / 400.0;
+
+    // Every position as the list of its pieces, so an epoch never looks at a board
+    typedef struct tuneDataHolder {
+        size_t count = 0;
+        // Pieces of position i are pieces[offsets[i]] up to pieces[offsets[i + 1]]
+        // Each is its type from 0 times 64 plus its square from its own side, black pieces also have blackPiece set
+        std::vector<unsigned int> offsets;
+        std::vector<unsigned short> pieces;
+        std::vector<unsigned char> phases;
+        // Result and search score from white's side, 1 for a white win down to 0 for a black win
+        std::vector<float> results;
+        std::vector<short> scores;
+        // What the evaluation is fitted to, a blend of result and score
+        std::vector<float> targets;
+    } TUNE_DATA;
+
+    // Middlegame weights then endgame weights
+    typedef std::vector<double> WEIGHTS;
+
+    double sigmoid(double scale, double score) {
+        return 1.0 / (1.0 + std::exp(-scale * score * scoreToExponent));
+    }
+
+    // Linear in the weights, the same sum as Evaluation::evaluate for white without the rounding
+    double evaluate(const TUNE_DATA& data, size_t position, const WEIGHTS& weights) {
+        double stages[2] = { 0.0, 0.0 };
+        for (unsigned int i = data.offsets[position]; i < data.offsets[position + 1]; i++) {
+            unsigned short piece = data.pieces[i];
+            int square = piece & ~blackPiece;
+            double sign = (piece & blackPiece ? -1.0 : 1.0);
+            for (int stage = 0; stage < 2; stage++) {
+                const double* stageWeights = weights.data() + stage * TUNE_WEIGHTS;
+                stages[stage] += sign * (stageWeights[square / (GRID_SIZE * GRID_SIZE)] + stageWeights[6 + square]);
+            }
+        }
+        double phase = data.phases[position];
+        return (stages[0] * phase + stages[1] * (EVALUATION_PHASE_MAX - phase)) / EVALUATION_PHASE_MAX;
+    }
+
+    // Reads every record, positions are counted from the occupancy bytes first so blocks can fill their own part
+    bool load(const std::string& path, int threads, TUNE_DATA& data) {
+        MappedFile file;
+        if (!file.open(path)) {
+            std::cout << "Could not open file: " << path << std::endl;
+            return false;
+        }
+        if (file.Size() % PACKED_SIZE) {
+            std::cout << "File is not a whole number of records: " << path << std::endl;
+            return false;
+        }
+        const PACKED_POSITION* records = (const PACKED_POSITION*)file.Data();
+        data.count = file.Size() / PACKED_SIZE;
+        data.offsets.resize(data.count + 1);
+        data.offsets[0] = 0;
+        for (size_t i = 0; i < data.count; i++) {
+            int pieces = 0;
+            for (int j = 0; j < 8; j++) {
+                pieces += __builtin_popcount(records[i].data[PACKED_OCCUPANCY + j]);
+            }
+            data.offsets[i + 1] = data.offsets[i] + pieces;
+        }
+        data.pieces.resize(data.offsets[data.count]);
+        data.phases.resize(data.count);
+        data.results.resize(data.count);
+        data.scores.resize(data.count);
+
+        std::vector<char> valid(data.count, true);
+        size_t blocks = (data.count + TUNE_BLOCK_SIZE - 1) / TUNE_BLOCK_SIZE;
+        Threads::parallelFor(blocks, threads, [&](size_t block, int) {
+            size_t end = std::min(data.count, (block + 1) * TUNE_BLOCK_SIZE);
+            for (size_t i = block * TUNE_BLOCK_SIZE; i < end; i++) {
+                POSITION position;
+                int score = 0;
+                FLAG result = ARCHIVE_RESULT_NONE;
+                if (!Datagen::read(records[i], position, score, result)) {
+                    valid[i] = false;
+                    continue;
+                }
+                unsigned int piece = data.offsets[i];
+                for (INDEX j = 0; j < GRID_SIZE * GRID_SIZE; j++) {
+                    FLAG type = Piece::getFlag(position.grid[j], MASK_TYPE);
+                    if (type < PIECE_PAWN || type > PIECE_KING) {
+                        continue;
+                    }
+                    bool white = (Piece::getFlag(position.grid[j], MASK_COLOUR) == PIECE_WHITE);
+                    INDEX square = (white ? j : j ^ (GRID_SIZE * (GRID_SIZE - 1)));
+                    data.pieces[piece++] = (unsigned short)((type - PIECE_PAWN) * GRID_SIZE * GRID_SIZE + square) | (white ? 0 : blackPiece);
+                }
+                data.phases[i] = (unsigned char)std::min(Evaluation::phase(position.grid), EVALUATION_PHASE_MAX);
+                data.results[i] = (result == ARCHIVE_RESULT_WHITE ? 1.0f : result == ARCHIVE_RESULT_BLACK ? 0.0f : 0.5f);
+                data.scores[i] = (short)(position.colour == PIECE_WHITE ? score : -score);
+            }
+        });
+
+        for (size_t i = 0; i < data.count; i++) {
+            if (!valid[i]) {
+                std::cout << "Record " << i << " in " << path << " is not valid" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Mean squared error of the sigmoid of each evaluation against the results, summed across threads
+    double error(const TUNE_DATA& data, const WEIGHTS& weights, double scale, int threads) {
+        std::vector<double> sums(std::max(threads, 1), 0.0);
+        size_t blocks = (data.count + TUNE_BLOCK_SIZE - 1) / TUNE_BLOCK_SIZE;
+        Threads::parallelFor(blocks, threads, [&](size_t block, int thread) {
+            size_t end = std::min(data.count, (block + 1) * TUNE_BLOCK_SIZE);
+            double sum = 0.0;
+            for (size_t i = block * TUNE_BLOCK_SIZE; i < end; i++) {
+                double difference = data.results[i] - ::sigmoid(scale, ::evaluate(data, i, weights));
+                sum += difference * difference;
+            }
+            sums[thread] += sum;
+        });
+        double total = 0.0;
+        for (double sum : sums) {
+            total += sum;
+        }
+        return total / data.count;
+    }
+
+    // Scale turning centipawns into expected results, found by golden section search since the error has one minimum
+    // Each step keeps one of the two inner points, so only one error is calculated per step
+    double fitScale(const TUNE_DATA& data, const WEIGHTS& weights, int threads) {
+        const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+        double low = 0.0, high = 4.0;
+        double first = high - ratio * (high - low), second = low + ratio * (high - low);
+        double firstError = ::error(data, weights, first, threads), secondError = ::error(data, weights, second, threads);
+        for (int i = 0; i < 24; i++) {
+            if (firstError < secondError) {
+                high = second;
+                second = first;
+                secondError = firstError;
+                first = high - ratio * (high - low);
+                firstError = ::error(data, weights, first, threads);
+            }
+            else {
+                low = first;
+                first = second;
+                firstError = secondError;
+                second = low + ratio * (high - low);
+                secondError = ::error(data, weights, second, threads);
+            }
+        }
+        return (low + high) / 2.0;
+    }
+
+    // Adds the gradient of the mean squared error against the targets to gradients, returns the error
+    double gradient(const TUNE_DATA& data, const WEIGHTS& weights, double scale, int threads, WEIGHTS& gradients) {
+        std::vector<WEIGHTS> threadGradients(std::max(threads, 1), WEIGHTS(2 * TUNE_WEIGHTS, 0.0));
+        std::vector<double> sums(std::max(threads, 1), 0.0);
+        size_t blocks = (data.count + TUNE_BLOCK_SIZE - 1) / TUNE_BLOCK_SIZE;
+        Threads::parallelFor(blocks, threads, [&](size_t block, int thread) {
+            double* sum = threadGradients[thread].data();
+            size_t end = std::min(data.count, (block + 1) * TUNE_BLOCK_SIZE);
+            for (size_t i = block * TUNE_BLOCK_SIZE; i < end; i++) {
+                double expected = ::sigmoid(scale, ::evaluate(data, i, weights));
+                double difference = expected - data.targets[i];
+                sums[thread] += difference * difference;
+
+                // Chain rule through the sigmoid, then each weight's share of the phase blend
+                double slope = 2.0 * difference * expected * (1.0 - expected) * scale * scoreToExponent;
+                double phase = data.phases[i];
+                double stageSlopes[2] = { slope * phase / EVALUATION_PHASE_MAX, slope * (EVALUATION_PHASE_MAX - phase) / EVALUATION_PHASE_MAX };
+                for (unsigned int j = data.offsets[i]; j < data.offsets[i + 1]; j++) {
+                    unsigned short piece = data.pieces[j];
+                    int square = piece & ~blackPiece;
+                    double sign = (piece & blackPiece ? -1.0 : 1.0);
+                    for (int stage = 0; stage < 2; stage++) {
+                        double* stageSum = sum + stage * TUNE_WEIGHTS;
+                        stageSum[square / (GRID_SIZE * GRID_SIZE)] += sign * stageSlopes[stage];
+                        stageSum[6 + square] += sign * stageSlopes[stage];
+                    }
+                }
+            }
+        });
+
+        double total = 0.0;
+        for (size_t thread = 0; thread < threadGradients.size(); thread++) {
+            for (int i = 0; i < 2 * TUNE_WEIGHTS; i++) {
+                gradients[i] += threadGradients[thread][i] / data.count;
+            }
+            total += sums[thread];
+        }
+        return total / data.count;
+    }
+
+    bool writeWeights(const std::string& path, const WEIGHTS& weights, size_t positions) {
+        std::ofstream file(path);
+        if (!file) {
+            std::cout << "Could not open output: " << path << std::endl;
+            return false;
+        }
+        auto value = [&](int stage, int index) {
+            return (int)std::lround(std::clamp(weights[stage * TUNE_WEIGHTS + index], -32768.0, 32767.0));
+        };
+        const char* names[6] = { "Pawn", "Knight", "Bishop", "Rook", "Queen", "King" };
+
+        file << "#pragma once\n\n";
+        file << "// Evaluation weights in centipawns, middlegame values first then endgame values\n";
+        file << "// Piece types are in PIECE_PAWN to PIECE_KING order, squares in index order from white's side with a1 first\n";
+        file << "// Black reads the squares flipped, tune writes a new copy of this file from datagen records\n";
+        file << "// Written by tune from " << positions << " positions\n\n";
+        file << "constexpr short evaluationMaterial[2][6] = {\n";
+        for (int stage = 0; stage < 2; stage++) {
+            file << "    {";
+            for (int piece = 0; piece < 6; piece++) {
+                file << " " << value(stage, piece) << (piece < 5 ? "," : " ");
+            }
+            file << "},\n";
+        }
+        file << "};\n\n";
+        file << "constexpr short evaluationSquares[2][6][64] = {\n";
+        for (int stage = 0; stage < 2; stage++) {
+            file << "    {\n";
+            for (int piece = 0; piece < 6; piece++) {
+                file << "        // " << names[piece] << "\n        {\n";
+                for (int rank = 0; rank < GRID_SIZE; rank++) {
+                    file << "            ";
+                    for (int x = 0; x < GRID_SIZE; x++) {
+                        file << std::setw(4) << value(stage, 6 + piece * GRID_SIZE * GRID_SIZE + rank * GRID_SIZE + x) << (x + 1 < GRID_SIZE ? ", " : ",\n");
+                    }
+                }
+                file << "        },\n";
+            }
+            file << "    },\n";
+        }
+        file << "};\n";
+        return (bool)file;
+    }
+
+}
+
+bool Tuner::run(const std::string& data, const std::string& output, const TUNE_SETTINGS& settings) {
+    auto start = std::chrono::steady_clock::now();
+    TUNE_DATA positions;
+    if (!::load(data, settings.threads, positions)) {
+        return false;
+    }
+    if (positions.count == 0) {
+        std::cout << "No positions in " << data << std::endl;
+        return false;
+    }
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    std::cout << "Positions: " << positions.count << ", loaded in " << time.count() << "s" << std::endl;
+
+    // Starts from the weights compiled in
+    WEIGHTS weights(2 * TUNE_WEIGHTS);
+    for (int stage = 0; stage < 2; stage++) {
+        for (int piece = 0; piece < 6; piece++) {
+            weights[stage * TUNE_WEIGHTS + piece] = evaluationMaterial[stage][piece];
+            for (int square = 0; square < GRID_SIZE * GRID_SIZE; square++) {
+                weights[stage * TUNE_WEIGHTS + 6 + piece * GRID_SIZE * GRID_SIZE + square] = evaluationSquares[stage][piece][square];
+            }
+        }
+    }
+
+    double scale = ::fitScale(positions, weights, settings.threads);
+    std::cout << "Scale: " << scale << ", error " << ::error(positions, weights, scale, settings.threads) << std::endl;
+    positions.targets.resize(positions.count);
+    for (size_t i = 0; i < positions.count; i++) {
+        positions.targets[i] = (float)(settings.lambda * ::sigmoid(scale, positions.scores[i]) + (1.0 - settings.lambda) * positions.results[i]);
+    }
+
+    // Adam keeps a running mean and variance of each gradient, so rarely seen squares still move
+    WEIGHTS mean(2 * TUNE_WEIGHTS, 0.0), variance(2 * TUNE_WEIGHTS, 0.0);
+    start = std::chrono::steady_clock::now();
+    for (int epoch = 1; epoch <= settings.epochs; epoch++) {
+        WEIGHTS gradients(2 * TUNE_WEIGHTS, 0.0);
+        double loss = ::gradient(positions, weights, scale, settings.threads, gradients);
+        double meanCorrection = 1.0 - std::pow(TUNE_BETA1, epoch);
+        double varianceCorrection = 1.0 - std::pow(TUNE_BETA2, epoch);
+        for (int i = 0; i < 2 * TUNE_WEIGHTS; i++) {
+            mean[i] = TUNE_BETA1 * mean[i] + (1.0 - TUNE_BETA1) * gradients[i];
+            variance[i] = TUNE_BETA2 * variance[i] + (1.0 - TUNE_BETA2) * gradients[i] * gradients[i];
+            weights[i] -= settings.rate * (mean[i] / meanCorrection) / (std::sqrt(variance[i] / varianceCorrection) + 1e-12);
+        }
+        if (epoch == 1 || epoch % 10 == 0 || epoch == settings.epochs) {
+            time = std::chrono::steady_clock::now() - start;
+            std::cout << "Epoch " << epoch << ": error " << loss << ", " << time.count() / epoch << "s per epoch" << std::endl;
+        }
+    }
+
+    if (!::writeWeights(output, weights, positions.count)) {
+        return false;
+    }
+    std::cout << "Weights written to " << output << std::endl;
+    return true;
+}
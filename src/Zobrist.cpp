@@ -0,0 +1,52 @@
+#include "Zobrist.h"
+
+#include "Attacks.h"
+#include "Piece.h"
+#include "Position.h"
+
+int Zobrist::pieceKey(PIECE piece, INDEX index) {
+    // Black pieces come first for each type
+    int kind = 2 * (Piece::getFlag(piece, MASK_TYPE) - PIECE_PAWN) + (Piece::getFlag(piece, MASK_COLOUR) == PIECE_WHITE ? 1 : 0);
+    return (GRID_SIZE * GRID_SIZE * kind) + index;
+}
+
+HASH Zobrist::hash(FLAG colour, const PIECE* grid, const KEY_TABLE& table) {
+    HASH hash = 0;
+
+    // Pieces
+    for (INDEX i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        FLAG type = Piece::getFlag(grid[i], MASK_TYPE);
+        if (type == PIECE_INVALID || type == PIECE_PHANTOM) {
+            continue;
+        }
+        hash ^= table.keys[Zobrist::pieceKey(grid[i], i)];
+    }
+
+    // Castling, polyglot order is white kingside and queenside then black
+    FLAG rights = Position::castlingRights(grid);
+    const int castlingOrder[4] = { BOARD_CASTLING_WHITE_KING, BOARD_CASTLING_WHITE_QUEEN, BOARD_CASTLING_BLACK_KING, BOARD_CASTLING_BLACK_QUEEN };
+    for (int i = 0; i < 4; i++) {
+        if (rights & (1 << castlingOrder[i])) {
+            hash ^= table.keys[ZOBRIST_CASTLING + i];
+        }
+    }
+
+    // En passant only counts if a pawn is next to the enemy pawn to capture it
+    INDEX phantom = Position::findPhantom(colour, grid);
+    if (phantom != CODE_INVALID) {
+        FLAG enemy = (colour == PIECE_WHITE ? PIECE_BLACK : PIECE_WHITE);
+        BITBOARD attackers = Attacks::pawn(enemy, phantom);
+        while (attackers) {
+            PIECE piece = grid[Attacks::popLowest(attackers)];
+            if (Piece::getFlag(piece, MASK_TYPE) == PIECE_PAWN && Piece::getFlag(piece, MASK_COLOUR) == colour) {
+                hash ^= table.keys[ZOBRIST_EN_PASSANT + (phantom % GRID_SIZE)];
+                break;
+            }
+        }
+    }
+
+    if (colour == PIECE_WHITE) {
+        hash ^= table.keys[ZOBRIST_TURN];
+    }
+    return hash;
+}
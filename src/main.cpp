@@ -7,13 +7,19 @@
 #include "WindowManager.h"
 #include "EventManager.h"
 #include "FpsTracker.h"
+#include "Console.h"
 
 // Need to add
 // Stalemate with only knight/bishop - insufficient materials
 // 50 move rule implementation
 // 3-fold repitition
 
-int main(void) {
+int main(int argc, char** argv) {
+    // Runs a console command instead of opening the window if one is given
+    if (argc > 1) {
+        return Console::run(argc, argv);
+    }
+
     // Window initialization functions
     WindowManager::init(WINDOW_SIZE_REGULAR);
     WindowManager::initCallbacks();
@@ -37,6 +43,7 @@ int main(void) {
 
         // Checks for any actions needed to be taken
         events.manageEvents();
+        board.playBot();
 
         // OpenGL functions
         WindowManager::show();